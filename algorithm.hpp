@@ -0,0 +1,374 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <numeric>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#include "iterator.hpp"
+#include "thread_pool.hpp"
+
+
+#if defined(__clang__)
+#define CTL_UNSEQ_LOOP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define CTL_UNSEQ_LOOP _Pragma("GCC ivdep")
+#else
+#define CTL_UNSEQ_LOOP
+#endif
+
+
+namespace ctl {
+
+/**
+ * ctl::execution Definition
+ *
+ * Mirrors the C++17 execution policies so code written against ctl keeps
+ * compiling under C++14. seq runs the plain std algorithm; par and par_unseq
+ * run on ThreadPool::instance(), element-wise algorithms through
+ * parallel_for and order-dependent ones over fixed blocks. Unlike
+ * std::execution, an exception thrown by an element function is propagated
+ * to the caller once all blocks have finished instead of calling terminate.
+ */
+
+namespace execution {
+
+struct sequenced_policy {};
+struct parallel_policy {};
+struct parallel_unsequenced_policy {};
+
+constexpr sequenced_policy seq{};
+constexpr parallel_policy par{};
+constexpr parallel_unsequenced_policy par_unseq{};
+
+} // namespace execution
+
+template<typename T>
+struct is_execution_policy : std::false_type {};
+template<>
+struct is_execution_policy<execution::sequenced_policy> : std::true_type {};
+template<>
+struct is_execution_policy<execution::parallel_policy> : std::true_type {};
+template<>
+struct is_execution_policy<execution::parallel_unsequenced_policy> : std::true_type {};
+
+
+namespace detail {
+
+template<typename Policy, typename R = void>
+using enable_if_policy = typename std::enable_if< is_execution_policy<typename std::decay<Policy>::type>::value, R >::type;
+
+template<typename Policy>
+using is_sequenced = std::is_same<typename std::decay<Policy>::type, execution::sequenced_policy>;
+
+template<typename Policy>
+using loop_policy = typename std::conditional<
+    std::is_same<typename std::decay<Policy>::type, execution::parallel_unsequenced_policy>::value,
+    execution::parallel_unsequenced_policy,
+    execution::parallel_policy
+  >::type;
+
+constexpr std::size_t parallel_grain = 2048;
+
+inline std::size_t block_count(std::size_t n)
+{
+  std::size_t blocks = (n + parallel_grain - 1) / parallel_grain;
+  return std::max<std::size_t>(std::min(blocks, ThreadPool::instance().size() * 4), 1);
+}
+
+inline std::size_t block_bound(std::size_t n, std::size_t blocks, std::size_t b)
+{
+  return n / blocks * b + std::min(b, n % blocks);
+}
+
+/**
+ * Calls body(b, first, last) for every block b of [0, n), the first block
+ * on the calling thread and the rest on the pool.
+ */
+template<typename F>
+void for_blocks(std::size_t n, std::size_t blocks, F&& body)
+{
+  if (blocks <= 1) {
+    body(std::size_t(0), std::size_t(0), n);
+    return;
+  }
+  TaskGroup group;
+  for (std::size_t b = 1; b < blocks; ++b) {
+    group.run([&body, n, blocks, b]() {
+      body(b, block_bound(n, blocks, b), block_bound(n, blocks, b + 1));
+    });
+  }
+  body(std::size_t(0), std::size_t(0), block_bound(n, blocks, 1));
+  group.wait();
+}
+
+template<typename RandomIt, typename F>
+void apply(execution::parallel_policy, RandomIt first, std::ptrdiff_t n, F& f)
+{
+  for (std::ptrdiff_t i = 0; i < n; ++i) {
+    f(first[i]);
+  }
+}
+
+template<typename RandomIt, typename F>
+void apply(execution::parallel_unsequenced_policy, RandomIt first, std::ptrdiff_t n, F& f)
+{
+  CTL_UNSEQ_LOOP
+  for (std::ptrdiff_t i = 0; i < n; ++i) {
+    f(first[i]);
+  }
+}
+
+template<typename RandomIt, typename OutputIt, typename F>
+void apply(execution::parallel_policy, RandomIt first, std::ptrdiff_t n, OutputIt out, F& f)
+{
+  for (std::ptrdiff_t i = 0; i < n; ++i) {
+    out[i] = f(first[i]);
+  }
+}
+
+template<typename RandomIt, typename OutputIt, typename F>
+void apply(execution::parallel_unsequenced_policy, RandomIt first, std::ptrdiff_t n, OutputIt out, F& f)
+{
+  CTL_UNSEQ_LOOP
+  for (std::ptrdiff_t i = 0; i < n; ++i) {
+    out[i] = f(first[i]);
+  }
+}
+
+template<typename RandomIt1, typename RandomIt2, typename OutputIt, typename F>
+void apply(execution::parallel_policy, RandomIt1 first1, std::ptrdiff_t n, RandomIt2 first2, OutputIt out, F& f)
+{
+  for (std::ptrdiff_t i = 0; i < n; ++i) {
+    out[i] = f(first1[i], first2[i]);
+  }
+}
+
+template<typename RandomIt1, typename RandomIt2, typename OutputIt, typename F>
+void apply(execution::parallel_unsequenced_policy, RandomIt1 first1, std::ptrdiff_t n, RandomIt2 first2, OutputIt out, F& f)
+{
+  CTL_UNSEQ_LOOP
+  for (std::ptrdiff_t i = 0; i < n; ++i) {
+    out[i] = f(first1[i], first2[i]);
+  }
+}
+
+template<typename RandomIt, typename Compare, typename Sort>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp, Sort sort)
+{
+  const std::size_t n = last - first;
+  const std::size_t blocks = block_count(n);
+
+  for_blocks(n, blocks, [&](std::size_t, std::size_t lo, std::size_t hi) {
+    sort(first + lo, first + hi, comp);
+  });
+
+  for (std::size_t width = 1; width < blocks; width *= 2) {
+    const std::size_t pairs = (blocks + 2 * width - 1) / (2 * width);
+    for_blocks(pairs, pairs, [&](std::size_t, std::size_t pair, std::size_t) {
+      std::size_t left = pair * 2 * width;
+      std::size_t middle = std::min(left + width, blocks);
+      std::size_t right = std::min(left + 2 * width, blocks);
+      if (middle == right) return;
+      std::inplace_merge(
+          first + block_bound(n, blocks, left),
+          first + block_bound(n, blocks, middle),
+          first + block_bound(n, blocks, right),
+          comp
+        );
+    });
+  }
+}
+
+} // namespace detail
+
+
+/**
+ * ctl algorithms Implementation
+ */
+
+template<typename Policy, typename RandomIt, typename F>
+detail::enable_if_policy<Policy> for_each(Policy&&, RandomIt first, RandomIt last, F f)
+{
+  if (detail::is_sequenced<Policy>::value) {
+    std::for_each(detail::unwrap(first), detail::unwrap(last), f);
+    return;
+  }
+  const std::size_t n = last - first;
+  ctl::parallel_for(IndexRange{0, n}, detail::parallel_grain, [&](std::size_t lo, std::size_t hi) {
+    F local = f;
+    detail::apply(detail::loop_policy<Policy>(), first + lo, hi - lo, local);
+  });
+}
+
+template<typename Policy, typename RandomIt, typename OutputIt, typename F>
+detail::enable_if_policy<Policy, OutputIt> transform(Policy&&, RandomIt first, RandomIt last, OutputIt out, F f)
+{
+  if (detail::is_sequenced<Policy>::value) {
+    return std::transform(first, last, out, f);
+  }
+  const std::size_t n = last - first;
+  ctl::parallel_for(IndexRange{0, n}, detail::parallel_grain, [&](std::size_t lo, std::size_t hi) {
+    F local = f;
+    detail::apply(detail::loop_policy<Policy>(), first + lo, hi - lo, out + lo, local);
+  });
+  return out + n;
+}
+
+template<typename Policy, typename RandomIt1, typename RandomIt2, typename OutputIt, typename F>
+detail::enable_if_policy<Policy, OutputIt> transform(Policy&&, RandomIt1 first1, RandomIt1 last1, RandomIt2 first2, OutputIt out, F f)
+{
+  if (detail::is_sequenced<Policy>::value) {
+    return std::transform(first1, last1, first2, out, f);
+  }
+  const std::size_t n = last1 - first1;
+  ctl::parallel_for(IndexRange{0, n}, detail::parallel_grain, [&](std::size_t lo, std::size_t hi) {
+    F local = f;
+    detail::apply(detail::loop_policy<Policy>(), first1 + lo, hi - lo, first2 + lo, out + lo, local);
+  });
+  return out + n;
+}
+
+template<typename Policy, typename RandomIt, typename T, typename BinaryOp>
+detail::enable_if_policy<Policy, T> reduce(Policy&&, RandomIt first, RandomIt last, T init, BinaryOp op)
+{
+  if (detail::is_sequenced<Policy>::value || first == last) {
+    return std::accumulate(detail::unwrap(first), detail::unwrap(last), init, op);
+  }
+  const std::size_t n = last - first;
+  const std::size_t blocks = detail::block_count(n);
+  std::vector<T> partial(blocks, init);
+  detail::for_blocks(n, blocks, [&](std::size_t b, std::size_t lo, std::size_t hi) {
+    partial[b] = std::accumulate(first + lo + 1, first + hi, T(first[lo]), op);
+  });
+  for (std::size_t b = 0; b < blocks; ++b) {
+    init = op(init, partial[b]);
+  }
+  return init;
+}
+
+template<typename Policy, typename RandomIt, typename T>
+detail::enable_if_policy<Policy, T> reduce(Policy&& policy, RandomIt first, RandomIt last, T init)
+{
+  return ctl::reduce(std::forward<Policy>(policy), first, last, init, std::plus<>());
+}
+
+template<typename Policy, typename RandomIt>
+detail::enable_if_policy<Policy, typename std::iterator_traits<RandomIt>::value_type>
+reduce(Policy&& policy, RandomIt first, RandomIt last)
+{
+  using value_type = typename std::iterator_traits<RandomIt>::value_type;
+  return ctl::reduce(std::forward<Policy>(policy), first, last, value_type(), std::plus<>());
+}
+
+template<typename Policy, typename RandomIt, typename OutputIt, typename BinaryOp>
+detail::enable_if_policy<Policy, OutputIt> inclusive_scan(Policy&&, RandomIt first, RandomIt last, OutputIt out, BinaryOp op)
+{
+  if (detail::is_sequenced<Policy>::value || first == last) {
+    return std::partial_sum(first, last, out, op);
+  }
+  using value_type = typename std::iterator_traits<RandomIt>::value_type;
+
+  const std::size_t n = last - first;
+  const std::size_t blocks = detail::block_count(n);
+  std::vector<value_type> carry;
+  carry.reserve(blocks);
+
+  detail::for_blocks(n, blocks, [&](std::size_t, std::size_t lo, std::size_t hi) {
+    std::partial_sum(first + lo, first + hi, out + lo, op);
+  });
+  carry.push_back(out[detail::block_bound(n, blocks, 1) - 1]);
+  for (std::size_t b = 1; b + 1 < blocks; ++b) {
+    carry.push_back(op(carry.back(), out[detail::block_bound(n, blocks, b + 1) - 1]));
+  }
+  detail::for_blocks(n, blocks, [&](std::size_t b, std::size_t lo, std::size_t hi) {
+    if (b == 0) return;
+    for (std::size_t i = lo; i < hi; ++i) {
+      out[i] = op(carry[b - 1], out[i]);
+    }
+  });
+  return out + n;
+}
+
+template<typename Policy, typename RandomIt, typename OutputIt>
+detail::enable_if_policy<Policy, OutputIt> inclusive_scan(Policy&& policy, RandomIt first, RandomIt last, OutputIt out)
+{
+  return ctl::inclusive_scan(std::forward<Policy>(policy), first, last, out, std::plus<>());
+}
+
+template<typename Policy, typename RandomIt, typename Compare>
+detail::enable_if_policy<Policy> sort(Policy&&, RandomIt first, RandomIt last, Compare comp)
+{
+  if (detail::is_sequenced<Policy>::value) {
+    std::sort(detail::unwrap(first), detail::unwrap(last), comp);
+    return;
+  }
+  detail::parallel_sort(first, last, comp, [](RandomIt lo, RandomIt hi, Compare& c) { std::sort(lo, hi, c); });
+}
+
+template<typename Policy, typename RandomIt>
+detail::enable_if_policy<Policy> sort(Policy&& policy, RandomIt first, RandomIt last)
+{
+  ctl::sort(std::forward<Policy>(policy), first, last, std::less<>());
+}
+
+template<typename Policy, typename RandomIt, typename Compare>
+detail::enable_if_policy<Policy> stable_sort(Policy&&, RandomIt first, RandomIt last, Compare comp)
+{
+  if (detail::is_sequenced<Policy>::value) {
+    std::stable_sort(detail::unwrap(first), detail::unwrap(last), comp);
+    return;
+  }
+  detail::parallel_sort(first, last, comp, [](RandomIt lo, RandomIt hi, Compare& c) { std::stable_sort(lo, hi, c); });
+}
+
+template<typename Policy, typename RandomIt>
+detail::enable_if_policy<Policy> stable_sort(Policy&& policy, RandomIt first, RandomIt last)
+{
+  ctl::stable_sort(std::forward<Policy>(policy), first, last, std::less<>());
+}
+
+template<typename Policy, typename RandomIt, typename Predicate>
+detail::enable_if_policy<Policy, RandomIt> find_if(Policy&&, RandomIt first, RandomIt last, Predicate pred)
+{
+  if (detail::is_sequenced<Policy>::value) {
+    return std::find_if(first, last, pred);
+  }
+  const std::size_t n = last - first;
+  const std::size_t step = detail::parallel_grain / 4;
+  std::atomic<std::size_t> found(n);
+
+  detail::for_blocks(n, detail::block_count(n), [&](std::size_t, std::size_t lo, std::size_t hi) {
+    for (std::size_t i = lo; i < hi; i += step) {
+      if (found.load(std::memory_order_relaxed) < i) return;
+      RandomIt chunkLast = first + std::min(i + step, hi);
+      RandomIt it = std::find_if(first + i, chunkLast, pred);
+      if (it == chunkLast) continue;
+      std::size_t index = it - first;
+      std::size_t current = found.load();
+      while (index < current && !found.compare_exchange_weak(current, index)) {}
+      return;
+    }
+  });
+  return first + found.load();
+}
+
+template<typename Policy, typename RandomIt, typename Predicate>
+detail::enable_if_policy<Policy, typename std::iterator_traits<RandomIt>::difference_type>
+count_if(Policy&&, RandomIt first, RandomIt last, Predicate pred)
+{
+  if (detail::is_sequenced<Policy>::value) {
+    return std::count_if(first, last, pred);
+  }
+  const std::size_t n = last - first;
+  std::atomic<std::size_t> count(0);
+  ctl::parallel_for(IndexRange{0, n}, detail::parallel_grain, [&](std::size_t lo, std::size_t hi) {
+    count.fetch_add(std::count_if(first + lo, first + hi, pred), std::memory_order_relaxed);
+  });
+  return count.load();
+}
+
+} // namespace ctl
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <list>
+#include <mutex>
 #include <memory>
+#include <type_traits>
 #include <iostream>
 
 
@@ -99,6 +101,7 @@ struct MemoryPool
 
   pointer headPtr;
   std::list<MemoryChunk> chunks;
+  std::mutex lock;
   const size_type maxSize = FIXED_SIZE;
 
   MemoryPool();
@@ -138,10 +141,9 @@ public:
   using is_always_equal = typename traits::is_always_equal;
 
   Allocator() noexcept {}
-  Allocator(const Allocator<T>&) noexcept {}
+  Allocator(const Allocator<T>&) noexcept = default;
   template<typename U>
   Allocator(const Allocator<U>&) noexcept {}
-  virtual ~Allocator() = default;
 
   Allocator<T>& operator=(const Allocator<T>&) { return *this; };
   pointer allocate(size_type);
@@ -150,16 +152,13 @@ public:
   template<typename... Args>
   void construct(pointer, Args&&...);
   void destroy(pointer);
-
-private:
-  MemoryPool<T>& _pool = getPool<T>();
 };
 
 
 template<typename T>
 typename Allocator<T>::size_type Allocator<T>::max_size() const
 {
-  return _pool.maxSize;
+  return getPool<T>().maxSize;
 }
 
 template<typename T>
@@ -178,12 +177,14 @@ void Allocator<T>::destroy(pointer p)
 template<typename T>
 typename Allocator<T>::pointer Allocator<T>::allocate(size_type n)
 {
-  for (auto it = _pool.chunks.rbegin(); it != _pool.chunks.rend(); ++it) {
+  MemoryPool<T>& pool = getPool<T>();
+  std::lock_guard<std::mutex> guard(pool.lock);
+  for (auto it = pool.chunks.rbegin(); it != pool.chunks.rend(); ++it) {
     if (it->isFree && it->length == n) {
       it->isFree = false;
       return it->head;
     } else if (it->isFree && it->length > n) {
-      auto res = _pool.chunks.emplace(--it.base(), it->head, n, false);
+      auto res = pool.chunks.emplace(--it.base(), it->head, n, false);
       it->head += n;
       it->length -= n;
       return res->head;
@@ -197,22 +198,24 @@ void Allocator<T>::deallocate(pointer p, size_type n)
 {
   if (p == nullptr) return;
 
-  for (auto it = _pool.chunks.begin(); it != _pool.chunks.end(); ++it) {
+  MemoryPool<T>& pool = getPool<T>();
+  std::lock_guard<std::mutex> guard(pool.lock);
+  for (auto it = pool.chunks.begin(); it != pool.chunks.end(); ++it) {
     if (it->head != p || it->length != n) continue;
 
     it->isFree = true;
 
-    for (auto right = std::next(it); right != _pool.chunks.end() && right->isFree;) {
+    for (auto right = std::next(it); right != pool.chunks.end() && right->isFree;) {
       it->length += right->length;
-      right = _pool.chunks.erase(right);
+      right = pool.chunks.erase(right);
     }
 
-    if (it == _pool.chunks.begin()) continue;
+    if (it == pool.chunks.begin()) continue;
 
-    for (auto left = it; (--left) != _pool.chunks.begin() && left->isFree;) {
+    for (auto left = it; (--left) != pool.chunks.begin() && left->isFree;) {
       it->head = left->head;
       it->length += left->length;
-      left = _pool.chunks.erase(left);
+      left = pool.chunks.erase(left);
     }
   }
 }
@@ -229,4 +232,35 @@ bool operator!=(const Allocator<T>&, const Allocator<U>&)
   return false;
 }
 
+static_assert(std::is_empty< Allocator<int> >::value, "ctl::Allocator: must stay stateless");
+
+
+namespace detail {
+
+/**
+ * Allocator slot for containers. A stateless allocator becomes an empty
+ * base, so it adds nothing to the container's size; C++14 has no
+ * [[no_unique_address]] to do the same for a member.
+ */
+template<class A, bool = std::is_empty<A>::value && !std::is_final<A>::value>
+class AllocatorHolder : private A
+{
+protected:
+  A& allocator() noexcept { return *this; }
+  const A& allocator() const noexcept { return *this; }
+};
+
+template<class A>
+class AllocatorHolder<A, false>
+{
+protected:
+  A& allocator() noexcept { return _allocator; }
+  const A& allocator() const noexcept { return _allocator; }
+
+private:
+  A _allocator;
+};
+
+} // namespace detail
+
 } // namespace ctl
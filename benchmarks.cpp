@@ -1,12 +1,33 @@
 #define BENCHPRESS_FILE_OUTPUT
 
+#include <mutex>
 #include <chrono>
 #include <thread>
+#include <map>
+#include <deque>
+#include <condition_variable>
 #include <vector>
+#include <unordered_map>
 
 #include "benchpress_edited.hpp"
 // #include "allocator.hpp"
 #include "vector.hpp"
+#include "algorithm.hpp"
+#include "concurrent_vector.hpp"
+#include "stable_vector.hpp"
+#include "devector.hpp"
+#include "gap_vector.hpp"
+#include "soa_vector.hpp"
+#include "flat_map.hpp"
+#include "hash_map.hpp"
+#include "packed_int_vector.hpp"
+#include "cow_vector.hpp"
+#include "persistent_vector.hpp"
+#include "vector_builder.hpp"
+#include "slot_map.hpp"
+#include "circular_vector.hpp"
+#include "bounded_queue.hpp"
+#include "span.hpp"
 
 #ifndef BENCHPRESS_CONFIG_MAIN
 benchpress::registration* benchpress::registration::d_this;
@@ -17,6 +38,65 @@ using std_v_std_a = std::vector<int, std::allocator<int>>;
 using std_v_ctl_a = std::vector<int, ctl::Allocator<int>>;
 using ctl_v_std_a = ctl::Vector<int, std::allocator<int>>;
 using ctl_v_ctl_a = ctl::Vector<int, ctl::Allocator<int>>;
+using ctl_cv_std_a = ctl::ConcurrentVector<int, std::allocator<int>>;
+using ctl_sv_std_a = ctl::StableVector<int, std::allocator<int>>;
+using ctl_dv_std_a = ctl::Devector<int, std::allocator<int>>;
+using ctl_gv_std_a = ctl::GapVector<int, std::allocator<int>>;
+
+struct Record
+{
+  long long id;
+  double price;
+  int qty;
+  int flags;
+};
+
+using ctl_v_record = ctl::Vector<Record, std::allocator<Record>>;
+using ctl_soa_record = ctl::SoaVector<long long, double, int, int>;
+using ctl_v_byte = ctl::Vector<unsigned char, std::allocator<unsigned char>>;
+using ctl_v_bool = ctl::Vector<bool, std::allocator<bool>>;
+using std_map = std::map<int, int>;
+using std_umap = std::unordered_map<int, int>;
+using ctl_fm_std_a = ctl::FlatMap<int, int, std::less<int>, std::allocator<std::pair<int, int>>>;
+using ctl_fm_eytz = ctl::FlatMap<int, int, std::less<int>, std::allocator<std::pair<int, int>>, ctl::FlatLayout::Eytzinger>;
+using ctl_v_u32 = ctl::Vector<std::uint32_t, std::allocator<std::uint32_t>>;
+using ctl_piv_u32 = ctl::PackedIntVector<std::uint32_t, std::allocator<std::uint64_t>>;
+using ctl_cow_std_a = ctl::CowVector<int, std::allocator<int>>;
+using ctl_pv_std_a = ctl::PersistentVector<int, std::allocator<int>>;
+using ctl_vb_std_a = ctl::VectorBuilder<int, std::allocator<int>>;
+using ctl_sm_std_a = ctl::SlotMap<Record, std::allocator<Record>>;
+using ctl_cb_std_a = ctl::CircularVector<int, std::allocator<int>>;
+using ctl_spsc_batch = ctl::SpscQueue<ctl_v_std_a, std::allocator<ctl_v_std_a>>;
+using ctl_mpmc_batch = ctl::MpmcQueue<ctl_v_std_a, std::allocator<ctl_v_std_a>>;
+using ctl_hm_std_a = ctl::HashMap<int, int, std::hash<int>, std::equal_to<int>, std::allocator<std::pair<const int, int>>>;
+
+template<typename M>
+void lookup_benchmark(benchpress::context* ctx)
+{
+  const int count = 1 << 20;
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < count; ++i) {
+    items.emplace_back(static_cast<int>((i * 2654435761u) >> 8), i);
+  }
+  M m(items.begin(), items.end());
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    auto it = m.find(items[(k * 40503u) % count].first);
+    benchpress::escape(&*it);
+  }
+}
+
+template<typename M>
+void insert_benchmark(benchpress::context* ctx)
+{
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    M m;
+    for (int i = 0; i < 1 << 16; ++i) {
+      m[static_cast<int>(i * 2654435761u)] = i;
+    }
+    benchpress::escape(&m);
+  }
+}
 
 
 BENCHMARK("push_back -> std::vector && std::allocator", [](benchpress::context* ctx) {
@@ -119,6 +199,592 @@ BENCHMARK("complex -> ctl::Vector && ctl::Allocator", [](benchpress::context* ct
   }
 });
 
+BENCHMARK("sort -> ctl::Vector && std::sort", [](benchpress::context* ctx) {
+  ctl_v_std_a v(1 << 20);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctx->stop_timer();
+    for (size_t i = 0; i < v.size(); ++i) {
+      v[i] = static_cast<int>((i * 2654435761u) % v.size());
+    }
+    ctx->start_timer();
+    std::sort(v.begin(), v.end());
+  }
+});
+
+BENCHMARK("sort -> raw pointers && std::sort", [](benchpress::context* ctx) {
+  ctl_v_std_a v(1 << 20);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctx->stop_timer();
+    for (size_t i = 0; i < v.size(); ++i) {
+      v[i] = static_cast<int>((i * 2654435761u) % v.size());
+    }
+    ctx->start_timer();
+    std::sort(v.data(), v.data() + v.size());
+  }
+});
+
+BENCHMARK("copy -> ctl::Vector && std::copy", [](benchpress::context* ctx) {
+  ctl_v_std_a src(1 << 16, 1);
+  ctl_v_std_a dst(1 << 16);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    std::copy(src.begin(), src.end(), dst.begin());
+    benchpress::escape(dst.data());
+  }
+});
+
+BENCHMARK("copy -> raw pointers && std::copy", [](benchpress::context* ctx) {
+  ctl_v_std_a src(1 << 16, 1);
+  ctl_v_std_a dst(1 << 16);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    std::copy(src.data(), src.data() + src.size(), dst.data());
+    benchpress::escape(dst.data());
+  }
+});
+
+BENCHMARK("sort -> ctl::Vector && ctl::sort(par)", [](benchpress::context* ctx) {
+  ctl_v_std_a v(1 << 20);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctx->stop_timer();
+    for (size_t i = 0; i < v.size(); ++i) {
+      v[i] = static_cast<int>((i * 2654435761u) % v.size());
+    }
+    ctx->start_timer();
+    ctl::sort(ctl::execution::par, v.begin(), v.end());
+  }
+});
+
+BENCHMARK("reduce -> ctl::Vector && std::accumulate", [](benchpress::context* ctx) {
+  ctl_v_std_a v(1 << 20, 1);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    long long sum = std::accumulate(v.begin(), v.end(), 0ll);
+    benchpress::escape(&sum);
+  }
+});
+
+BENCHMARK("reduce -> ctl::Vector && ctl::reduce(par)", [](benchpress::context* ctx) {
+  ctl_v_std_a v(1 << 20, 1);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    long long sum = ctl::reduce(ctl::execution::par, v.begin(), v.end(), 0ll);
+    benchpress::escape(&sum);
+  }
+});
+
+BENCHMARK("run_parallel push_back -> ctl::Vector && std::allocator", [](benchpress::context* ctx) {
+  ctx->run_parallel([](benchpress::parallel_context* pctx) {
+    ctl_v_std_a v;
+    while (pctx->next()) {
+      v.push_back(1);
+    }
+  });
+});
+
+BENCHMARK("concurrent push_back -> std::mutex && ctl::Vector", [](benchpress::context* ctx) {
+  ctl_v_std_a v;
+  std::mutex lock;
+  ctx->set_num_threads(4);
+  ctx->run_parallel([&v, &lock](benchpress::parallel_context* pctx) {
+    while (pctx->next()) {
+      std::lock_guard<std::mutex> guard(lock);
+      v.push_back(1);
+    }
+  });
+});
+
+BENCHMARK("concurrent push_back -> ctl::ConcurrentVector", [](benchpress::context* ctx) {
+  ctl_cv_std_a v;
+  ctx->set_num_threads(4);
+  ctx->run_parallel([&v](benchpress::parallel_context* pctx) {
+    while (pctx->next()) {
+      v.push_back(1);
+    }
+  });
+});
+
+BENCHMARK("copy -> ctl::Vector && sequential copy", [](benchpress::context* ctx) {
+  ctl_v_std_a src(1 << 22, 1);
+  ctl::set_parallel_copy_threshold(0);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctl_v_std_a copy(src);
+    benchpress::escape(copy.data());
+  }
+});
+
+BENCHMARK("copy -> ctl::Vector && parallel copy", [](benchpress::context* ctx) {
+  ctl_v_std_a src(1 << 22, 1);
+  ctl::set_parallel_copy_threshold(1 << 20);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctl_v_std_a copy(src);
+    benchpress::escape(copy.data());
+  }
+  ctl::set_parallel_copy_threshold(0);
+});
+
+BENCHMARK("growth -> ctl::Vector", [](benchpress::context* ctx) {
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctl_v_std_a v;
+    for (int i = 0; i < (1 << 20); ++i) {
+      v.push_back(i);
+    }
+    benchpress::escape(v.data());
+  }
+});
+
+BENCHMARK("growth -> ctl::StableVector", [](benchpress::context* ctx) {
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctl_sv_std_a v;
+    for (int i = 0; i < (1 << 20); ++i) {
+      v.push_back(i);
+    }
+    benchpress::escape(&v.back());
+  }
+});
+
+BENCHMARK("iterate -> ctl::Vector", [](benchpress::context* ctx) {
+  ctl_v_std_a v(1 << 20, 1);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    long long sum = std::accumulate(v.begin(), v.end(), 0ll);
+    benchpress::escape(&sum);
+  }
+});
+
+BENCHMARK("iterate -> ctl::StableVector", [](benchpress::context* ctx) {
+  ctl_sv_std_a v(1 << 20, 1);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    long long sum = std::accumulate(v.begin(), v.end(), 0ll);
+    benchpress::escape(&sum);
+  }
+});
+
+BENCHMARK("push_front -> ctl::Vector && insert(begin())", [](benchpress::context* ctx) {
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctl_v_std_a v;
+    for (int i = 0; i < (1 << 12); ++i) {
+      v.insert(v.begin(), i);
+    }
+    benchpress::escape(v.data());
+  }
+});
+
+BENCHMARK("push_front -> ctl::Devector", [](benchpress::context* ctx) {
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctl_dv_std_a v;
+    for (int i = 0; i < (1 << 12); ++i) {
+      v.push_front(i);
+    }
+    benchpress::escape(v.data());
+  }
+});
+
+BENCHMARK("cursor edits -> ctl::Vector && insert/erase", [](benchpress::context* ctx) {
+  ctl_v_std_a v(1 << 16, 0);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    size_t cursor = (k * 16) % (v.size() - 32);
+    for (int i = 0; i < 16; ++i) {
+      v.insert(v.begin() + cursor + i, i);
+    }
+    v.erase(v.begin() + cursor, v.begin() + cursor + 16);
+  }
+});
+
+BENCHMARK("cursor edits -> ctl::GapVector", [](benchpress::context* ctx) {
+  ctl_gv_std_a v(1 << 16, 0);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    size_t cursor = (k * 16) % (v.size() - 32);
+    for (int i = 0; i < 16; ++i) {
+      v.insert(v.begin() + cursor + i, i);
+    }
+    v.erase(v.begin() + cursor, v.begin() + cursor + 16);
+  }
+});
+
+BENCHMARK("field scan -> ctl::Vector<Record>", [](benchpress::context* ctx) {
+  ctl_v_record v(1 << 20, Record{ 1, 1.0, 1, 0 });
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    double sum = 0;
+    for (size_t i = 0; i < v.size(); ++i) {
+      sum += v[i].price;
+    }
+    benchpress::escape(&sum);
+  }
+});
+
+BENCHMARK("field scan -> ctl::SoaVector", [](benchpress::context* ctx) {
+  ctl_soa_record v;
+  v.reserve(1 << 20);
+  for (int i = 0; i < (1 << 20); ++i) {
+    v.push_back(1, 1.0, 1, 0);
+  }
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    const double* prices = v.data<1>();
+    double sum = 0;
+    for (size_t i = 0; i < v.size(); ++i) {
+      sum += prices[i];
+    }
+    benchpress::escape(&sum);
+  }
+});
+
+BENCHMARK("bitmap count -> ctl::Vector<unsigned char>", [](benchpress::context* ctx) {
+  ctl_v_byte v(1 << 22, 0);
+  for (size_t i = 0; i < v.size(); i += 3) {
+    v[i] = 1;
+  }
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    size_t count = std::count(v.begin(), v.end(), 1);
+    benchpress::escape(&count);
+  }
+});
+
+BENCHMARK("bitmap count -> ctl::Vector<bool>", [](benchpress::context* ctx) {
+  ctl_v_bool v(1 << 22, false);
+  for (size_t i = 0; i < v.size(); i += 3) {
+    v[i] = true;
+  }
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    size_t count = v.count();
+    benchpress::escape(&count);
+  }
+});
+
+BENCHMARK("lookup -> std::map", lookup_benchmark<std_map>);
+BENCHMARK("lookup -> std::unordered_map", lookup_benchmark<std_umap>);
+BENCHMARK("lookup -> ctl::FlatMap", lookup_benchmark<ctl_fm_std_a>);
+BENCHMARK("lookup -> ctl::FlatMap(Eytzinger)", lookup_benchmark<ctl_fm_eytz>);
+BENCHMARK("lookup -> ctl::HashMap", lookup_benchmark<ctl_hm_std_a>);
+BENCHMARK("insert -> std::unordered_map", insert_benchmark<std_umap>);
+BENCHMARK("insert -> ctl::HashMap", insert_benchmark<ctl_hm_std_a>);
+
+BENCHMARK("scan -> ctl::Vector<uint32_t>", [](benchpress::context* ctx) {
+  ctl_v_u32 v;
+  for (std::uint32_t i = 0; i < 1 << 20; ++i) {
+    v.push_back((i * 7919) % 4096);
+  }
+  std::uint32_t block[1024];
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < v.size(); i += 1024) {
+      std::copy(&v[i], &v[i] + 1024, block);
+      for (auto x : block) sum += x;
+    }
+    benchpress::escape(&sum);
+  }
+});
+
+BENCHMARK("scan -> ctl::PackedIntVector(12 bits)", [](benchpress::context* ctx) {
+  ctl_piv_u32 v(12);
+  for (std::uint32_t i = 0; i < 1 << 20; ++i) {
+    v.push_back((i * 7919) % 4096);
+  }
+  std::uint32_t block[1024];
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < v.size(); i += 1024) {
+      v.decode(i, 1024, block);
+      for (auto x : block) sum += x;
+    }
+    benchpress::escape(&sum);
+  }
+});
+
+BENCHMARK("snapshot -> ctl::Vector copy", [](benchpress::context* ctx) {
+  ctl_v_std_a source(1 << 20, 1);
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctl_v_std_a snapshot(source);
+    benchpress::escape(&snapshot[k % snapshot.size()]);
+  }
+});
+
+BENCHMARK("snapshot -> ctl::CowVector copy", [](benchpress::context* ctx) {
+  ctl_cow_std_a source(1 << 20, 1);
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    const ctl_cow_std_a snapshot(source);
+    benchpress::escape(const_cast<int*>(&snapshot[k % snapshot.size()]));
+  }
+});
+
+BENCHMARK("versioned set -> ctl::CowVector", [](benchpress::context* ctx) {
+  ctl_cow_std_a current(1 << 20, 1);
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctl_cow_std_a next(current);
+    next[(k * 40503u) % next.size()] = k;
+    current = next;
+  }
+});
+
+BENCHMARK("versioned set -> ctl::PersistentVector", [](benchpress::context* ctx) {
+  std::vector<int> items(1 << 20, 1);
+  ctl_pv_std_a current(items.begin(), items.end());
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    current = current.set((k * 40503u) % current.size(), k);
+  }
+});
+
+BENCHMARK("ingest -> ctl::Vector push_back", [](benchpress::context* ctx) {
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctl_v_std_a v;
+    for (int i = 0; i < 1 << 20; ++i) {
+      v.push_back(i);
+    }
+    benchpress::escape(v.data());
+  }
+});
+
+BENCHMARK("ingest -> ctl::VectorBuilder", [](benchpress::context* ctx) {
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctl_vb_std_a builder;
+    for (int i = 0; i < 1 << 20; ++i) {
+      builder.push_back(i);
+    }
+    ctl_v_std_a v = builder.finish();
+    benchpress::escape(v.data());
+  }
+});
+
+BENCHMARK("scattered erase -> ctl::Vector erase loop", [](benchpress::context* ctx) {
+  ctl_v_std_a source(1 << 16, 1);
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctx->stop_timer();
+    ctl_v_std_a v(source);
+    ctx->start_timer();
+    for (std::size_t i = v.size(); i-- > 0;) {
+      if (i % 16 == 0) v.erase(v.begin() + i);
+    }
+    benchpress::escape(v.data());
+  }
+});
+
+BENCHMARK("scattered erase -> ctl::Vector erase_unordered", [](benchpress::context* ctx) {
+  ctl_v_std_a source(1 << 16, 1);
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctx->stop_timer();
+    ctl_v_std_a v(source);
+    ctx->start_timer();
+    for (std::size_t i = v.size(); i-- > 0;) {
+      if (i % 16 == 0) v.erase_unordered(v.begin() + i);
+    }
+    benchpress::escape(v.data());
+  }
+});
+
+BENCHMARK("scattered erase -> ctl::Vector erase_indices", [](benchpress::context* ctx) {
+  ctl_v_std_a source(1 << 16, 1);
+  std::vector<std::size_t> indices;
+  for (std::size_t i = 0; i < source.size(); i += 16) {
+    indices.push_back(i);
+  }
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    ctx->stop_timer();
+    ctl_v_std_a v(source);
+    ctx->start_timer();
+    v.erase_indices(indices.begin(), indices.end());
+    benchpress::escape(v.data());
+  }
+});
+
+BENCHMARK("object pool iterate -> new/delete pointers", [](benchpress::context* ctx) {
+  std::vector<Record*> pool;
+  for (int i = 0; i < (1 << 16); ++i) {
+    pool.push_back(new Record{ i, 1.0, i, i });
+    if (i % 3 == 0) {
+      delete pool[i / 2];
+      pool[i / 2] = new Record(Record{ i, 1.0, i, i });
+    }
+  }
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    long long sum = 0;
+    for (Record* record : pool) {
+      sum += record->id;
+    }
+    benchpress::escape(&sum);
+  }
+  ctx->stop_timer();
+  for (Record* record : pool) {
+    delete record;
+  }
+});
+
+BENCHMARK("object pool iterate -> ctl::SlotMap", [](benchpress::context* ctx) {
+  ctl_sm_std_a pool;
+  std::vector<ctl_sm_std_a::Key> keys;
+  for (int i = 0; i < (1 << 16); ++i) {
+    keys.push_back(pool.insert(Record{ i, 1.0, i, i }));
+    if (i % 3 == 0) {
+      pool.erase(keys[i / 2]);
+      keys[i / 2] = pool.insert(Record{ i, 1.0, i, i });
+    }
+  }
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    long long sum = 0;
+    for (auto it = pool.begin(); it != pool.end(); ++it) {
+      sum += it->id;
+    }
+    benchpress::escape(&sum);
+  }
+});
+
+BENCHMARK("object pool churn -> ctl::SlotMap", [](benchpress::context* ctx) {
+  ctl_sm_std_a pool;
+  std::vector<ctl_sm_std_a::Key> keys;
+  for (int i = 0; i < 1024; ++i) {
+    keys.push_back(pool.insert(Record{ i, 1.0, i, i }));
+  }
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    const std::size_t victim = (k * 7919u) % keys.size();
+    pool.erase(keys[victim]);
+    keys[victim] = pool.insert(Record{ k, 1.0, k, k });
+    benchpress::escape(pool.data());
+  }
+});
+
+BENCHMARK("sliding window -> ctl::Vector erase(begin) + push_back", [](benchpress::context* ctx) {
+  ctl_v_std_a window(4096, 1);
+  long long sum = 4096;
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    sum -= window.front();
+    window.erase(window.begin());
+    window.push_back(k & 7);
+    sum += k & 7;
+  }
+  benchpress::escape(&sum);
+});
+
+BENCHMARK("sliding window -> ctl::CircularVector overwrite", [](benchpress::context* ctx) {
+  ctl_cb_std_a window;
+  window.reserve(4096);
+  window.set_overwrite(true);
+  for (int i = 0; i < 4096; ++i) {
+    window.push_back(1);
+  }
+  long long sum = 4096;
+  ctx->reset_timer();
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    sum -= window.front();
+    window.push_back(k & 7);
+    sum += k & 7;
+  }
+  benchpress::escape(&sum);
+});
+
+BENCHMARK("batch handoff -> mutex + condvar queue", [](benchpress::context* ctx) {
+  std::mutex lock;
+  std::condition_variable ready;
+  std::deque<ctl_v_std_a> queue;
+  const auto count = ctx->num_iterations();
+  ctx->reset_timer();
+  std::thread producer([&]() {
+    ctl_v_std_a batch;
+    for (auto k = 0; k < count; ++k) {
+      batch.push_back(k);
+      std::lock_guard<std::mutex> guard(lock);
+      queue.emplace_back();
+      queue.back().swap(batch);
+      ready.notify_one();
+    }
+  });
+  long long sum = 0;
+  ctl_v_std_a batch;
+  for (auto k = 0; k < count; ++k) {
+    std::unique_lock<std::mutex> guard(lock);
+    ready.wait(guard, [&queue]() { return !queue.empty(); });
+    batch.swap(queue.front());
+    queue.pop_front();
+    guard.unlock();
+    sum += batch.size();
+  }
+  producer.join();
+  benchpress::escape(&sum);
+});
+
+BENCHMARK("batch handoff -> ctl::SpscQueue", [](benchpress::context* ctx) {
+  ctl_spsc_batch queue(1024);
+  const auto count = ctx->num_iterations();
+  ctx->reset_timer();
+  std::thread producer([&]() {
+    ctl_v_std_a batch;
+    for (auto k = 0; k < count; ++k) {
+      batch.push_back(k);
+      while (!queue.try_push(std::move(batch))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  long long sum = 0;
+  ctl_v_std_a batch;
+  for (auto k = 0; k < count;) {
+    if (queue.try_pop(batch)) {
+      sum += batch.size();
+      ++k;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  benchpress::escape(&sum);
+});
+
+BENCHMARK("batch handoff -> ctl::MpmcQueue", [](benchpress::context* ctx) {
+  ctl_mpmc_batch queue(1024);
+  const auto count = ctx->num_iterations();
+  ctx->reset_timer();
+  std::thread producer([&]() {
+    ctl_v_std_a batch;
+    for (auto k = 0; k < count; ++k) {
+      batch.push_back(k);
+      while (!queue.try_push(std::move(batch))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  long long sum = 0;
+  ctl_v_std_a batch;
+  for (auto k = 0; k < count;) {
+    if (queue.try_pop(batch)) {
+      sum += batch.size();
+      ++k;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  benchpress::escape(&sum);
+});
+
+BENCHMARK("subrange sum -> ctl::Vector copy", [](benchpress::context* ctx) {
+  ctl_v_std_a v(1 << 16, 1);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    long long sum = 0;
+    for (std::size_t i = 0; i < v.size(); i += 256) {
+      ctl_v_std_a part(v.begin() + i, v.begin() + i + 256);
+      sum += std::accumulate(part.begin(), part.end(), 0ll);
+    }
+    benchpress::escape(&sum);
+  }
+});
+
+BENCHMARK("subrange sum -> ctl::VectorView", [](benchpress::context* ctx) {
+  ctl_v_std_a v(1 << 16, 1);
+  for (auto k = 0; k < ctx->num_iterations(); ++k) {
+    long long sum = 0;
+    for (auto part : ctl::VectorView<int>(v).chunks(256)) {
+      sum += std::accumulate(part.begin(), part.end(), 0ll);
+    }
+    benchpress::escape(&sum);
+  }
+});
+
 
 int main(int argc, char** argv)
 {
@@ -35,6 +35,9 @@
 #include <vector>      // vector
 
 #include <fstream>     // edited section: output to file
+#include <memory>      // edited section: unique_ptr
+
+#include "thread_pool.hpp" // edited section: reuse ctl workers for parallel runs
 
 namespace benchpress {
 
@@ -291,6 +294,19 @@ public:
     }
 };
 
+/*
+ * The worker_pool function (edited section) keeps one ctl::ThreadPool alive between parallel runs, so that
+ * run_parallel measures the benchmark body rather than thread creation. It is rebuilt only when the requested
+ * number of threads changes.
+ */
+inline ctl::ThreadPool& worker_pool(size_t num_threads) {
+    static std::unique_ptr<ctl::ThreadPool> pool;
+    if (!pool || pool->size() != num_threads) {
+        pool.reset(new ctl::ThreadPool(num_threads));
+    }
+    return *pool;
+}
+
 /*
  * The context class is responsible for providing an interface for capturing benchmark metrics to benchmark functions.
  */
@@ -359,15 +375,13 @@ public:
 
     void run_parallel(std::function<void(parallel_context*)> f) {
         parallel_context pc(d_num_iterations);
-        std::vector<std::thread> threads;
+        ctl::TaskGroup group(worker_pool(d_num_threads));
         for (size_t i = 0; i < d_num_threads; ++i) {
-            threads.push_back(std::thread([&pc,&f]() -> void {
+            group.run([&pc,&f]() -> void {
                 f(&pc);
-            }));
-        }
-        for(auto& thread : threads){
-            thread.join();
+            });
         }
+        group.wait();
     }
 
     result run() {
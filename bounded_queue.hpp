@@ -0,0 +1,392 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "allocator.hpp"
+
+
+namespace ctl {
+
+namespace detail {
+
+/**
+ * Fixed array of queue cells, each constructed as Cell(i). Cells are carved
+ * out of whole words rather than a pool of their own: ctl::Allocator
+ * reserves FIXED_SIZE elements per type up front, which is far too much
+ * address space for cells that wrap a ctl::Vector.
+ */
+template<typename Cell, class A>
+class CellArray
+{
+public:
+  using word_type = std::uint64_t;
+  using word_allocator = typename std::allocator_traits<A>::template rebind_alloc<word_type>;
+
+  static_assert(alignof(Cell) <= alignof(word_type), "ctl: queue cell needs stronger alignment than a word");
+
+  explicit CellArray(std::size_t count) : _count(count)
+  {
+    _cells = reinterpret_cast<Cell*>(_allocator.allocate(words()));
+    std::size_t i = 0;
+    try {
+      for (; i < count; ++i) {
+        ::new (static_cast<void*>(_cells + i)) Cell(i);
+      }
+    } catch (...) {
+      destroy(i);
+      throw;
+    }
+  }
+  CellArray(const CellArray&) = delete;
+  CellArray& operator=(const CellArray&) = delete;
+  ~CellArray() { destroy(_count); }
+
+  Cell& operator[](std::size_t i) const noexcept { return _cells[i]; }
+
+private:
+  word_allocator _allocator;
+  Cell* _cells;
+  std::size_t _count;
+
+  std::size_t words() const noexcept { return (_count * sizeof(Cell) + sizeof(word_type) - 1) / sizeof(word_type); }
+
+  void destroy(std::size_t constructed) noexcept
+  {
+    for (std::size_t i = 0; i < constructed; ++i) {
+      _cells[i].~Cell();
+    }
+    _allocator.deallocate(reinterpret_cast<word_type*>(_cells), words());
+  }
+};
+
+inline std::size_t queue_capacity(std::size_t requested)
+{
+  if (requested > (static_cast<std::size_t>(-1) >> 1) + 1) {
+    throw std::length_error("ctl: queue capacity too big");
+  }
+  std::size_t rounded = 1;
+  while (rounded < requested) {
+    rounded *= 2;
+  }
+  return rounded;
+}
+
+} // namespace detail
+
+
+/**
+ * ctl::SpscQueue Definition
+ *
+ * Bounded lock-free queue for exactly one producer thread and one consumer
+ * thread. The capacity is rounded up to a power of two. Head and tail live
+ * on separate cache lines, each next to the owning thread's cached copy of
+ * the other index, so the threads only touch each other's line when the
+ * queue looks full or empty.
+ *
+ * Every cell holds a live T from construction on, and values are moved in
+ * and out by move assignment. For T = ctl::Vector that is a pointer swap,
+ * so no element is copied. push_n / pop_n transfer a whole batch with a
+ * single index publication.
+ */
+
+template<typename T, class A = Allocator<T>>
+class SpscQueue
+{
+public:
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using reference = typename A::reference;
+  using const_reference = typename A::const_reference;
+
+  explicit SpscQueue(size_type);
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  bool try_push(const_reference);
+  bool try_push(value_type&&);
+  template<typename IteratorType>
+  size_type push_n(IteratorType, size_type);
+
+  bool try_pop(reference);
+  template<typename IteratorType>
+  size_type pop_n(IteratorType, size_type);
+
+  size_type size() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+
+private:
+  struct Cell
+  {
+    T value;
+
+    explicit Cell(std::size_t) : value() {}
+  };
+
+  detail::CellArray<Cell, A> _cells;
+  const size_type _mask;
+
+  alignas(64) std::atomic<size_type> _tail{0};
+  size_type _headCache = 0;
+
+  alignas(64) std::atomic<size_type> _head{0};
+  size_type _tailCache = 0;
+};
+
+
+/**
+ * ctl::MpmcQueue Definition
+ *
+ * Bounded lock-free queue for any number of producers and consumers
+ * (Vyukov's sequenced ring). Each cell carries a sequence number that says
+ * whether it is ready to be written or read for a given lap, so a thread
+ * claims a cell with one CAS on the shared index and never waits on a lock.
+ * As in SpscQueue, cells hold live values moved in and out by move
+ * assignment, which must not throw. push_n / pop_n claim cells one at a
+ * time and stop at the first full / empty one.
+ */
+
+template<typename T, class A = Allocator<T>>
+class MpmcQueue
+{
+public:
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using reference = typename A::reference;
+  using const_reference = typename A::const_reference;
+
+  explicit MpmcQueue(size_type);
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  bool try_push(const_reference);
+  bool try_push(value_type&&);
+  template<typename IteratorType>
+  size_type push_n(IteratorType, size_type);
+
+  bool try_pop(reference);
+  template<typename IteratorType>
+  size_type pop_n(IteratorType, size_type);
+
+  size_type size() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+
+private:
+  struct Cell
+  {
+    std::atomic<size_type> sequence;
+    T value;
+
+    explicit Cell(std::size_t i) : sequence(i), value() {}
+  };
+
+  detail::CellArray<Cell, A> _cells;
+  const size_type _mask;
+
+  alignas(64) std::atomic<size_type> _tail{0};
+  alignas(64) std::atomic<size_type> _head{0};
+};
+
+
+/**
+ * ctl::SpscQueue Implementation
+ */
+
+template<typename T, typename A>
+SpscQueue<T, A>::SpscQueue(size_type capacity) : _cells(detail::queue_capacity(capacity)), _mask(detail::queue_capacity(capacity) - 1) {}
+
+template<typename T, typename A>
+bool SpscQueue<T, A>::try_push(const_reference value)
+{
+  return push_n(&value, 1) == 1;
+}
+
+template<typename T, typename A>
+bool SpscQueue<T, A>::try_push(value_type&& value)
+{
+  return push_n(&value, 1) == 1;
+}
+
+/**
+ * Moves up to count values from first into the queue and returns how many
+ * fit. If an assignment throws, the values before it are still published.
+ */
+template<typename T, typename A>
+template<typename IteratorType>
+typename SpscQueue<T, A>::size_type SpscQueue<T, A>::push_n(IteratorType first, size_type count)
+{
+  const size_type tail = _tail.load(std::memory_order_relaxed);
+  if (capacity() - (tail - _headCache) < count) {
+    _headCache = _head.load(std::memory_order_acquire);
+  }
+  const size_type n = std::min(count, capacity() - (tail - _headCache));
+  size_type i = 0;
+  try {
+    for (; i < n; ++i, ++first) {
+      _cells[(tail + i) & _mask].value = std::move(*first);
+    }
+  } catch (...) {
+    _tail.store(tail + i, std::memory_order_release);
+    throw;
+  }
+  _tail.store(tail + n, std::memory_order_release);
+  return n;
+}
+
+template<typename T, typename A>
+bool SpscQueue<T, A>::try_pop(reference out)
+{
+  return pop_n(&out, 1) == 1;
+}
+
+/**
+ * Moves up to count values out of the queue into out and returns how many
+ * there were. If an assignment throws, the values before it are consumed.
+ */
+template<typename T, typename A>
+template<typename IteratorType>
+typename SpscQueue<T, A>::size_type SpscQueue<T, A>::pop_n(IteratorType out, size_type count)
+{
+  const size_type head = _head.load(std::memory_order_relaxed);
+  if (_tailCache - head < count) {
+    _tailCache = _tail.load(std::memory_order_acquire);
+  }
+  const size_type n = std::min(count, _tailCache - head);
+  size_type i = 0;
+  try {
+    for (; i < n; ++i, ++out) {
+      *out = std::move(_cells[(head + i) & _mask].value);
+    }
+  } catch (...) {
+    _head.store(head + i, std::memory_order_release);
+    throw;
+  }
+  _head.store(head + n, std::memory_order_release);
+  return n;
+}
+
+template<typename T, typename A>
+typename SpscQueue<T, A>::size_type SpscQueue<T, A>::size() const noexcept
+{
+  const size_type head = _head.load(std::memory_order_acquire);
+  return _tail.load(std::memory_order_acquire) - head;
+}
+
+template<typename T, typename A>
+inline typename SpscQueue<T, A>::size_type SpscQueue<T, A>::capacity() const noexcept
+{
+  return _mask + 1;
+}
+
+template<typename T, typename A>
+inline bool SpscQueue<T, A>::empty() const noexcept
+{
+  return size() == 0;
+}
+
+
+/**
+ * ctl::MpmcQueue Implementation
+ */
+
+template<typename T, typename A>
+MpmcQueue<T, A>::MpmcQueue(size_type capacity) : _cells(detail::queue_capacity(capacity)), _mask(detail::queue_capacity(capacity) - 1) {}
+
+template<typename T, typename A>
+bool MpmcQueue<T, A>::try_push(const_reference value)
+{
+  value_type copy(value);
+  return try_push(std::move(copy));
+}
+
+template<typename T, typename A>
+bool MpmcQueue<T, A>::try_push(value_type&& value)
+{
+  size_type pos = _tail.load(std::memory_order_relaxed);
+  Cell* cell;
+  for (;;) {
+    cell = &_cells[pos & _mask];
+    const size_type sequence = cell->sequence.load(std::memory_order_acquire);
+    const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence - pos);
+    if (diff == 0) {
+      if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = _tail.load(std::memory_order_relaxed);
+    }
+  }
+  cell->value = std::move(value);
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+template<typename T, typename A>
+template<typename IteratorType>
+typename MpmcQueue<T, A>::size_type MpmcQueue<T, A>::push_n(IteratorType first, size_type count)
+{
+  size_type n = 0;
+  for (; n < count && try_push(std::move(*first)); ++n, ++first) {}
+  return n;
+}
+
+template<typename T, typename A>
+bool MpmcQueue<T, A>::try_pop(reference out)
+{
+  size_type pos = _head.load(std::memory_order_relaxed);
+  Cell* cell;
+  for (;;) {
+    cell = &_cells[pos & _mask];
+    const size_type sequence = cell->sequence.load(std::memory_order_acquire);
+    const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+    if (diff == 0) {
+      if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = _head.load(std::memory_order_relaxed);
+    }
+  }
+  out = std::move(cell->value);
+  cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+  return true;
+}
+
+template<typename T, typename A>
+template<typename IteratorType>
+typename MpmcQueue<T, A>::size_type MpmcQueue<T, A>::pop_n(IteratorType out, size_type count)
+{
+  size_type n = 0;
+  for (; n < count && try_pop(*out); ++n, ++out) {}
+  return n;
+}
+
+template<typename T, typename A>
+typename MpmcQueue<T, A>::size_type MpmcQueue<T, A>::size() const noexcept
+{
+  const size_type head = _head.load(std::memory_order_acquire);
+  const size_type tail = _tail.load(std::memory_order_acquire);
+  return tail > head ? tail - head : 0;
+}
+
+template<typename T, typename A>
+inline typename MpmcQueue<T, A>::size_type MpmcQueue<T, A>::capacity() const noexcept
+{
+  return _mask + 1;
+}
+
+template<typename T, typename A>
+inline bool MpmcQueue<T, A>::empty() const noexcept
+{
+  return size() == 0;
+}
+
+} // namespace ctl
@@ -0,0 +1,479 @@
+#pragma once
+
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <initializer_list>
+
+#include "allocator.hpp"
+#include "iterator.hpp"
+#include "parallel_copy.hpp"
+
+
+namespace ctl {
+
+/**
+ * ctl::CircularVector Definition
+ *
+ * Ring buffer over one contiguous allocation from A. The capacity is always
+ * a power of two, so the physical slot of element i is (head + i) & mask and
+ * push_back / pop_front (and their front / back counterparts) are O(1)
+ * without ever shifting elements. A full buffer doubles, unless overwrite
+ * mode is on, in which case pushing at one end drops the element at the
+ * other, which is what a fixed-size sliding window wants.
+ *
+ * Elements may wrap around the end of the allocation; as_contiguous()
+ * rotates them in place so they can be handed out as a plain array.
+ */
+
+template<typename T, class A = Allocator<T>>
+class CircularVector
+{
+public:
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using difference_type = typename A::difference_type;
+  using reference = typename A::reference;
+  using const_reference = typename A::const_reference;
+  using pointer = typename A::pointer;
+  using const_pointer = typename A::const_pointer;
+  using iterator = ctl::IndexIterator<CircularVector, T>;
+  using const_iterator = ctl::IndexIterator<const CircularVector, const T>;
+
+  CircularVector() {};
+  CircularVector(const CircularVector&);
+  CircularVector(CircularVector&&);
+  CircularVector(std::initializer_list<T>);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  CircularVector(IteratorType, IteratorType);
+
+  ~CircularVector();
+
+  CircularVector& operator=(const CircularVector&);
+  CircularVector& operator=(CircularVector&&);
+
+  iterator begin() noexcept;
+  iterator end() noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+  bool full() const noexcept;
+  void reserve(size_type);
+
+  bool overwrite() const noexcept;
+  void set_overwrite(bool) noexcept;
+
+  reference at(size_type);
+  const_reference at(size_type) const;
+  reference operator[](size_type) noexcept;
+  const_reference operator[](size_type) const noexcept;
+  reference front();
+  reference back();
+
+  bool is_contiguous() const noexcept;
+  pointer as_contiguous();
+
+  void push_back(const_reference);
+  void push_back(value_type&&);
+  template<class... Args>
+  reference emplace_back(Args&&...);
+  void pop_back();
+
+  void push_front(const_reference);
+  void push_front(value_type&&);
+  template<class... Args>
+  reference emplace_front(Args&&...);
+  void pop_front();
+
+  void swap(CircularVector&) noexcept;
+  void clear() noexcept;
+
+  A get_allocator() const noexcept;
+
+private:
+  static constexpr size_type _minCapacity = 8;
+
+  A _allocator;
+  pointer _storage = nullptr;
+  size_type _capacity = 0;
+  size_type _head = 0;
+  size_type _size = 0;
+  bool _overwrite = false;
+
+  pointer slot(size_type) const noexcept;
+  void relocate(size_type);
+  void grow();
+};
+
+
+/**
+ * ctl::CircularVector Implementation
+ */
+
+template<typename T, typename A>
+constexpr typename CircularVector<T, A>::size_type CircularVector<T, A>::_minCapacity;
+
+template<typename T, typename A>
+CircularVector<T, A>::CircularVector(const CircularVector& other) : _overwrite(other._overwrite)
+{
+  reserve(other.capacity());
+  for (size_type i = 0; i < other.size(); ++i) {
+    emplace_back(other[i]);
+  }
+}
+
+template<typename T, typename A>
+CircularVector<T, A>::CircularVector(CircularVector&& other)
+{
+  swap(other);
+}
+
+template<typename T, typename A>
+CircularVector<T, A>::CircularVector(std::initializer_list<T> list) : CircularVector(list.begin(), list.end()) {}
+
+template<typename T, typename A>
+template<typename IteratorType, typename isIterator>
+CircularVector<T, A>::CircularVector(IteratorType first, IteratorType last)
+{
+  for (; first != last; ++first) {
+    emplace_back(*first);
+  }
+}
+
+template<typename T, typename A>
+CircularVector<T, A>::~CircularVector()
+{
+  clear();
+  _allocator.deallocate(_storage, _capacity);
+}
+
+template<typename T, typename A>
+CircularVector<T, A>& CircularVector<T, A>::operator=(const CircularVector& other)
+{
+  if (this == &other) return *this;
+  CircularVector copy(other);
+  swap(copy);
+  return *this;
+}
+
+template<typename T, typename A>
+CircularVector<T, A>& CircularVector<T, A>::operator=(CircularVector&& other)
+{
+  if (this == &other) return *this;
+  CircularVector moved(std::move(other));
+  swap(moved);
+  return *this;
+}
+
+template<typename T, typename A>
+typename CircularVector<T, A>::iterator CircularVector<T, A>::begin() noexcept
+{
+  return iterator(this, 0);
+}
+
+template<typename T, typename A>
+typename CircularVector<T, A>::iterator CircularVector<T, A>::end() noexcept
+{
+  return iterator(this, _size);
+}
+
+template<typename T, typename A>
+typename CircularVector<T, A>::const_iterator CircularVector<T, A>::cbegin() const noexcept
+{
+  return const_iterator(this, 0);
+}
+
+template<typename T, typename A>
+typename CircularVector<T, A>::const_iterator CircularVector<T, A>::cend() const noexcept
+{
+  return const_iterator(this, _size);
+}
+
+template<typename T, typename A>
+inline typename CircularVector<T, A>::size_type CircularVector<T, A>::size() const noexcept
+{
+  return _size;
+}
+
+template<typename T, typename A>
+typename CircularVector<T, A>::size_type CircularVector<T, A>::max_size() const noexcept
+{
+  return (static_cast<size_type>(-1) / sizeof(T) + 1) / 2;
+}
+
+template<typename T, typename A>
+inline typename CircularVector<T, A>::size_type CircularVector<T, A>::capacity() const noexcept
+{
+  return _capacity;
+}
+
+template<typename T, typename A>
+inline bool CircularVector<T, A>::empty() const noexcept
+{
+  return _size == 0;
+}
+
+template<typename T, typename A>
+inline bool CircularVector<T, A>::full() const noexcept
+{
+  return _size == _capacity;
+}
+
+/**
+ * Rounds newCapacity up to a power of two. In overwrite mode this is also
+ * the window length, so reserve before the first push.
+ */
+template<typename T, typename A>
+void CircularVector<T, A>::reserve(size_type newCapacity)
+{
+  if (newCapacity > max_size()) {
+    throw std::length_error("ctl::CircularVector: too big capacity to reserve");
+  }
+  if (newCapacity <= _capacity) return;
+  size_type rounded = 1;
+  while (rounded < newCapacity) {
+    rounded *= 2;
+  }
+  relocate(rounded);
+}
+
+template<typename T, typename A>
+inline bool CircularVector<T, A>::overwrite() const noexcept
+{
+  return _overwrite;
+}
+
+template<typename T, typename A>
+inline void CircularVector<T, A>::set_overwrite(bool enabled) noexcept
+{
+  _overwrite = enabled;
+}
+
+template<typename T, typename A>
+typename CircularVector<T, A>::reference CircularVector<T, A>::at(size_type i)
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::CircularVector: out of range");
+  }
+  return *slot(i);
+}
+
+template<typename T, typename A>
+typename CircularVector<T, A>::const_reference CircularVector<T, A>::at(size_type i) const
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::CircularVector: out of range");
+  }
+  return *slot(i);
+}
+
+template<typename T, typename A>
+inline typename CircularVector<T, A>::reference CircularVector<T, A>::operator[](size_type i) noexcept
+{
+  return *slot(i);
+}
+
+template<typename T, typename A>
+inline typename CircularVector<T, A>::const_reference CircularVector<T, A>::operator[](size_type i) const noexcept
+{
+  return *slot(i);
+}
+
+template<typename T, typename A>
+typename CircularVector<T, A>::reference CircularVector<T, A>::front()
+{
+  return *slot(0);
+}
+
+template<typename T, typename A>
+typename CircularVector<T, A>::reference CircularVector<T, A>::back()
+{
+  return *slot(_size - 1);
+}
+
+template<typename T, typename A>
+inline bool CircularVector<T, A>::is_contiguous() const noexcept
+{
+  return _head + _size <= _capacity;
+}
+
+/**
+ * Returns a pointer to the elements laid out in order. A wrapped buffer is
+ * first rotated in place: the front run is moved down next to the wrapped
+ * tail, which makes the live slots one block, and that block is rotated.
+ */
+template<typename T, typename A>
+typename CircularVector<T, A>::pointer CircularVector<T, A>::as_contiguous()
+{
+  if (is_contiguous()) return _storage + _head;
+
+  const size_type frontRun = _capacity - _head;
+  const size_type tailRun = _size - frontRun;
+  for (size_type k = 0; tailRun < _head && k < frontRun; ++k) {
+    const pointer dst = _storage + tailRun + k;
+    if (tailRun + k < _head) {
+      _allocator.construct(dst, std::move(_storage[_head + k]));
+    } else {
+      *dst = std::move(_storage[_head + k]);
+    }
+  }
+  for (size_type i = std::max(_size, _head); tailRun < _head && i < _capacity; ++i) {
+    _allocator.destroy(_storage + i);
+  }
+  std::rotate(_storage, _storage + tailRun, _storage + _size);
+  _head = 0;
+  return _storage;
+}
+
+template<typename T, typename A>
+void CircularVector<T, A>::push_back(const_reference value)
+{
+  emplace_back(value);
+}
+
+template<typename T, typename A>
+void CircularVector<T, A>::push_back(value_type&& value)
+{
+  emplace_back(std::move(value));
+}
+
+template<typename T, typename A>
+template<class... Args>
+typename CircularVector<T, A>::reference CircularVector<T, A>::emplace_back(Args&&... args)
+{
+  if (full()) {
+    value_type value(std::forward<Args>(args)...);
+    if (_overwrite && _capacity != 0) {
+      pop_front();
+    } else {
+      grow();
+    }
+    _allocator.construct(slot(_size), std::move(value));
+  } else {
+    _allocator.construct(slot(_size), std::forward<Args>(args)...);
+  }
+  return *slot(_size++);
+}
+
+template<typename T, typename A>
+void CircularVector<T, A>::pop_back()
+{
+  _allocator.destroy(slot(--_size));
+}
+
+template<typename T, typename A>
+void CircularVector<T, A>::push_front(const_reference value)
+{
+  emplace_front(value);
+}
+
+template<typename T, typename A>
+void CircularVector<T, A>::push_front(value_type&& value)
+{
+  emplace_front(std::move(value));
+}
+
+template<typename T, typename A>
+template<class... Args>
+typename CircularVector<T, A>::reference CircularVector<T, A>::emplace_front(Args&&... args)
+{
+  if (full()) {
+    value_type value(std::forward<Args>(args)...);
+    if (_overwrite && _capacity != 0) {
+      pop_back();
+    } else {
+      grow();
+    }
+    _allocator.construct(slot(_capacity - 1), std::move(value));
+  } else {
+    _allocator.construct(slot(_capacity - 1), std::forward<Args>(args)...);
+  }
+  _head = (_head - 1) & (_capacity - 1);
+  ++_size;
+  return *slot(0);
+}
+
+template<typename T, typename A>
+void CircularVector<T, A>::pop_front()
+{
+  _allocator.destroy(slot(0));
+  _head = (_head + 1) & (_capacity - 1);
+  --_size;
+}
+
+template<typename T, typename A>
+void CircularVector<T, A>::swap(CircularVector& other) noexcept
+{
+  std::swap(_storage, other._storage);
+  std::swap(_capacity, other._capacity);
+  std::swap(_head, other._head);
+  std::swap(_size, other._size);
+  std::swap(_overwrite, other._overwrite);
+}
+
+template<typename T, typename A>
+void CircularVector<T, A>::clear() noexcept
+{
+  for (size_type i = 0; i < _size; ++i) {
+    _allocator.destroy(slot(i));
+  }
+  _head = 0;
+  _size = 0;
+}
+
+template<typename T, typename A>
+A CircularVector<T, A>::get_allocator() const noexcept
+{
+  return _allocator;
+}
+
+template<typename T, typename A>
+inline typename CircularVector<T, A>::pointer CircularVector<T, A>::slot(size_type i) const noexcept
+{
+  return _storage + ((_head + i) & (_capacity - 1));
+}
+
+/**
+ * Moves the elements, unwrapped, to the start of a new buffer of
+ * newCapacity slots.
+ */
+template<typename T, typename A>
+void CircularVector<T, A>::relocate(size_type newCapacity)
+{
+  pointer newStorage = _allocator.allocate(newCapacity);
+  const size_type frontRun = std::min(_size, _capacity - _head);
+  try {
+    detail::uninitialized_move_n(_allocator, _storage + _head, frontRun, newStorage);
+    try {
+      detail::uninitialized_move_n(_allocator, _storage, _size - frontRun, newStorage + frontRun);
+    } catch (...) {
+      for (size_type i = 0; i < frontRun; ++i) {
+        _allocator.destroy(newStorage + i);
+      }
+      throw;
+    }
+  } catch (...) {
+    _allocator.deallocate(newStorage, newCapacity);
+    throw;
+  }
+  const size_type count = _size;
+  clear();
+  _allocator.deallocate(_storage, _capacity);
+
+  _storage = newStorage;
+  _capacity = newCapacity;
+  _size = count;
+}
+
+template<typename T, typename A>
+void CircularVector<T, A>::grow()
+{
+  relocate(_capacity ? _capacity * 2 : _minCapacity);
+}
+
+} // namespace ctl
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+
+#include "allocator.hpp"
+
+
+namespace ctl {
+
+/**
+ * ctl::ConcurrentVector Definition
+ *
+ * Grow-only vector that many threads may append to and read from at once.
+ * Storage is a table of segments whose sizes double (8, 16, 32, ...), so an
+ * element never moves once constructed and references stay valid for the
+ * lifetime of the container.
+ *
+ * push_back / emplace_back / grow_by claim slots with a single fetch_add and
+ * return the index of the first claimed slot. size() only counts the
+ * published prefix: every element below it is fully constructed and safe to
+ * read from any thread. Segment allocation goes through A and is the only
+ * step that may block, O(log n) times over the container's life.
+ *
+ * An element whose constructor throws, or whose segment cannot be
+ * allocated, is left as a hole: it is still published so later elements
+ * become visible, but at() reports it and the destructor skips it.
+ */
+
+template<typename T, class A = Allocator<T>>
+class ConcurrentVector
+{
+public:
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using difference_type = typename A::difference_type;
+  using reference = typename A::reference;
+  using const_reference = typename A::const_reference;
+  using pointer = typename A::pointer;
+  using const_pointer = typename A::const_pointer;
+
+  ConcurrentVector() {};
+  ConcurrentVector(const ConcurrentVector&) = delete;
+  ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+  ~ConcurrentVector();
+
+  size_type push_back(const_reference);
+  size_type push_back(value_type&&);
+  template<class... Args>
+  size_type emplace_back(Args&&...);
+  size_type grow_by(size_type);
+  size_type grow_by(size_type, const_reference);
+
+  reference operator[](size_type) const;
+  reference at(size_type) const;
+
+  size_type size() const noexcept;
+  size_type claimed() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+
+  A get_allocator() const noexcept;
+
+private:
+  using flag_type = std::atomic<unsigned char>;
+  using flag_allocator = typename std::allocator_traits<A>::template rebind_alloc<flag_type>;
+
+  enum : unsigned char { Pending = 0, Ready = 1, Broken = 2 };
+
+  static constexpr size_type _firstShift = 3;
+  static constexpr size_type _firstSize = size_type(1) << _firstShift;
+  static constexpr size_type _maxSegments = 8 * sizeof(size_type) - _firstShift;
+
+  struct Segment
+  {
+    std::atomic<pointer> items{nullptr};
+    std::atomic<flag_type*> flags{nullptr};
+  };
+
+  A _allocator;
+  flag_allocator _flagAllocator;
+  Segment _segments[_maxSegments];
+  std::atomic<size_type> _claimed{0};
+  std::atomic<size_type> _published{0};
+
+  static size_type segment_of(size_type) noexcept;
+  static size_type segment_size(size_type) noexcept;
+  static size_type segment_start(size_type) noexcept;
+
+  flag_type* ensure_flags(size_type);
+  void ensure(size_type);
+  pointer slot(size_type) const noexcept;
+  flag_type& flag(size_type) const noexcept;
+  template<class... Args>
+  void construct(size_type, Args&&...);
+  void abandon(size_type, size_type);
+  void publish();
+};
+
+
+/**
+ * ctl::ConcurrentVector Implementation
+ */
+
+template<typename T, typename A>
+ConcurrentVector<T, A>::~ConcurrentVector()
+{
+  const size_type count = _claimed.load();
+  for (size_type i = 0; i < count; ++i) {
+    const size_type k = segment_of(i);
+    flag_type* flags = _segments[k].flags.load();
+    if (flags && flags[i - segment_start(k)].load() == Ready) {
+      _allocator.destroy(slot(i));
+    }
+  }
+  for (size_type k = 0; k < _maxSegments; ++k) {
+    pointer items = _segments[k].items.load();
+    flag_type* flags = _segments[k].flags.load();
+    if (items) {
+      _allocator.deallocate(items, segment_size(k));
+    }
+    if (flags) {
+      _flagAllocator.deallocate(flags, segment_size(k));
+    }
+  }
+}
+
+template<typename T, typename A>
+typename ConcurrentVector<T, A>::size_type ConcurrentVector<T, A>::push_back(const_reference value)
+{
+  return emplace_back(value);
+}
+
+template<typename T, typename A>
+typename ConcurrentVector<T, A>::size_type ConcurrentVector<T, A>::push_back(value_type&& value)
+{
+  return emplace_back(std::move(value));
+}
+
+template<typename T, typename A>
+template<class... Args>
+typename ConcurrentVector<T, A>::size_type ConcurrentVector<T, A>::emplace_back(Args&&... args)
+{
+  size_type index = _claimed.fetch_add(1);
+  try {
+    ensure(index);
+    construct(index, std::forward<Args>(args)...);
+  } catch (...) {
+    abandon(index, index + 1);
+    throw;
+  }
+  publish();
+  return index;
+}
+
+template<typename T, typename A>
+typename ConcurrentVector<T, A>::size_type ConcurrentVector<T, A>::grow_by(size_type count)
+{
+  size_type first = _claimed.fetch_add(count);
+  size_type i = first;
+  try {
+    for (; i < first + count; ++i) {
+      ensure(i);
+      construct(i);
+    }
+  } catch (...) {
+    abandon(i, first + count);
+    throw;
+  }
+  publish();
+  return first;
+}
+
+template<typename T, typename A>
+typename ConcurrentVector<T, A>::size_type ConcurrentVector<T, A>::grow_by(size_type count, const_reference value)
+{
+  size_type first = _claimed.fetch_add(count);
+  size_type i = first;
+  try {
+    for (; i < first + count; ++i) {
+      ensure(i);
+      construct(i, value);
+    }
+  } catch (...) {
+    abandon(i, first + count);
+    throw;
+  }
+  publish();
+  return first;
+}
+
+template<typename T, typename A>
+inline typename ConcurrentVector<T, A>::reference ConcurrentVector<T, A>::operator[](size_type i) const
+{
+  return *slot(i);
+}
+
+template<typename T, typename A>
+typename ConcurrentVector<T, A>::reference ConcurrentVector<T, A>::at(size_type i) const
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::ConcurrentVector: out of range");
+  }
+  if (flag(i).load(std::memory_order_acquire) != Ready) {
+    throw std::logic_error("ctl::ConcurrentVector: element construction failed");
+  }
+  return *slot(i);
+}
+
+template<typename T, typename A>
+inline typename ConcurrentVector<T, A>::size_type ConcurrentVector<T, A>::size() const noexcept
+{
+  return _published.load(std::memory_order_acquire);
+}
+
+template<typename T, typename A>
+inline typename ConcurrentVector<T, A>::size_type ConcurrentVector<T, A>::claimed() const noexcept
+{
+  return _claimed.load(std::memory_order_relaxed);
+}
+
+template<typename T, typename A>
+typename ConcurrentVector<T, A>::size_type ConcurrentVector<T, A>::capacity() const noexcept
+{
+  size_type total = 0;
+  for (size_type k = 0; k < _maxSegments && _segments[k].items.load(std::memory_order_relaxed); ++k) {
+    total += segment_size(k);
+  }
+  return total;
+}
+
+template<typename T, typename A>
+inline bool ConcurrentVector<T, A>::empty() const noexcept
+{
+  return size() == 0;
+}
+
+template<typename T, typename A>
+typename ConcurrentVector<T, A>::allocator_type ConcurrentVector<T, A>::get_allocator() const noexcept
+{
+  return _allocator;
+}
+
+template<typename T, typename A>
+inline typename ConcurrentVector<T, A>::size_type ConcurrentVector<T, A>::segment_of(size_type i) noexcept
+{
+  size_type x = (i >> _firstShift) + 1;
+  size_type k = 0;
+#if defined(__GNUC__)
+  k = 8 * sizeof(unsigned long long) - 1 - __builtin_clzll(x);
+#else
+  while (x >>= 1) ++k;
+#endif
+  return k;
+}
+
+template<typename T, typename A>
+inline typename ConcurrentVector<T, A>::size_type ConcurrentVector<T, A>::segment_size(size_type k) noexcept
+{
+  return _firstSize << k;
+}
+
+template<typename T, typename A>
+inline typename ConcurrentVector<T, A>::size_type ConcurrentVector<T, A>::segment_start(size_type k) noexcept
+{
+  return _firstSize * ((size_type(1) << k) - 1);
+}
+
+/**
+ * Returns the flags of segment k, allocating them if no thread has yet.
+ */
+template<typename T, typename A>
+typename ConcurrentVector<T, A>::flag_type* ConcurrentVector<T, A>::ensure_flags(size_type k)
+{
+  Segment& segment = _segments[k];
+  flag_type* existing = segment.flags.load(std::memory_order_acquire);
+  if (existing) return existing;
+
+  const size_type count = segment_size(k);
+  flag_type* flags = _flagAllocator.allocate(count);
+  for (size_type j = 0; j < count; ++j) {
+    ::new (static_cast<void*>(flags + j)) flag_type(Pending);
+  }
+  if (!segment.flags.compare_exchange_strong(existing, flags, std::memory_order_acq_rel)) {
+    _flagAllocator.deallocate(flags, count);
+    return existing;
+  }
+  return flags;
+}
+
+template<typename T, typename A>
+void ConcurrentVector<T, A>::ensure(size_type i)
+{
+  const size_type k = segment_of(i);
+  Segment& segment = _segments[k];
+  if (segment.items.load(std::memory_order_acquire)) return;
+
+  ensure_flags(k);
+  const size_type count = segment_size(k);
+  pointer items = _allocator.allocate(count);
+  pointer noItems = nullptr;
+  if (!segment.items.compare_exchange_strong(noItems, items)) {
+    _allocator.deallocate(items, count);
+  }
+}
+
+template<typename T, typename A>
+inline typename ConcurrentVector<T, A>::pointer ConcurrentVector<T, A>::slot(size_type i) const noexcept
+{
+  const size_type k = segment_of(i);
+  return _segments[k].items.load(std::memory_order_acquire) + (i - segment_start(k));
+}
+
+template<typename T, typename A>
+inline typename ConcurrentVector<T, A>::flag_type& ConcurrentVector<T, A>::flag(size_type i) const noexcept
+{
+  const size_type k = segment_of(i);
+  return _segments[k].flags.load(std::memory_order_acquire)[i - segment_start(k)];
+}
+
+template<typename T, typename A>
+template<class... Args>
+void ConcurrentVector<T, A>::construct(size_type i, Args&&... args)
+{
+  _allocator.construct(slot(i), std::forward<Args>(args)...);
+  flag(i).store(Ready, std::memory_order_release);
+}
+
+/**
+ * Marks the claimed slots [first, last) that were never constructed as
+ * Broken and publishes them, so a failed append leaves holes instead of
+ * freezing size(). Only the flags are needed for that, not the items, so
+ * this still works after the items allocation has failed.
+ */
+template<typename T, typename A>
+void ConcurrentVector<T, A>::abandon(size_type first, size_type last)
+{
+  for (size_type i = first; i < last; ++i) {
+    const size_type k = segment_of(i);
+    ensure_flags(k)[i - segment_start(k)].store(Broken, std::memory_order_release);
+  }
+  publish();
+}
+
+/**
+ * Advances _published over every finished slot. Each caller has just
+ * stored its own slot's flag and now loads its neighbours' flags, which is
+ * the store-buffering pattern: with acquire/release alone, two threads
+ * finishing adjacent slots may each miss the other's store and return, and
+ * the later slot stays unpublished until some unrelated append. The
+ * seq_cst fence orders the flag store before these loads, so at least one
+ * of the two threads sees both slots finished.
+ */
+template<typename T, typename A>
+void ConcurrentVector<T, A>::publish()
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  size_type p = _published.load(std::memory_order_acquire);
+  while (p < _claimed.load(std::memory_order_acquire)) {
+    size_type k = segment_of(p);
+    flag_type* flags = _segments[k].flags.load(std::memory_order_acquire);
+    if (!flags || flags[p - segment_start(k)].load(std::memory_order_acquire) == Pending) return;
+    if (_published.compare_exchange_weak(p, p + 1, std::memory_order_acq_rel)) {
+      ++p;
+    }
+  }
+}
+
+} // namespace ctl
@@ -0,0 +1,513 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <initializer_list>
+
+#include "allocator.hpp"
+#include "vector.hpp"
+
+
+namespace ctl {
+
+/**
+ * ctl::CowVector Definition
+ *
+ * Copy-on-write handle to a reference-counted ctl::Vector. Copying a
+ * CowVector only bumps an atomic count, so handing the same data to many
+ * readers is O(1) per reader. The first non-const access on a handle whose
+ * buffer is shared clones it (one element-wise copy) and the handle owns
+ * its own buffer from then on.
+ *
+ * Const members never copy. Non-const begin() / operator[] / data() etc.
+ * count as mutations even if nothing is written, so readers should go
+ * through a const reference or cbegin() / cend(). Pointers and iterators
+ * obtained from non-const access must not be used after the handle has been
+ * copied, since the copy shares the buffer they point into.
+ *
+ * Handles may be copied and destroyed from any thread; a single handle is
+ * not safe to mutate concurrently, just like ctl::Vector.
+ */
+
+template<typename T, class A = Allocator<T>>
+class CowVector
+{
+public:
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using difference_type = typename A::difference_type;
+  using reference = typename A::reference;
+  using const_reference = typename A::const_reference;
+  using pointer = typename A::pointer;
+  using const_pointer = typename A::const_pointer;
+  using iterator = typename Vector<T, A>::iterator;
+  using const_iterator = typename Vector<T, A>::const_iterator;
+
+  CowVector() noexcept {};
+  CowVector(const CowVector&) noexcept;
+  CowVector(CowVector&&) noexcept;
+  CowVector(size_type);
+  CowVector(size_type, const_reference);
+  CowVector(std::initializer_list<T>);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  CowVector(IteratorType, IteratorType);
+  explicit CowVector(const Vector<T, A>&);
+  explicit CowVector(Vector<T, A>&&);
+
+  ~CowVector();
+
+  CowVector& operator=(const CowVector&) noexcept;
+  CowVector& operator=(CowVector&&) noexcept;
+  CowVector& operator=(std::initializer_list<T>);
+
+  iterator begin();
+  iterator end();
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+  size_type use_count() const noexcept;
+  void resize(size_type);
+  void resize(size_type, const_reference);
+  void reserve(size_type);
+  void shrink_to_fit();
+
+  reference at(size_type);
+  const_reference at(size_type) const;
+  reference operator[](size_type);
+  const_reference operator[](size_type) const noexcept;
+  reference front();
+  const_reference front() const noexcept;
+  reference back();
+  const_reference back() const noexcept;
+  pointer data();
+  const_pointer data() const noexcept;
+
+  void assign(size_type, const_reference);
+  void assign(std::initializer_list<T>);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  void assign(IteratorType, IteratorType);
+
+  void push_back(const_reference);
+  void push_back(value_type&&);
+  template<class... Args>
+  iterator emplace_back(Args&&...);
+  void pop_back();
+
+  iterator insert(iterator, const_reference);
+  iterator insert(iterator, size_type, const_reference);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  iterator insert(iterator, IteratorType, IteratorType);
+  template<class... Args>
+  iterator emplace(iterator, Args&&...);
+  iterator erase(iterator);
+  iterator erase(iterator, iterator);
+
+  void swap(CowVector&) noexcept;
+  void clear() noexcept;
+
+private:
+  struct Buffer
+  {
+    std::atomic<size_type> refs;
+    Vector<T, A> items;
+
+    template<class... Args>
+    Buffer(Args&&... args) : refs(1), items(std::forward<Args>(args)...) {}
+  };
+
+  // Buffers are carved out of whole words rather than a pool of their own:
+  // ctl::Allocator reserves FIXED_SIZE elements per type up front, which is
+  // far too much address space for an object the size of Buffer.
+  using word_type = std::uint64_t;
+  using word_allocator = typename std::allocator_traits<A>::template rebind_alloc<word_type>;
+
+  static constexpr size_type _bufferWords = (sizeof(Buffer) + sizeof(word_type) - 1) / sizeof(word_type);
+  static_assert(alignof(Buffer) <= alignof(word_type), "ctl::CowVector: buffer needs stronger alignment than a word");
+
+  word_allocator _allocator;
+  Buffer* _buffer = nullptr;
+
+  template<class... Args>
+  Buffer* make(Args&&...);
+  void release() noexcept;
+  Vector<T, A>& unshare();
+  Vector<T, A>& fresh();
+};
+
+
+/**
+ * ctl::CowVector Implementation
+ */
+
+template<typename T, class A>
+CowVector<T, A>::CowVector(const CowVector& other) noexcept : _buffer(other._buffer)
+{
+  if (_buffer) {
+    _buffer->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+template<typename T, class A>
+CowVector<T, A>::CowVector(CowVector&& other) noexcept
+{
+  swap(other);
+}
+
+template<typename T, class A>
+CowVector<T, A>::CowVector(size_type count) : _buffer(make(count)) {}
+
+template<typename T, class A>
+CowVector<T, A>::CowVector(size_type count, const_reference value) : _buffer(make(count, value)) {}
+
+template<typename T, class A>
+CowVector<T, A>::CowVector(std::initializer_list<T> list) : _buffer(make(list)) {}
+
+template<typename T, class A>
+template<typename IteratorType, typename isIterator>
+CowVector<T, A>::CowVector(IteratorType first, IteratorType last) : _buffer(make(first, last)) {}
+
+template<typename T, class A>
+CowVector<T, A>::CowVector(const Vector<T, A>& other) : _buffer(make(other)) {}
+
+template<typename T, class A>
+CowVector<T, A>::CowVector(Vector<T, A>&& other) : _buffer(make())
+{
+  _buffer->items.swap(other);
+}
+
+template<typename T, class A>
+CowVector<T, A>::~CowVector()
+{
+  release();
+}
+
+template<typename T, class A>
+CowVector<T, A>& CowVector<T, A>::operator=(const CowVector& other) noexcept
+{
+  CowVector copy(other);
+  swap(copy);
+  return *this;
+}
+
+template<typename T, class A>
+CowVector<T, A>& CowVector<T, A>::operator=(CowVector&& other) noexcept
+{
+  CowVector moved(std::move(other));
+  swap(moved);
+  return *this;
+}
+
+template<typename T, class A>
+CowVector<T, A>& CowVector<T, A>::operator=(std::initializer_list<T> list)
+{
+  assign(list);
+  return *this;
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::iterator CowVector<T, A>::begin()
+{
+  return unshare().begin();
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::iterator CowVector<T, A>::end()
+{
+  return unshare().end();
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::const_iterator CowVector<T, A>::cbegin() const noexcept
+{
+  return const_iterator(data());
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::const_iterator CowVector<T, A>::cend() const noexcept
+{
+  return const_iterator(data() + size());
+}
+
+template<typename T, class A>
+inline typename CowVector<T, A>::size_type CowVector<T, A>::size() const noexcept
+{
+  return _buffer ? _buffer->items.size() : 0;
+}
+
+template<typename T, class A>
+inline typename CowVector<T, A>::size_type CowVector<T, A>::capacity() const noexcept
+{
+  return _buffer ? _buffer->items.capacity() : 0;
+}
+
+template<typename T, class A>
+inline bool CowVector<T, A>::empty() const noexcept
+{
+  return size() == 0;
+}
+
+/**
+ * Number of handles sharing this buffer, 0 for a handle that has none yet.
+ */
+template<typename T, class A>
+typename CowVector<T, A>::size_type CowVector<T, A>::use_count() const noexcept
+{
+  return _buffer ? _buffer->refs.load(std::memory_order_acquire) : 0;
+}
+
+template<typename T, class A>
+void CowVector<T, A>::resize(size_type newSize)
+{
+  unshare().resize(newSize);
+}
+
+template<typename T, class A>
+void CowVector<T, A>::resize(size_type newSize, const_reference value)
+{
+  fresh().resize(newSize, value);
+}
+
+template<typename T, class A>
+void CowVector<T, A>::reserve(size_type newCapacity)
+{
+  if (newCapacity > capacity()) {
+    unshare().reserve(newCapacity);
+  }
+}
+
+template<typename T, class A>
+void CowVector<T, A>::shrink_to_fit()
+{
+  if (_buffer && size() != capacity()) {
+    unshare().shrink_to_fit();
+  }
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::reference CowVector<T, A>::at(size_type i)
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::CowVector: out of range");
+  }
+  return unshare()[i];
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::const_reference CowVector<T, A>::at(size_type i) const
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::CowVector: out of range");
+  }
+  return (*this)[i];
+}
+
+template<typename T, class A>
+inline typename CowVector<T, A>::reference CowVector<T, A>::operator[](size_type i)
+{
+  return unshare()[i];
+}
+
+template<typename T, class A>
+inline typename CowVector<T, A>::const_reference CowVector<T, A>::operator[](size_type i) const noexcept
+{
+  return _buffer->items[i];
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::reference CowVector<T, A>::front()
+{
+  return unshare().front();
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::const_reference CowVector<T, A>::front() const noexcept
+{
+  return (*this)[0];
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::reference CowVector<T, A>::back()
+{
+  return unshare().back();
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::const_reference CowVector<T, A>::back() const noexcept
+{
+  return (*this)[size() - 1];
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::pointer CowVector<T, A>::data()
+{
+  return unshare().data();
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::const_pointer CowVector<T, A>::data() const noexcept
+{
+  return _buffer ? _buffer->items.data() : nullptr;
+}
+
+template<typename T, class A>
+void CowVector<T, A>::assign(size_type count, const_reference value)
+{
+  fresh().assign(count, value);
+}
+
+template<typename T, class A>
+void CowVector<T, A>::assign(std::initializer_list<T> list)
+{
+  fresh().assign(list);
+}
+
+template<typename T, class A>
+template<typename IteratorType, typename isIterator>
+void CowVector<T, A>::assign(IteratorType first, IteratorType last)
+{
+  fresh().assign(first, last);
+}
+
+template<typename T, class A>
+void CowVector<T, A>::push_back(const_reference value)
+{
+  unshare().push_back(value);
+}
+
+template<typename T, class A>
+void CowVector<T, A>::push_back(value_type&& value)
+{
+  unshare().push_back(std::move(value));
+}
+
+template<typename T, class A>
+template<class... Args>
+typename CowVector<T, A>::iterator CowVector<T, A>::emplace_back(Args&&... args)
+{
+  return unshare().emplace_back(std::forward<Args>(args)...);
+}
+
+template<typename T, class A>
+void CowVector<T, A>::pop_back()
+{
+  unshare().pop_back();
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::iterator CowVector<T, A>::insert(iterator it, const_reference value)
+{
+  return unshare().insert(it, value);
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::iterator CowVector<T, A>::insert(iterator it, size_type count, const_reference value)
+{
+  return unshare().insert(it, count, value);
+}
+
+template<typename T, class A>
+template<typename IteratorType, typename isIterator>
+typename CowVector<T, A>::iterator CowVector<T, A>::insert(iterator it, IteratorType first, IteratorType last)
+{
+  return unshare().insert(it, first, last);
+}
+
+template<typename T, class A>
+template<class... Args>
+typename CowVector<T, A>::iterator CowVector<T, A>::emplace(iterator it, Args&&... args)
+{
+  return unshare().emplace(it, std::forward<Args>(args)...);
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::iterator CowVector<T, A>::erase(iterator it)
+{
+  return unshare().erase(it);
+}
+
+template<typename T, class A>
+typename CowVector<T, A>::iterator CowVector<T, A>::erase(iterator first, iterator last)
+{
+  return unshare().erase(first, last);
+}
+
+template<typename T, class A>
+void CowVector<T, A>::swap(CowVector& other) noexcept
+{
+  std::swap(_buffer, other._buffer);
+}
+
+/**
+ * Drops this handle's reference; other handles keep the old contents.
+ */
+template<typename T, class A>
+void CowVector<T, A>::clear() noexcept
+{
+  release();
+  _buffer = nullptr;
+}
+
+template<typename T, class A>
+template<class... Args>
+typename CowVector<T, A>::Buffer* CowVector<T, A>::make(Args&&... args)
+{
+  word_type* words = _allocator.allocate(_bufferWords);
+  try {
+    return ::new (static_cast<void*>(words)) Buffer(std::forward<Args>(args)...);
+  } catch (...) {
+    _allocator.deallocate(words, _bufferWords);
+    throw;
+  }
+}
+
+template<typename T, class A>
+void CowVector<T, A>::release() noexcept
+{
+  if (_buffer && _buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    _buffer->~Buffer();
+    _allocator.deallocate(reinterpret_cast<word_type*>(_buffer), _bufferWords);
+  }
+}
+
+/**
+ * Returns a buffer this handle owns alone, cloning the shared one first.
+ */
+template<typename T, class A>
+Vector<T, A>& CowVector<T, A>::unshare()
+{
+  if (!_buffer) {
+    _buffer = make();
+  } else if (_buffer->refs.load(std::memory_order_acquire) != 1) {
+    Buffer* copy = make(_buffer->items);
+    release();
+    _buffer = copy;
+  }
+  return _buffer->items;
+}
+
+/**
+ * Like unshare(), for callers that overwrite every element anyway: a shared
+ * buffer is dropped instead of cloned.
+ */
+template<typename T, class A>
+Vector<T, A>& CowVector<T, A>::fresh()
+{
+  if (_buffer && _buffer->refs.load(std::memory_order_acquire) != 1) {
+    release();
+    _buffer = nullptr;
+  }
+  if (!_buffer) {
+    _buffer = make();
+  }
+  return _buffer->items;
+}
+
+} // namespace ctl
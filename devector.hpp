@@ -0,0 +1,571 @@
+#pragma once
+
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <initializer_list>
+
+#include "allocator.hpp"
+#include "iterator.hpp"
+#include "parallel_copy.hpp"
+
+
+namespace ctl {
+
+/**
+ * ctl::Devector Definition
+ *
+ * Contiguous vector with spare capacity in front of the first element as
+ * well as after the last one, so push_front / pop_front are amortized O(1)
+ * just like their back counterparts. Single-element insert and erase shift
+ * whichever side of the position is shorter.
+ *
+ * When one end runs out of room while the buffer is at most half full, the
+ * elements are re-centred in a buffer of the same capacity instead of
+ * growing it; this keeps queue-style use (push_back + pop_front) bounded.
+ */
+
+template<typename T, class A = Allocator<T>>
+class Devector
+{
+public:
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using difference_type = typename A::difference_type;
+  using reference = typename A::reference;
+  using const_reference = typename A::const_reference;
+  using pointer = typename A::pointer;
+  using const_pointer = typename A::const_pointer;
+  using iterator = ctl::Iterator<T>;
+  using const_iterator = ctl::Iterator<const T>;
+
+  Devector() {};
+  Devector(const Devector&);
+  Devector(Devector&&);
+  Devector(size_type);
+  Devector(size_type, const_reference);
+  Devector(std::initializer_list<T>);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  Devector(IteratorType, IteratorType);
+
+  ~Devector();
+
+  Devector& operator=(const Devector&);
+  Devector& operator=(Devector&&);
+
+  iterator begin() noexcept;
+  iterator end() noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  size_type capacity() const noexcept;
+  size_type front_free_capacity() const noexcept;
+  size_type back_free_capacity() const noexcept;
+  bool empty() const noexcept;
+  void reserve(size_type);
+  void reserve_front(size_type);
+  void shrink_to_fit();
+  void resize(size_type);
+  void resize(size_type, const_reference);
+
+  reference at(size_type);
+  const_reference at(size_type) const;
+  reference operator[](size_type) noexcept;
+  const_reference operator[](size_type) const noexcept;
+  reference front();
+  reference back();
+  pointer data() noexcept;
+
+  void push_back(const_reference);
+  void push_back(value_type&&);
+  template<class... Args>
+  reference emplace_back(Args&&...);
+  void pop_back();
+
+  void push_front(const_reference);
+  void push_front(value_type&&);
+  template<class... Args>
+  reference emplace_front(Args&&...);
+  void pop_front();
+
+  iterator insert(iterator, const_reference);
+  iterator insert(iterator, value_type&&);
+  template<class... Args>
+  iterator emplace(iterator, Args&&...);
+  iterator erase(iterator);
+  iterator erase(iterator, iterator);
+
+  void swap(Devector&) noexcept;
+  void clear() noexcept;
+
+  A get_allocator() const noexcept;
+
+private:
+  static constexpr float _growthFactor = 1.5f;
+
+  A _allocator;
+  pointer _storage = nullptr;
+  pointer _begin = nullptr;
+  pointer _last = nullptr;
+  pointer _end = nullptr;
+
+  void relocate(size_type, size_type);
+  void grow_front(size_type);
+  void grow_back(size_type);
+  void destroy(pointer, pointer) noexcept;
+};
+
+
+/**
+ * ctl::Devector Implementation
+ */
+
+template<typename T, typename A>
+Devector<T, A>::Devector(const Devector& other)
+{
+  if (other.empty()) return;
+  _storage = _allocator.allocate(other.size());
+  try {
+    detail::uninitialized_copy_n(_allocator, other._begin, other.size(), _storage);
+  } catch (...) {
+    _allocator.deallocate(_storage, other.size());
+    throw;
+  }
+  _begin = _storage;
+  _last = _end = _storage + other.size();
+}
+
+template<typename T, typename A>
+Devector<T, A>::Devector(Devector&& other)
+{
+  swap(other);
+}
+
+template<typename T, typename A>
+Devector<T, A>::Devector(size_type count)
+{
+  resize(count);
+}
+
+template<typename T, typename A>
+Devector<T, A>::Devector(size_type count, const_reference value)
+{
+  resize(count, value);
+}
+
+template<typename T, typename A>
+Devector<T, A>::Devector(std::initializer_list<T> list) : Devector(list.begin(), list.end()) {}
+
+template<typename T, typename A>
+template<typename IteratorType, typename isIterator>
+Devector<T, A>::Devector(IteratorType first, IteratorType last)
+{
+  for (; first != last; ++first) {
+    emplace_back(*first);
+  }
+}
+
+template<typename T, typename A>
+Devector<T, A>::~Devector()
+{
+  destroy(_begin, _last);
+  _allocator.deallocate(_storage, capacity());
+}
+
+template<typename T, typename A>
+Devector<T, A>& Devector<T, A>::operator=(const Devector& other)
+{
+  if (this == &other) return *this;
+  Devector copy(other);
+  swap(copy);
+  return *this;
+}
+
+template<typename T, typename A>
+Devector<T, A>& Devector<T, A>::operator=(Devector&& other)
+{
+  if (this == &other) return *this;
+  Devector moved(std::move(other));
+  swap(moved);
+  return *this;
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::iterator Devector<T, A>::begin() noexcept
+{
+  return iterator(_begin);
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::iterator Devector<T, A>::end() noexcept
+{
+  return iterator(_last);
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::const_iterator Devector<T, A>::cbegin() const noexcept
+{
+  return const_iterator(_begin);
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::const_iterator Devector<T, A>::cend() const noexcept
+{
+  return const_iterator(_last);
+}
+
+template<typename T, typename A>
+inline typename Devector<T, A>::size_type Devector<T, A>::size() const noexcept
+{
+  return _last - _begin;
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::size_type Devector<T, A>::max_size() const noexcept
+{
+  return static_cast<size_type>(-1) / sizeof(T);
+}
+
+template<typename T, typename A>
+inline typename Devector<T, A>::size_type Devector<T, A>::capacity() const noexcept
+{
+  return _end - _storage;
+}
+
+template<typename T, typename A>
+inline typename Devector<T, A>::size_type Devector<T, A>::front_free_capacity() const noexcept
+{
+  return _begin - _storage;
+}
+
+template<typename T, typename A>
+inline typename Devector<T, A>::size_type Devector<T, A>::back_free_capacity() const noexcept
+{
+  return _end - _last;
+}
+
+template<typename T, typename A>
+inline bool Devector<T, A>::empty() const noexcept
+{
+  return _begin == _last;
+}
+
+template<typename T, typename A>
+void Devector<T, A>::reserve(size_type newCapacity)
+{
+  if (newCapacity > max_size()) {
+    throw std::length_error("ctl::Devector: too big capacity to reserve");
+  }
+  if (newCapacity > size() + back_free_capacity()) {
+    relocate(front_free_capacity(), newCapacity - size());
+  }
+}
+
+template<typename T, typename A>
+void Devector<T, A>::reserve_front(size_type newCapacity)
+{
+  if (newCapacity > max_size()) {
+    throw std::length_error("ctl::Devector: too big capacity to reserve");
+  }
+  if (newCapacity > size() + front_free_capacity()) {
+    relocate(newCapacity - size(), back_free_capacity());
+  }
+}
+
+template<typename T, typename A>
+void Devector<T, A>::shrink_to_fit()
+{
+  if (size() != capacity()) {
+    relocate(0, 0);
+  }
+}
+
+template<typename T, typename A>
+void Devector<T, A>::resize(size_type newSize)
+{
+  if (newSize < size()) {
+    destroy(_begin + newSize, _last);
+    _last = _begin + newSize;
+    return;
+  }
+  reserve(newSize);
+  while (size() < newSize) {
+    emplace_back();
+  }
+}
+
+template<typename T, typename A>
+void Devector<T, A>::resize(size_type newSize, const_reference value)
+{
+  if (newSize < size()) {
+    destroy(_begin + newSize, _last);
+    _last = _begin + newSize;
+    return;
+  }
+  reserve(newSize);
+  while (size() < newSize) {
+    emplace_back(value);
+  }
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::reference Devector<T, A>::at(size_type i)
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::Devector: out of range");
+  }
+  return _begin[i];
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::const_reference Devector<T, A>::at(size_type i) const
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::Devector: out of range");
+  }
+  return _begin[i];
+}
+
+template<typename T, typename A>
+inline typename Devector<T, A>::reference Devector<T, A>::operator[](size_type i) noexcept
+{
+  return _begin[i];
+}
+
+template<typename T, typename A>
+inline typename Devector<T, A>::const_reference Devector<T, A>::operator[](size_type i) const noexcept
+{
+  return _begin[i];
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::reference Devector<T, A>::front()
+{
+  return *_begin;
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::reference Devector<T, A>::back()
+{
+  return *(_last - 1);
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::pointer Devector<T, A>::data() noexcept
+{
+  return _begin;
+}
+
+template<typename T, typename A>
+void Devector<T, A>::push_back(const_reference value)
+{
+  emplace_back(value);
+}
+
+template<typename T, typename A>
+void Devector<T, A>::push_back(value_type&& value)
+{
+  emplace_back(std::move(value));
+}
+
+template<typename T, typename A>
+template<class... Args>
+typename Devector<T, A>::reference Devector<T, A>::emplace_back(Args&&... args)
+{
+  if (_last == _end) {
+    value_type value(std::forward<Args>(args)...);
+    grow_back(1);
+    _allocator.construct(_last, std::move(value));
+  } else {
+    _allocator.construct(_last, std::forward<Args>(args)...);
+  }
+  return *(_last++);
+}
+
+template<typename T, typename A>
+void Devector<T, A>::pop_back()
+{
+  _allocator.destroy(--_last);
+}
+
+template<typename T, typename A>
+void Devector<T, A>::push_front(const_reference value)
+{
+  emplace_front(value);
+}
+
+template<typename T, typename A>
+void Devector<T, A>::push_front(value_type&& value)
+{
+  emplace_front(std::move(value));
+}
+
+template<typename T, typename A>
+template<class... Args>
+typename Devector<T, A>::reference Devector<T, A>::emplace_front(Args&&... args)
+{
+  if (_begin == _storage) {
+    value_type value(std::forward<Args>(args)...);
+    grow_front(1);
+    _allocator.construct(_begin - 1, std::move(value));
+  } else {
+    _allocator.construct(_begin - 1, std::forward<Args>(args)...);
+  }
+  return *(--_begin);
+}
+
+template<typename T, typename A>
+void Devector<T, A>::pop_front()
+{
+  _allocator.destroy(_begin++);
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::iterator Devector<T, A>::insert(iterator it, const_reference value)
+{
+  return emplace(it, value);
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::iterator Devector<T, A>::insert(iterator it, value_type&& value)
+{
+  return emplace(it, std::move(value));
+}
+
+template<typename T, typename A>
+template<class... Args>
+typename Devector<T, A>::iterator Devector<T, A>::emplace(iterator it, Args&&... args)
+{
+  const size_type index = it - begin();
+  const size_type count = size();
+  if (index == 0) {
+    emplace_front(std::forward<Args>(args)...);
+    return begin();
+  }
+  if (index == count) {
+    emplace_back(std::forward<Args>(args)...);
+    return end() - 1;
+  }
+
+  value_type value(std::forward<Args>(args)...);
+  if (index < count - index) {
+    grow_front(1);
+    _allocator.construct(_begin - 1, std::move(*_begin));
+    --_begin;
+    std::move(_begin + 2, _begin + index + 1, _begin + 1);
+  } else {
+    grow_back(1);
+    _allocator.construct(_last, std::move(*(_last - 1)));
+    ++_last;
+    std::move_backward(_begin + index, _last - 2, _last - 1);
+  }
+  _begin[index] = std::move(value);
+  return begin() + index;
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::iterator Devector<T, A>::erase(iterator it)
+{
+  return erase(it, it + 1);
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::iterator Devector<T, A>::erase(iterator first, iterator last)
+{
+  const size_type index = first - begin();
+  const size_type count = last - first;
+  if (count == 0) return first;
+
+  if (index < size() - index - count) {
+    std::move_backward(_begin, _begin + index, _begin + index + count);
+    destroy(_begin, _begin + count);
+    _begin += count;
+  } else {
+    std::move(_begin + index + count, _last, _begin + index);
+    destroy(_last - count, _last);
+    _last -= count;
+  }
+  return begin() + index;
+}
+
+template<typename T, typename A>
+void Devector<T, A>::swap(Devector& other) noexcept
+{
+  std::swap(_storage, other._storage);
+  std::swap(_begin, other._begin);
+  std::swap(_last, other._last);
+  std::swap(_end, other._end);
+}
+
+template<typename T, typename A>
+void Devector<T, A>::clear() noexcept
+{
+  destroy(_begin, _last);
+  _begin = _last = _storage + capacity() / 2;
+}
+
+template<typename T, typename A>
+typename Devector<T, A>::allocator_type Devector<T, A>::get_allocator() const noexcept
+{
+  return _allocator;
+}
+
+template<typename T, typename A>
+void Devector<T, A>::relocate(size_type frontRoom, size_type backRoom)
+{
+  const size_type count = size();
+  const size_type newCapacity = frontRoom + count + backRoom;
+  pointer newStorage = newCapacity ? _allocator.allocate(newCapacity) : nullptr;
+  try {
+    detail::uninitialized_move_n(_allocator, _begin, count, newStorage + frontRoom);
+  } catch (...) {
+    _allocator.deallocate(newStorage, newCapacity);
+    throw;
+  }
+  destroy(_begin, _last);
+  _allocator.deallocate(_storage, capacity());
+
+  _storage = newStorage;
+  _begin = newStorage + frontRoom;
+  _last = _begin + count;
+  _end = newStorage + newCapacity;
+}
+
+template<typename T, typename A>
+void Devector<T, A>::grow_front(size_type n)
+{
+  if (front_free_capacity() >= n) return;
+  const size_type needed = size() + n;
+  size_type newCapacity = capacity();
+  if (needed * 2 > newCapacity) {
+    newCapacity = std::max<size_type>(needed * _growthFactor, needed + 1);
+  }
+  const size_type spare = newCapacity - needed;
+  relocate(n + spare - spare / 2, spare / 2);
+}
+
+template<typename T, typename A>
+void Devector<T, A>::grow_back(size_type n)
+{
+  if (back_free_capacity() >= n) return;
+  const size_type needed = size() + n;
+  size_type newCapacity = capacity();
+  if (needed * 2 > newCapacity) {
+    newCapacity = std::max<size_type>(needed * _growthFactor, needed + 1);
+  }
+  const size_type spare = newCapacity - needed;
+  relocate(spare / 2, n + spare - spare / 2);
+}
+
+template<typename T, typename A>
+void Devector<T, A>::destroy(pointer first, pointer last) noexcept
+{
+  for (; first != last; ++first) {
+    _allocator.destroy(first);
+  }
+}
+
+} // namespace ctl
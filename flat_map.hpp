@@ -0,0 +1,478 @@
+#pragma once
+
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+#include <initializer_list>
+
+#include "allocator.hpp"
+#include "vector.hpp"
+
+
+namespace ctl {
+
+/**
+ * Search structure used by FlatMap / FlatSet lookups. Sorted runs a
+ * branch-free binary search over the element array. Eytzinger additionally
+ * keeps a copy of the keys in BFS (Eytzinger) order, rebuilt after every
+ * modification, so the first levels of every search share a few cache
+ * lines; it pays off for large, rarely modified tables and requires a
+ * default-constructible key type.
+ */
+
+enum class FlatLayout {Sorted, Eytzinger};
+
+
+namespace detail {
+
+struct KeyOfValue
+{
+  template<typename T>
+  const T& operator()(const T& value) const noexcept { return value; }
+};
+
+struct KeyOfPair
+{
+  template<typename P>
+  const typename P::first_type& operator()(const P& value) const noexcept { return value.first; }
+};
+
+/**
+ * ctl::detail::FlatTable Definition
+ *
+ * Sorted, duplicate-free ctl::Vector of values shared by FlatMap and
+ * FlatSet. Lookups are O(log n) over contiguous memory; single inserts and
+ * erases shift the tail, while range inserts append, sort the new block and
+ * merge it in, so a batch of m values costs O(n + m log m).
+ */
+
+template<typename Key, typename Value, typename KeyOf, class Compare, class A, FlatLayout L>
+class FlatTable
+{
+public:
+  using key_type = Key;
+  using value_type = Value;
+  using key_compare = Compare;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using difference_type = typename A::difference_type;
+  using reference = typename A::reference;
+  using const_reference = typename A::const_reference;
+  using iterator = typename Vector<Value, A>::iterator;
+  using const_iterator = typename Vector<Value, A>::const_iterator;
+
+  FlatTable() {};
+  explicit FlatTable(const Compare&);
+  FlatTable(std::initializer_list<Value>);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  FlatTable(IteratorType, IteratorType);
+
+  iterator begin() noexcept;
+  iterator end() noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+  void reserve(size_type);
+  void shrink_to_fit();
+
+  iterator find(const Key&);
+  const_iterator find(const Key&) const;
+  size_type count(const Key&) const;
+  bool contains(const Key&) const;
+  iterator lower_bound(const Key&);
+  iterator upper_bound(const Key&);
+
+  std::pair<iterator, bool> insert(const Value&);
+  std::pair<iterator, bool> insert(Value&&);
+  void insert(std::initializer_list<Value>);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  void insert(IteratorType, IteratorType);
+
+  size_type erase(const Key&);
+  iterator erase(iterator);
+  iterator erase(iterator, iterator);
+
+  void swap(FlatTable&);
+  void clear() noexcept;
+
+  key_compare key_comp() const;
+
+protected:
+  Vector<Value, A> _items;
+  Compare _compare;
+
+  size_type lower_index(const Key&) const;
+  bool matches(size_type, const Key&) const;
+  template<typename V>
+  std::pair<iterator, bool> insert_unique(V&&);
+  void rebuild();
+
+private:
+  using key_allocator = typename std::allocator_traits<A>::template rebind_alloc<Key>;
+  using index_allocator = typename std::allocator_traits<A>::template rebind_alloc<size_type>;
+
+  Vector<Key, key_allocator> _tree;
+  Vector<size_type, index_allocator> _rank;
+
+  bool less(const Value&, const Value&) const;
+  void normalize(size_type);
+  size_type build(size_type, size_type);
+};
+
+
+/**
+ * ctl::detail::FlatTable Implementation
+ */
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+FlatTable<K, V, KO, C, A, L>::FlatTable(const C& compare) : _compare(compare) {}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+FlatTable<K, V, KO, C, A, L>::FlatTable(std::initializer_list<V> list) : FlatTable(list.begin(), list.end()) {}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+template<typename IteratorType, typename isIterator>
+FlatTable<K, V, KO, C, A, L>::FlatTable(IteratorType first, IteratorType last) : _items(first, last)
+{
+  normalize(0);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::iterator FlatTable<K, V, KO, C, A, L>::begin() noexcept
+{
+  return _items.begin();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::iterator FlatTable<K, V, KO, C, A, L>::end() noexcept
+{
+  return _items.end();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::const_iterator FlatTable<K, V, KO, C, A, L>::cbegin() const noexcept
+{
+  return _items.cbegin();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::const_iterator FlatTable<K, V, KO, C, A, L>::cend() const noexcept
+{
+  return _items.cend();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+inline typename FlatTable<K, V, KO, C, A, L>::size_type FlatTable<K, V, KO, C, A, L>::size() const noexcept
+{
+  return _items.size();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+inline typename FlatTable<K, V, KO, C, A, L>::size_type FlatTable<K, V, KO, C, A, L>::capacity() const noexcept
+{
+  return _items.capacity();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+inline bool FlatTable<K, V, KO, C, A, L>::empty() const noexcept
+{
+  return _items.empty();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+void FlatTable<K, V, KO, C, A, L>::reserve(size_type newCapacity)
+{
+  _items.reserve(newCapacity);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+void FlatTable<K, V, KO, C, A, L>::shrink_to_fit()
+{
+  _items.shrink_to_fit();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::iterator FlatTable<K, V, KO, C, A, L>::find(const K& key)
+{
+  size_type i = lower_index(key);
+  return matches(i, key) ? begin() + i : end();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::const_iterator FlatTable<K, V, KO, C, A, L>::find(const K& key) const
+{
+  size_type i = lower_index(key);
+  return matches(i, key) ? cbegin() + i : cend();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::size_type FlatTable<K, V, KO, C, A, L>::count(const K& key) const
+{
+  return matches(lower_index(key), key) ? 1 : 0;
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+bool FlatTable<K, V, KO, C, A, L>::contains(const K& key) const
+{
+  return matches(lower_index(key), key);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::iterator FlatTable<K, V, KO, C, A, L>::lower_bound(const K& key)
+{
+  return begin() + lower_index(key);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::iterator FlatTable<K, V, KO, C, A, L>::upper_bound(const K& key)
+{
+  size_type i = lower_index(key);
+  return begin() + (matches(i, key) ? i + 1 : i);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+std::pair<typename FlatTable<K, V, KO, C, A, L>::iterator, bool> FlatTable<K, V, KO, C, A, L>::insert(const V& value)
+{
+  return insert_unique(value);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+std::pair<typename FlatTable<K, V, KO, C, A, L>::iterator, bool> FlatTable<K, V, KO, C, A, L>::insert(V&& value)
+{
+  return insert_unique(std::move(value));
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+void FlatTable<K, V, KO, C, A, L>::insert(std::initializer_list<V> list)
+{
+  insert(list.begin(), list.end());
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+template<typename IteratorType, typename isIterator>
+void FlatTable<K, V, KO, C, A, L>::insert(IteratorType first, IteratorType last)
+{
+  size_type oldSize = size();
+  for (; first != last; ++first) {
+    _items.push_back(*first);
+  }
+  normalize(oldSize);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::size_type FlatTable<K, V, KO, C, A, L>::erase(const K& key)
+{
+  size_type i = lower_index(key);
+  if (!matches(i, key)) return 0;
+  erase(begin() + i);
+  return 1;
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::iterator FlatTable<K, V, KO, C, A, L>::erase(iterator it)
+{
+  return erase(it, it + 1);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::iterator FlatTable<K, V, KO, C, A, L>::erase(iterator first, iterator last)
+{
+  size_type index = first - begin();
+  _items.erase(first, last);
+  rebuild();
+  return begin() + index;
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+void FlatTable<K, V, KO, C, A, L>::swap(FlatTable& other)
+{
+  _items.swap(other._items);
+  _tree.swap(other._tree);
+  _rank.swap(other._rank);
+  std::swap(_compare, other._compare);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+void FlatTable<K, V, KO, C, A, L>::clear() noexcept
+{
+  _items.clear();
+  _tree.clear();
+  _rank.clear();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::key_compare FlatTable<K, V, KO, C, A, L>::key_comp() const
+{
+  return _compare;
+}
+
+/**
+ * Index of the first element whose key is not less than key, or size().
+ * Both layouts compile the comparison into a conditional move rather than
+ * a branch, so a search costs the same whatever the outcome.
+ */
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::size_type FlatTable<K, V, KO, C, A, L>::lower_index(const K& key) const
+{
+  const size_type n = size();
+  if (n == 0) return 0;
+
+  if (L == FlatLayout::Eytzinger) {
+    size_type k = 1;
+    while (k <= n) {
+      k = 2 * k + _compare(_tree[k], key);
+    }
+    k >>= detail::lowest_bit(~static_cast<std::uint64_t>(k)) + 1;
+    return k ? _rank[k] : n;
+  }
+
+  const V* base = &_items[0];
+  size_type length = n;
+  while (length > 1) {
+    size_type half = length / 2;
+    base = _compare(KO()(base[half]), key) ? base + half : base;
+    length -= half;
+  }
+  return (base - &_items[0]) + _compare(KO()(*base), key);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+inline bool FlatTable<K, V, KO, C, A, L>::matches(size_type i, const K& key) const
+{
+  return i < size() && !_compare(key, KO()(_items[i]));
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+template<typename T>
+std::pair<typename FlatTable<K, V, KO, C, A, L>::iterator, bool> FlatTable<K, V, KO, C, A, L>::insert_unique(T&& value)
+{
+  size_type i = lower_index(KO()(value));
+  if (matches(i, KO()(value))) {
+    return std::make_pair(begin() + i, false);
+  }
+  _items.emplace(begin() + i, std::forward<T>(value));
+  rebuild();
+  return std::make_pair(begin() + i, true);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+inline bool FlatTable<K, V, KO, C, A, L>::less(const V& a, const V& b) const
+{
+  return _compare(KO()(a), KO()(b));
+}
+
+/**
+ * Restores the sorted, unique invariant after values were appended past
+ * sorted: the new block is stable-sorted and merged in, and for equal keys
+ * the earliest value (an existing one if present) is kept.
+ */
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+void FlatTable<K, V, KO, C, A, L>::normalize(size_type sorted)
+{
+  auto less = [this](const V& a, const V& b) { return this->less(a, b); };
+  auto equal = [this](const V& a, const V& b) { return !this->less(a, b) && !this->less(b, a); };
+
+  std::stable_sort(begin() + sorted, end(), less);
+  std::inplace_merge(begin(), begin() + sorted, end(), less);
+  _items.erase(std::unique(begin(), end(), equal), end());
+  rebuild();
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+void FlatTable<K, V, KO, C, A, L>::rebuild()
+{
+  if (L != FlatLayout::Eytzinger) return;
+  _tree.assign(size() + 1, K());
+  _rank.assign(size() + 1, 0);
+  build(1, 0);
+}
+
+template<typename K, typename V, typename KO, class C, class A, FlatLayout L>
+typename FlatTable<K, V, KO, C, A, L>::size_type FlatTable<K, V, KO, C, A, L>::build(size_type k, size_type i)
+{
+  if (k > size()) return i;
+  i = build(2 * k, i);
+  _tree[k] = KO()(_items[i]);
+  _rank[k] = i;
+  return build(2 * k + 1, i + 1);
+}
+
+} // namespace detail
+
+
+/**
+ * ctl::FlatMap Definition
+ *
+ * Sorted associative array over a ctl::Vector of std::pair<K, V>. Iterators
+ * are plain contiguous iterators and are invalidated by any insert or erase.
+ */
+
+template<typename K, typename V, class Compare = std::less<K>, class A = Allocator<std::pair<K, V>>, FlatLayout L = FlatLayout::Sorted>
+class FlatMap : public detail::FlatTable<K, std::pair<K, V>, detail::KeyOfPair, Compare, A, L>
+{
+  using base = detail::FlatTable<K, std::pair<K, V>, detail::KeyOfPair, Compare, A, L>;
+
+public:
+  using mapped_type = V;
+  using base::base;
+
+  V& at(const K&);
+  const V& at(const K&) const;
+  V& operator[](const K&);
+};
+
+
+/**
+ * ctl::FlatSet Definition
+ */
+
+template<typename K, class Compare = std::less<K>, class A = Allocator<K>, FlatLayout L = FlatLayout::Sorted>
+class FlatSet : public detail::FlatTable<K, K, detail::KeyOfValue, Compare, A, L>
+{
+  using base = detail::FlatTable<K, K, detail::KeyOfValue, Compare, A, L>;
+
+public:
+  using base::base;
+};
+
+
+/**
+ * ctl::FlatMap Implementation
+ */
+
+template<typename K, typename V, class C, class A, FlatLayout L>
+V& FlatMap<K, V, C, A, L>::at(const K& key)
+{
+  auto it = this->find(key);
+  if (it == this->end()) {
+    throw std::out_of_range("ctl::FlatMap: key not found");
+  }
+  return it->second;
+}
+
+template<typename K, typename V, class C, class A, FlatLayout L>
+const V& FlatMap<K, V, C, A, L>::at(const K& key) const
+{
+  auto it = this->find(key);
+  if (it == this->cend()) {
+    throw std::out_of_range("ctl::FlatMap: key not found");
+  }
+  return it->second;
+}
+
+template<typename K, typename V, class C, class A, FlatLayout L>
+V& FlatMap<K, V, C, A, L>::operator[](const K& key)
+{
+  auto i = this->lower_index(key);
+  if (!this->matches(i, key)) {
+    this->_items.emplace(this->begin() + i, key, V());
+    this->rebuild();
+  }
+  return this->_items[i].second;
+}
+
+} // namespace ctl
@@ -0,0 +1,472 @@
+#pragma once
+
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <initializer_list>
+
+#include "allocator.hpp"
+#include "iterator.hpp"
+#include "parallel_copy.hpp"
+
+
+namespace ctl {
+
+/**
+ * ctl::GapVector Definition
+ *
+ * Gap buffer: one allocation holding the elements before the cursor, a run
+ * of unconstructed slots (the gap), then the elements after the cursor.
+ * Insert and erase at the gap are amortized O(1); an edit elsewhere first
+ * moves the gap there, which costs O(distance) moves rather than shifting
+ * the whole tail. Indexing and the random-access iterator skip the gap, so
+ * the gap position is invisible to readers.
+ */
+
+template<typename T, class A = Allocator<T>>
+class GapVector
+{
+public:
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using difference_type = typename A::difference_type;
+  using reference = typename A::reference;
+  using const_reference = typename A::const_reference;
+  using pointer = typename A::pointer;
+  using const_pointer = typename A::const_pointer;
+  using iterator = ctl::IndexIterator<GapVector, T>;
+  using const_iterator = ctl::IndexIterator<const GapVector, const T>;
+
+  GapVector() {};
+  GapVector(const GapVector&);
+  GapVector(GapVector&&);
+  GapVector(size_type, const_reference);
+  GapVector(std::initializer_list<T>);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  GapVector(IteratorType, IteratorType);
+
+  ~GapVector();
+
+  GapVector& operator=(const GapVector&);
+  GapVector& operator=(GapVector&&);
+
+  iterator begin() noexcept;
+  iterator end() noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+  void reserve(size_type);
+
+  reference at(size_type);
+  const_reference at(size_type) const;
+  reference operator[](size_type) noexcept;
+  const_reference operator[](size_type) const noexcept;
+  reference front();
+  reference back();
+
+  size_type gap_position() const noexcept;
+  void move_gap(size_type);
+
+  void push_back(const_reference);
+  void push_back(value_type&&);
+  void pop_back();
+
+  iterator insert(iterator, const_reference);
+  iterator insert(iterator, value_type&&);
+  template<class... Args>
+  iterator emplace(iterator, Args&&...);
+  iterator erase(iterator);
+  iterator erase(iterator, iterator);
+
+  void swap(GapVector&) noexcept;
+  void clear() noexcept;
+
+  A get_allocator() const noexcept;
+
+private:
+  static constexpr float _growthFactor = 1.5f;
+
+  A _allocator;
+  pointer _begin = nullptr;
+  pointer _gapBegin = nullptr;
+  pointer _gapEnd = nullptr;
+  pointer _end = nullptr;
+
+  pointer slot(size_type) const noexcept;
+  void relocate(size_type);
+  void shift(pointer, pointer, pointer);
+  void destroy(pointer, pointer) noexcept;
+};
+
+
+/**
+ * ctl::GapVector Implementation
+ */
+
+template<typename T, typename A>
+GapVector<T, A>::GapVector(const GapVector& other)
+{
+  reserve(other.size());
+  const size_type front = other._gapBegin - other._begin;
+  try {
+    detail::uninitialized_copy_n(_allocator, other._begin, front, _begin);
+    _gapBegin = _begin + front;
+    detail::uninitialized_copy_n(_allocator, other._gapEnd, other._end - other._gapEnd, _gapBegin);
+  } catch (...) {
+    destroy(_begin, _gapBegin);
+    _allocator.deallocate(_begin, capacity());
+    throw;
+  }
+  _gapBegin = _begin + other.size();
+}
+
+template<typename T, typename A>
+GapVector<T, A>::GapVector(GapVector&& other)
+{
+  swap(other);
+}
+
+template<typename T, typename A>
+GapVector<T, A>::GapVector(size_type count, const_reference value)
+{
+  reserve(count);
+  for (size_type i = 0; i < count; ++i) {
+    push_back(value);
+  }
+}
+
+template<typename T, typename A>
+GapVector<T, A>::GapVector(std::initializer_list<T> list) : GapVector(list.begin(), list.end()) {}
+
+template<typename T, typename A>
+template<typename IteratorType, typename isIterator>
+GapVector<T, A>::GapVector(IteratorType first, IteratorType last)
+{
+  for (; first != last; ++first) {
+    push_back(*first);
+  }
+}
+
+template<typename T, typename A>
+GapVector<T, A>::~GapVector()
+{
+  clear();
+  _allocator.deallocate(_begin, capacity());
+}
+
+template<typename T, typename A>
+GapVector<T, A>& GapVector<T, A>::operator=(const GapVector& other)
+{
+  if (this == &other) return *this;
+  GapVector copy(other);
+  swap(copy);
+  return *this;
+}
+
+template<typename T, typename A>
+GapVector<T, A>& GapVector<T, A>::operator=(GapVector&& other)
+{
+  if (this == &other) return *this;
+  GapVector moved(std::move(other));
+  swap(moved);
+  return *this;
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::iterator GapVector<T, A>::begin() noexcept
+{
+  return iterator(this, 0);
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::iterator GapVector<T, A>::end() noexcept
+{
+  return iterator(this, size());
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::const_iterator GapVector<T, A>::cbegin() const noexcept
+{
+  return const_iterator(this, 0);
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::const_iterator GapVector<T, A>::cend() const noexcept
+{
+  return const_iterator(this, size());
+}
+
+template<typename T, typename A>
+inline typename GapVector<T, A>::size_type GapVector<T, A>::size() const noexcept
+{
+  return (_gapBegin - _begin) + (_end - _gapEnd);
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::size_type GapVector<T, A>::max_size() const noexcept
+{
+  return static_cast<size_type>(-1) / sizeof(T);
+}
+
+template<typename T, typename A>
+inline typename GapVector<T, A>::size_type GapVector<T, A>::capacity() const noexcept
+{
+  return _end - _begin;
+}
+
+template<typename T, typename A>
+inline bool GapVector<T, A>::empty() const noexcept
+{
+  return size() == 0;
+}
+
+template<typename T, typename A>
+void GapVector<T, A>::reserve(size_type newCapacity)
+{
+  if (newCapacity > max_size()) {
+    throw std::length_error("ctl::GapVector: too big capacity to reserve");
+  }
+  if (newCapacity > capacity()) {
+    relocate(newCapacity);
+  }
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::reference GapVector<T, A>::at(size_type i)
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::GapVector: out of range");
+  }
+  return *slot(i);
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::const_reference GapVector<T, A>::at(size_type i) const
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::GapVector: out of range");
+  }
+  return *slot(i);
+}
+
+template<typename T, typename A>
+inline typename GapVector<T, A>::reference GapVector<T, A>::operator[](size_type i) noexcept
+{
+  return *slot(i);
+}
+
+template<typename T, typename A>
+inline typename GapVector<T, A>::const_reference GapVector<T, A>::operator[](size_type i) const noexcept
+{
+  return *slot(i);
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::reference GapVector<T, A>::front()
+{
+  return *slot(0);
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::reference GapVector<T, A>::back()
+{
+  return *slot(size() - 1);
+}
+
+template<typename T, typename A>
+inline typename GapVector<T, A>::size_type GapVector<T, A>::gap_position() const noexcept
+{
+  return _gapBegin - _begin;
+}
+
+template<typename T, typename A>
+void GapVector<T, A>::move_gap(size_type index)
+{
+  if (index > size()) {
+    throw std::out_of_range("ctl::GapVector: gap position out of range");
+  }
+  if (_gapBegin == _gapEnd) {
+    // A full buffer has nothing to shift; the empty gap just moves.
+    _gapBegin = _gapEnd = _begin + index;
+    return;
+  }
+  const size_type position = gap_position();
+  if (index < position) {
+    const size_type count = position - index;
+    shift(_gapBegin - count, _gapBegin, _gapEnd - count);
+    _gapBegin -= count;
+    _gapEnd -= count;
+  } else if (index > position) {
+    const size_type count = index - position;
+    shift(_gapEnd, _gapEnd + count, _gapBegin);
+    _gapBegin += count;
+    _gapEnd += count;
+  }
+}
+
+template<typename T, typename A>
+void GapVector<T, A>::push_back(const_reference value)
+{
+  emplace(end(), value);
+}
+
+template<typename T, typename A>
+void GapVector<T, A>::push_back(value_type&& value)
+{
+  emplace(end(), std::move(value));
+}
+
+template<typename T, typename A>
+void GapVector<T, A>::pop_back()
+{
+  erase(end() - 1);
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::iterator GapVector<T, A>::insert(iterator it, const_reference value)
+{
+  return emplace(it, value);
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::iterator GapVector<T, A>::insert(iterator it, value_type&& value)
+{
+  return emplace(it, std::move(value));
+}
+
+template<typename T, typename A>
+template<class... Args>
+typename GapVector<T, A>::iterator GapVector<T, A>::emplace(iterator it, Args&&... args)
+{
+  const size_type index = it.index();
+  if (_gapBegin == _gapEnd) {
+    value_type value(std::forward<Args>(args)...);
+    relocate(std::max<size_type>(capacity() * _growthFactor, capacity() + 2));
+    move_gap(index);
+    _allocator.construct(_gapBegin, std::move(value));
+  } else {
+    move_gap(index);
+    _allocator.construct(_gapBegin, std::forward<Args>(args)...);
+  }
+  ++_gapBegin;
+  return iterator(this, index);
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::iterator GapVector<T, A>::erase(iterator it)
+{
+  return erase(it, it + 1);
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::iterator GapVector<T, A>::erase(iterator first, iterator last)
+{
+  const size_type index = first.index();
+  const size_type count = last - first;
+  move_gap(index);
+  destroy(_gapEnd, _gapEnd + count);
+  _gapEnd += count;
+  return iterator(this, index);
+}
+
+template<typename T, typename A>
+void GapVector<T, A>::swap(GapVector& other) noexcept
+{
+  std::swap(_begin, other._begin);
+  std::swap(_gapBegin, other._gapBegin);
+  std::swap(_gapEnd, other._gapEnd);
+  std::swap(_end, other._end);
+}
+
+template<typename T, typename A>
+void GapVector<T, A>::clear() noexcept
+{
+  destroy(_begin, _gapBegin);
+  destroy(_gapEnd, _end);
+  _gapBegin = _begin;
+  _gapEnd = _end;
+}
+
+template<typename T, typename A>
+typename GapVector<T, A>::allocator_type GapVector<T, A>::get_allocator() const noexcept
+{
+  return _allocator;
+}
+
+template<typename T, typename A>
+inline typename GapVector<T, A>::pointer GapVector<T, A>::slot(size_type i) const noexcept
+{
+  pointer p = _begin + i;
+  return p < _gapBegin ? p : p + (_gapEnd - _gapBegin);
+}
+
+template<typename T, typename A>
+void GapVector<T, A>::relocate(size_type newCapacity)
+{
+  const size_type front = _gapBegin - _begin;
+  const size_type back = _end - _gapEnd;
+  pointer newBegin = _allocator.allocate(newCapacity);
+  pointer newGapEnd = newBegin + newCapacity - back;
+  try {
+    detail::uninitialized_move_n(_allocator, _begin, front, newBegin);
+    try {
+      detail::uninitialized_move_n(_allocator, _gapEnd, back, newGapEnd);
+    } catch (...) {
+      destroy(newBegin, newBegin + front);
+      throw;
+    }
+  } catch (...) {
+    _allocator.deallocate(newBegin, newCapacity);
+    throw;
+  }
+  clear();
+  _allocator.deallocate(_begin, capacity());
+
+  _begin = newBegin;
+  _gapBegin = newBegin + front;
+  _gapEnd = newGapEnd;
+  _end = newBegin + newCapacity;
+}
+
+/**
+ * Moves the elements of [first, last) into the unconstructed range starting
+ * at dst, which lies inside the gap or overlaps [first, last) from the gap
+ * side, and leaves the source slots unconstructed.
+ */
+template<typename T, typename A>
+void GapVector<T, A>::shift(pointer first, pointer last, pointer dst)
+{
+  if (std::is_trivially_copyable<T>::value) {
+    std::memmove(static_cast<void*>(dst), static_cast<const void*>(first), (last - first) * sizeof(T));
+    return;
+  }
+  if (dst < first) {
+    for (; first != last; ++first, ++dst) {
+      _allocator.construct(dst, std::move(*first));
+      _allocator.destroy(first);
+    }
+  } else {
+    dst += last - first;
+    while (last != first) {
+      _allocator.construct(--dst, std::move(*--last));
+      _allocator.destroy(last);
+    }
+  }
+}
+
+template<typename T, typename A>
+void GapVector<T, A>::destroy(pointer first, pointer last) noexcept
+{
+  for (; first != last; ++first) {
+    _allocator.destroy(first);
+  }
+}
+
+} // namespace ctl
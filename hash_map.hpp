@@ -0,0 +1,644 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <functional>
+#include <type_traits>
+#include <initializer_list>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "allocator.hpp"
+#include "vector.hpp"
+
+
+namespace ctl {
+
+namespace detail {
+
+/**
+ * One probe group of 16 control bytes. A control byte is Empty, Deleted or
+ * the low 7 bits of a full slot's hash, so a single SSE2 compare tests a
+ * whole group against a key.
+ */
+struct ControlGroup
+{
+  using ctrl_type = signed char;
+
+  enum : ctrl_type { Empty = -128, Deleted = -2 };
+
+  static constexpr std::size_t width = 16;
+
+  const ctrl_type* ctrl;
+
+  explicit ControlGroup(const ctrl_type* ctrl) noexcept : ctrl(ctrl) {}
+
+  std::uint32_t match(ctrl_type hash) const noexcept
+  {
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(hash), group));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < width; ++i) {
+      mask |= std::uint32_t(ctrl[i] == hash) << i;
+    }
+    return mask;
+#endif
+  }
+
+  std::uint32_t match_empty() const noexcept
+  {
+    return match(Empty);
+  }
+
+  std::uint32_t match_free() const noexcept
+  {
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), group));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < width; ++i) {
+      mask |= std::uint32_t(ctrl[i] < -1) << i;
+    }
+    return mask;
+#endif
+  }
+};
+
+inline std::uint64_t mix_hash(std::uint64_t h) noexcept
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+/**
+ * Hasher or key comparator slot for HashMap. Like AllocatorHolder, a
+ * stateless functor becomes an empty base; I tells the hasher and the
+ * comparator apart when both are the same type.
+ */
+template<std::size_t I, class F, bool = std::is_empty<F>::value && !std::is_final<F>::value>
+class FunctorHolder : private F
+{
+protected:
+  FunctorHolder() = default;
+  explicit FunctorHolder(const F& functor) : F(functor) {}
+
+  const F& functor() const noexcept { return *this; }
+};
+
+template<std::size_t I, class F>
+class FunctorHolder<I, F, false>
+{
+protected:
+  FunctorHolder() = default;
+  explicit FunctorHolder(const F& functor) : _functor(functor) {}
+
+  const F& functor() const noexcept { return _functor; }
+
+private:
+  F _functor;
+};
+
+} // namespace detail
+
+
+/**
+ * ctl::HashMap Definition
+ *
+ * Open-addressing hash map in the Swiss-table style. Slots live in one
+ * ctl::Vector of raw storage next to a ctl::Vector of control bytes, both
+ * allocated through A, so the whole table is two contiguous blocks instead
+ * of one node per element. Lookups probe 16 control bytes at a time and
+ * only touch slots whose 7-bit hash tag matches.
+ *
+ * Capacity is a power of two and the table grows at 7/8 load. Erase leaves
+ * a tombstone; tombstones are reclaimed by the next rehash. Any insert may
+ * rehash and invalidate iterators and references.
+ *
+ * The hasher and key comparator are stored, so seeded or otherwise stateful
+ * functors work; stateless ones take no space.
+ */
+
+template<typename K, typename V, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>, class A = Allocator<std::pair<const K, V>>>
+class HashMap : private detail::FunctorHolder<0, Hash>, private detail::FunctorHolder<1, KeyEqual>
+{
+  using hash_holder = detail::FunctorHolder<0, Hash>;
+  using equal_holder = detail::FunctorHolder<1, KeyEqual>;
+  using ctrl_type = detail::ControlGroup::ctrl_type;
+
+  struct Slot
+  {
+    typename std::aligned_storage<sizeof(std::pair<const K, V>), alignof(std::pair<const K, V>)>::type storage;
+  };
+
+  template<bool Const>
+  class Iterator;
+
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<const K, V>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = A;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  HashMap() {};
+  explicit HashMap(size_type, const Hash& = Hash(), const KeyEqual& = KeyEqual());
+  HashMap(const HashMap&);
+  HashMap(HashMap&&);
+  HashMap(std::initializer_list<value_type>, size_type = 0, const Hash& = Hash(), const KeyEqual& = KeyEqual());
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  HashMap(IteratorType, IteratorType, size_type = 0, const Hash& = Hash(), const KeyEqual& = KeyEqual());
+
+  ~HashMap();
+
+  HashMap& operator=(const HashMap&);
+  HashMap& operator=(HashMap&&);
+
+  iterator begin() noexcept;
+  iterator end() noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+  float load_factor() const noexcept;
+  void reserve(size_type);
+  void rehash(size_type);
+
+  iterator find(const K&);
+  const_iterator find(const K&) const;
+  size_type count(const K&) const;
+  bool contains(const K&) const;
+  V& at(const K&);
+  const V& at(const K&) const;
+  V& operator[](const K&);
+
+  std::pair<iterator, bool> insert(const value_type&);
+  std::pair<iterator, bool> insert(value_type&&);
+  template<class... Args>
+  std::pair<iterator, bool> emplace(const K&, Args&&...);
+
+  size_type erase(const K&);
+  iterator erase(iterator);
+
+  void swap(HashMap&) noexcept;
+  void clear() noexcept;
+
+  hasher hash_function() const;
+  key_equal key_eq() const;
+
+private:
+  using slot_allocator = typename std::allocator_traits<A>::template rebind_alloc<Slot>;
+  using ctrl_allocator = typename std::allocator_traits<A>::template rebind_alloc<ctrl_type>;
+
+  static constexpr size_type _group = detail::ControlGroup::width;
+  static constexpr size_type _minCapacity = 16;
+
+  A _allocator;
+  Vector<Slot, slot_allocator> _slots;
+  Vector<ctrl_type, ctrl_allocator> _ctrl;
+  size_type _size = 0;
+  size_type _growthLeft = 0;
+
+  std::uint64_t hash(const K&) const;
+  value_type* slot(size_type) const noexcept;
+  void set_ctrl(size_type, ctrl_type) noexcept;
+  size_type find_index(const K&, std::uint64_t) const;
+  size_type find_free(std::uint64_t) const noexcept;
+  void grow();
+  void destroy_all() noexcept;
+};
+
+
+/**
+ * ctl::HashMap::Iterator Definition
+ */
+
+template<typename K, typename V, class H, class E, class A>
+template<bool Const>
+class HashMap<K, V, H, E, A>::Iterator
+{
+public:
+  using difference_type = std::ptrdiff_t;
+  using value_type = typename HashMap::value_type;
+  using pointer = typename std::conditional<Const, const value_type*, value_type*>::type;
+  using reference = typename std::conditional<Const, const value_type&, value_type&>::type;
+  using iterator_category = std::forward_iterator_tag;
+
+  Iterator() : map(nullptr), i(0) {}
+  Iterator(const HashMap* map, std::size_t i) : map(map), i(i) { skip(); }
+  template<bool C, class = typename std::enable_if< Const && !C >::type>
+  Iterator(const Iterator<C>& other) : map(other.map), i(other.i) {}
+
+  Iterator& operator++() { ++i; skip(); return *this; }
+  Iterator operator++(int) { Iterator foo(*this); ++*this; return foo; }
+
+  reference operator*() const { return *map->slot(i); }
+  pointer operator->() const { return map->slot(i); }
+
+  bool operator==(const Iterator& other) const { return i == other.i; }
+  bool operator!=(const Iterator& other) const { return i != other.i; }
+
+private:
+  friend class HashMap;
+  template<bool> friend class Iterator;
+
+  const HashMap* map;
+  std::size_t i;
+
+  void skip() { while (i < map->capacity() && map->_ctrl[i] < 0) ++i; }
+};
+
+
+/**
+ * ctl::HashMap Implementation
+ */
+
+template<typename K, typename V, class H, class E, class A>
+HashMap<K, V, H, E, A>::HashMap(size_type count, const H& hasher, const E& equal) : hash_holder(hasher), equal_holder(equal)
+{
+  if (count) {
+    reserve(count);
+  }
+}
+
+template<typename K, typename V, class H, class E, class A>
+HashMap<K, V, H, E, A>::HashMap(const HashMap& other) : hash_holder(other.hash_holder::functor()), equal_holder(other.equal_holder::functor())
+{
+  reserve(other.size());
+  for (auto it = other.cbegin(); it != other.cend(); ++it) {
+    insert(*it);
+  }
+}
+
+template<typename K, typename V, class H, class E, class A>
+HashMap<K, V, H, E, A>::HashMap(HashMap&& other) : hash_holder(other.hash_holder::functor()), equal_holder(other.equal_holder::functor())
+{
+  swap(other);
+}
+
+template<typename K, typename V, class H, class E, class A>
+HashMap<K, V, H, E, A>::HashMap(std::initializer_list<value_type> list, size_type count, const H& hasher, const E& equal)
+  : HashMap(list.begin(), list.end(), count, hasher, equal) {}
+
+template<typename K, typename V, class H, class E, class A>
+template<typename IteratorType, typename isIterator>
+HashMap<K, V, H, E, A>::HashMap(IteratorType first, IteratorType last, size_type count, const H& hasher, const E& equal)
+  : HashMap(count, hasher, equal)
+{
+  for (; first != last; ++first) {
+    insert(*first);
+  }
+}
+
+template<typename K, typename V, class H, class E, class A>
+HashMap<K, V, H, E, A>::~HashMap()
+{
+  destroy_all();
+}
+
+template<typename K, typename V, class H, class E, class A>
+HashMap<K, V, H, E, A>& HashMap<K, V, H, E, A>::operator=(const HashMap& other)
+{
+  if (this == &other) return *this;
+  HashMap copy(other);
+  swap(copy);
+  return *this;
+}
+
+template<typename K, typename V, class H, class E, class A>
+HashMap<K, V, H, E, A>& HashMap<K, V, H, E, A>::operator=(HashMap&& other)
+{
+  if (this == &other) return *this;
+  HashMap moved(std::move(other));
+  swap(moved);
+  return *this;
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::iterator HashMap<K, V, H, E, A>::begin() noexcept
+{
+  return iterator(this, 0);
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::iterator HashMap<K, V, H, E, A>::end() noexcept
+{
+  return iterator(this, capacity());
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::const_iterator HashMap<K, V, H, E, A>::cbegin() const noexcept
+{
+  return const_iterator(this, 0);
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::const_iterator HashMap<K, V, H, E, A>::cend() const noexcept
+{
+  return const_iterator(this, capacity());
+}
+
+template<typename K, typename V, class H, class E, class A>
+inline typename HashMap<K, V, H, E, A>::size_type HashMap<K, V, H, E, A>::size() const noexcept
+{
+  return _size;
+}
+
+template<typename K, typename V, class H, class E, class A>
+inline typename HashMap<K, V, H, E, A>::size_type HashMap<K, V, H, E, A>::capacity() const noexcept
+{
+  return _slots.size();
+}
+
+template<typename K, typename V, class H, class E, class A>
+inline bool HashMap<K, V, H, E, A>::empty() const noexcept
+{
+  return _size == 0;
+}
+
+template<typename K, typename V, class H, class E, class A>
+float HashMap<K, V, H, E, A>::load_factor() const noexcept
+{
+  return capacity() ? float(_size) / capacity() : 0.0f;
+}
+
+template<typename K, typename V, class H, class E, class A>
+void HashMap<K, V, H, E, A>::reserve(size_type count)
+{
+  rehash(count + count / 7);
+}
+
+/**
+ * Moves every element into a fresh table of at least count slots (rounded
+ * up to a power of two and never below what size() needs), dropping all
+ * tombstones on the way.
+ */
+template<typename K, typename V, class H, class E, class A>
+void HashMap<K, V, H, E, A>::rehash(size_type count)
+{
+  size_type newCapacity = _minCapacity;
+  while (newCapacity < count || newCapacity - newCapacity / 8 < _size) {
+    newCapacity *= 2;
+  }
+  if (newCapacity == capacity() && _growthLeft + _size == capacity() - capacity() / 8) return;
+
+  HashMap fresh(0, hash_holder::functor(), equal_holder::functor());
+  fresh._slots = Vector<Slot, slot_allocator>(newCapacity);
+  fresh._slots.shrink_to_fit();
+  fresh._ctrl = Vector<ctrl_type, ctrl_allocator>(newCapacity + _group, ctrl_type(detail::ControlGroup::Empty));
+  fresh._ctrl.shrink_to_fit();
+  fresh._growthLeft = newCapacity - newCapacity / 8;
+
+  for (size_type i = 0; i < capacity(); ++i) {
+    if (_ctrl[i] < 0) continue;
+    std::uint64_t h = hash(slot(i)->first);
+    size_type target = fresh.find_free(h);
+    _allocator.construct(fresh.slot(target), std::move_if_noexcept(*slot(i)));
+    fresh.set_ctrl(target, ctrl_type(h & 0x7f));
+    ++fresh._size;
+    --fresh._growthLeft;
+  }
+  swap(fresh);
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::iterator HashMap<K, V, H, E, A>::find(const K& key)
+{
+  return iterator(this, find_index(key, hash(key)));
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::const_iterator HashMap<K, V, H, E, A>::find(const K& key) const
+{
+  return const_iterator(this, find_index(key, hash(key)));
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::size_type HashMap<K, V, H, E, A>::count(const K& key) const
+{
+  return contains(key) ? 1 : 0;
+}
+
+template<typename K, typename V, class H, class E, class A>
+bool HashMap<K, V, H, E, A>::contains(const K& key) const
+{
+  return find_index(key, hash(key)) != capacity();
+}
+
+template<typename K, typename V, class H, class E, class A>
+V& HashMap<K, V, H, E, A>::at(const K& key)
+{
+  size_type i = find_index(key, hash(key));
+  if (i == capacity()) {
+    throw std::out_of_range("ctl::HashMap: key not found");
+  }
+  return slot(i)->second;
+}
+
+template<typename K, typename V, class H, class E, class A>
+const V& HashMap<K, V, H, E, A>::at(const K& key) const
+{
+  size_type i = find_index(key, hash(key));
+  if (i == capacity()) {
+    throw std::out_of_range("ctl::HashMap: key not found");
+  }
+  return slot(i)->second;
+}
+
+template<typename K, typename V, class H, class E, class A>
+V& HashMap<K, V, H, E, A>::operator[](const K& key)
+{
+  return emplace(key).first->second;
+}
+
+template<typename K, typename V, class H, class E, class A>
+std::pair<typename HashMap<K, V, H, E, A>::iterator, bool> HashMap<K, V, H, E, A>::insert(const value_type& value)
+{
+  return emplace(value.first, value.second);
+}
+
+template<typename K, typename V, class H, class E, class A>
+std::pair<typename HashMap<K, V, H, E, A>::iterator, bool> HashMap<K, V, H, E, A>::insert(value_type&& value)
+{
+  return emplace(value.first, std::move(value.second));
+}
+
+template<typename K, typename V, class H, class E, class A>
+template<class... Args>
+std::pair<typename HashMap<K, V, H, E, A>::iterator, bool> HashMap<K, V, H, E, A>::emplace(const K& key, Args&&... args)
+{
+  const std::uint64_t h = hash(key);
+  size_type i = find_index(key, h);
+  if (i != capacity()) {
+    return std::make_pair(iterator(this, i), false);
+  }
+
+  if (capacity() == 0) {
+    grow();
+  }
+  i = find_free(h);
+  if (_growthLeft == 0 && _ctrl[i] == detail::ControlGroup::Empty) {
+    grow();
+    i = find_free(h);
+  }
+  _allocator.construct(slot(i), std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+  if (_ctrl[i] == detail::ControlGroup::Empty) {
+    --_growthLeft;
+  }
+  set_ctrl(i, ctrl_type(h & 0x7f));
+  ++_size;
+  return std::make_pair(iterator(this, i), true);
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::size_type HashMap<K, V, H, E, A>::erase(const K& key)
+{
+  size_type i = find_index(key, hash(key));
+  if (i == capacity()) return 0;
+  erase(iterator(this, i));
+  return 1;
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::iterator HashMap<K, V, H, E, A>::erase(iterator it)
+{
+  _allocator.destroy(slot(it.i));
+  set_ctrl(it.i, detail::ControlGroup::Deleted);
+  --_size;
+  return ++it;
+}
+
+template<typename K, typename V, class H, class E, class A>
+void HashMap<K, V, H, E, A>::swap(HashMap& other) noexcept
+{
+  using std::swap;
+  swap(static_cast<hash_holder&>(*this), static_cast<hash_holder&>(other));
+  swap(static_cast<equal_holder&>(*this), static_cast<equal_holder&>(other));
+  _slots.swap(other._slots);
+  _ctrl.swap(other._ctrl);
+  std::swap(_size, other._size);
+  std::swap(_growthLeft, other._growthLeft);
+}
+
+template<typename K, typename V, class H, class E, class A>
+void HashMap<K, V, H, E, A>::clear() noexcept
+{
+  destroy_all();
+  std::fill(_ctrl.begin(), _ctrl.end(), ctrl_type(detail::ControlGroup::Empty));
+  _size = 0;
+  _growthLeft = capacity() - capacity() / 8;
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::hasher HashMap<K, V, H, E, A>::hash_function() const
+{
+  return hash_holder::functor();
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::key_equal HashMap<K, V, H, E, A>::key_eq() const
+{
+  return equal_holder::functor();
+}
+
+template<typename K, typename V, class H, class E, class A>
+inline std::uint64_t HashMap<K, V, H, E, A>::hash(const K& key) const
+{
+  return detail::mix_hash(hash_holder::functor()(key));
+}
+
+template<typename K, typename V, class H, class E, class A>
+inline typename HashMap<K, V, H, E, A>::value_type* HashMap<K, V, H, E, A>::slot(size_type i) const noexcept
+{
+  return reinterpret_cast<value_type*>(&_slots[i].storage);
+}
+
+/**
+ * Control bytes past capacity() mirror the first group, so a 16-byte load
+ * starting near the end wraps around without a second load.
+ */
+template<typename K, typename V, class H, class E, class A>
+inline void HashMap<K, V, H, E, A>::set_ctrl(size_type i, ctrl_type value) noexcept
+{
+  _ctrl[i] = value;
+  if (i < _group) {
+    _ctrl[capacity() + i] = value;
+  }
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::size_type HashMap<K, V, H, E, A>::find_index(const K& key, std::uint64_t h) const
+{
+  const size_type mask = capacity() - 1;
+  if (capacity() == 0) return 0;
+
+  const ctrl_type tag = ctrl_type(h & 0x7f);
+  size_type position = (h >> 7) & mask;
+  for (size_type step = _group;; step += _group) {
+    detail::ControlGroup group(&_ctrl[position]);
+    for (std::uint32_t bits = group.match(tag); bits; bits &= bits - 1) {
+      size_type i = (position + detail::lowest_bit(bits)) & mask;
+      if (equal_holder::functor()(slot(i)->first, key)) return i;
+    }
+    if (group.match_empty()) return capacity();
+    position = (position + step) & mask;
+  }
+}
+
+template<typename K, typename V, class H, class E, class A>
+typename HashMap<K, V, H, E, A>::size_type HashMap<K, V, H, E, A>::find_free(std::uint64_t h) const noexcept
+{
+  const size_type mask = capacity() - 1;
+  if (capacity() == 0) return 0;
+
+  size_type position = (h >> 7) & mask;
+  for (size_type step = _group;; step += _group) {
+    std::uint32_t bits = detail::ControlGroup(&_ctrl[position]).match_free();
+    if (bits) return (position + detail::lowest_bit(bits)) & mask;
+    position = (position + step) & mask;
+  }
+}
+
+/**
+ * Called when an insert would use up the last empty slot: doubles the table,
+ * or rehashes in place when tombstones are holding at least half of it.
+ */
+template<typename K, typename V, class H, class E, class A>
+void HashMap<K, V, H, E, A>::grow()
+{
+  if (capacity() && _size <= (capacity() - capacity() / 8) / 2) {
+    rehash(capacity());
+    if (_growthLeft) return;
+  }
+  rehash(capacity() * 2);
+}
+
+template<typename K, typename V, class H, class E, class A>
+void HashMap<K, V, H, E, A>::destroy_all() noexcept
+{
+  for (size_type i = 0; i < capacity(); ++i) {
+    if (_ctrl[i] >= 0) _allocator.destroy(slot(i));
+  }
+}
+
+} // namespace ctl
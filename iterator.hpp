@@ -1,6 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <iterator>
+#include <type_traits>
+#if defined(CTL_CHECKED_ITERATORS)
+#include <memory>
+#include <stdexcept>
+#endif
 
 
 namespace ctl {
@@ -8,6 +14,9 @@ namespace ctl {
 template<typename T>
 class Iterator;
 
+template<typename C, typename T, typename R = T&>
+class IndexIterator;
+
 } // namespace ctl
 
 
@@ -15,37 +24,93 @@ template<typename T>
 struct std::iterator_traits< ctl::Iterator<T> >
 {
   using difference_type = std::ptrdiff_t;
-  using value_type = T;
+  using value_type = typename std::remove_const<T>::type;
   using pointer = T*;
   using reference = T&;
   using iterator_category = std::random_access_iterator_tag;
+#if __cplusplus >= 202002L
+  using iterator_concept = std::contiguous_iterator_tag;
+#endif
+};
+
+template<typename C, typename T, typename R>
+struct std::iterator_traits< ctl::IndexIterator<C, T, R> >
+{
+  using difference_type = std::ptrdiff_t;
+  using value_type = typename std::remove_const<T>::type;
+  using pointer = typename std::conditional<std::is_reference<R>::value, T*, void>::type;
+  using reference = R;
+  using iterator_category = std::random_access_iterator_tag;
 };
 
 namespace ctl {
 
+#if defined(CTL_CHECKED_ITERATORS)
+namespace detail {
+
+/**
+ * What a checked iterator knows about its container: where the container
+ * keeps its live range, and a generation that the container bumps whenever
+ * it drops its buffer, invalidating every iterator handed out before.
+ */
+template<typename T>
+struct IteratorState
+{
+  T* const* begin;
+  T* const* last;
+  std::size_t generation = 0;
+
+  IteratorState(T* const* begin, T* const* last) : begin(begin), last(last) {}
+};
+
+} // namespace detail
+#endif
+
 /**
  * ctl::Iterator Definition
+ *
+ * Contiguous iterator that is nothing but a pointer: no vtable and no
+ * user-provided copy operations, so it is trivially copyable, is passed in
+ * a register and lets the optimizer treat loops over it as pointer loops.
+ * base() unwraps it for code that wants the raw pointer.
+ *
+ * Building with CTL_CHECKED_ITERATORS defined turns iterators handed out by
+ * ctl::Vector into checked ones that also carry their container's state:
+ * dereferencing outside the live range throws std::out_of_range, and using
+ * an iterator after a reallocation or mixing iterators of two containers
+ * throws std::logic_error. Iterators built from a bare pointer stay
+ * unchecked, and base() never checks.
  */
 
 template<typename T>
-class Iterator //: public std::iterator<std::random_access_iterator_tag, T>
+class Iterator
 {
 public:
   using traits = typename std::iterator_traits< ctl::Iterator<T> >;
 
   using difference_type = typename traits::difference_type;
   using value_type = typename traits::value_type;
+  using element_type = T;
   using pointer = typename traits::pointer;
   using reference = typename traits::reference;
   using iterator_category = typename traits::iterator_category;
+#if __cplusplus >= 202002L
+  using iterator_concept = typename traits::iterator_concept;
+#endif
+
+  Iterator() noexcept : ptr(nullptr) {}
+  Iterator(const typename std::iterator_traits< Iterator<T> >::pointer& ptr) noexcept : ptr(ptr) {}
+#if defined(CTL_CHECKED_ITERATORS)
+  using state_type = detail::IteratorState<value_type>;
+
+  Iterator(pointer ptr, std::shared_ptr<const state_type> state) : ptr(ptr), state(std::move(state)), generation(this->state->generation) {}
+  template<typename U, class = typename std::enable_if< std::is_convertible<U*, T*>::value >::type>
+  Iterator(const Iterator<U>& other) noexcept : ptr(other.ptr), state(other.state), generation(other.generation) {}
+#else
+  template<typename U, class = typename std::enable_if< std::is_convertible<U*, T*>::value >::type>
+  Iterator(const Iterator<U>& other) noexcept : ptr(other.base()) {}
+#endif
 
-  Iterator() : ptr(nullptr) {}
-  Iterator(const Iterator& other) : ptr(other.ptr) {}
-  Iterator(Iterator&& other) : ptr( std::move(other.ptr) ) {}
-  Iterator(const typename std::iterator_traits< Iterator<T> >::pointer& ptr) : ptr(ptr) {}
-  virtual ~Iterator() = default;
-
-  Iterator& operator=(const Iterator&);
   Iterator& operator++();
   Iterator& operator--();
   Iterator operator++(int);
@@ -67,21 +132,40 @@ public:
   bool operator<(const Iterator&) const;
   bool operator>(const Iterator&) const;
 
+  pointer base() const noexcept { return ptr; }
+
 private:
   pointer ptr;
+
+#if defined(CTL_CHECKED_ITERATORS)
+  template<typename U>
+  friend class Iterator;
+
+  std::shared_ptr<const state_type> state;
+  std::size_t generation = 0;
+
+  void check_valid() const;
+  void check_dereferenceable(difference_type) const;
+  void check_compatible(const Iterator&) const;
+#else
+  void check_valid() const noexcept {}
+  void check_dereferenceable(difference_type) const noexcept {}
+  void check_compatible(const Iterator&) const noexcept {}
+#endif
 };
 
+#if !defined(CTL_CHECKED_ITERATORS)
+static_assert(std::is_trivially_copyable< Iterator<int> >::value, "ctl::Iterator: must stay trivially copyable");
+static_assert(sizeof(Iterator<int>) == sizeof(int*), "ctl::Iterator: must stay a bare pointer");
+#endif
+
+template<typename T>
+Iterator<T> operator+(typename Iterator<T>::difference_type, const Iterator<T>&);
+
 /**
  * ctl::Iterator Implementation
  */
 
-template<typename T>
-Iterator<T>& Iterator<T>::operator=(const Iterator& other)
-{
-  ptr = other.ptr;
-  return *this;
-}
-
 template<typename T>
 Iterator<T>& Iterator<T>::operator++()
 {
@@ -129,42 +213,51 @@ Iterator<T>& Iterator<T>::operator-=(difference_type n)
 template<typename T>
 typename Iterator<T>::difference_type Iterator<T>::operator-(const Iterator& other) const
 {
+  check_compatible(other);
   return ptr - other.ptr;
 }
 
 template<typename T>
 Iterator<T> Iterator<T>::operator+(difference_type n) const
 {
-  return Iterator(ptr + n);
+  Iterator foo(*this);
+  foo.ptr += n;
+  return foo;
 }
 
 template<typename T>
 Iterator<T> Iterator<T>::operator-(difference_type n) const
 {
-  return Iterator(ptr - n);
+  Iterator foo(*this);
+  foo.ptr -= n;
+  return foo;
 }
 
 template<typename T>
 typename Iterator<T>::reference Iterator<T>::operator[](difference_type i) const
 {
+  check_dereferenceable(i);
   return ptr[i];
 }
 
 template<typename T>
 typename Iterator<T>::reference Iterator<T>::operator*() const
 {
+  check_dereferenceable(0);
   return *ptr;
 }
 
 template<typename T>
 typename Iterator<T>::pointer Iterator<T>::operator->() const
 {
+  check_dereferenceable(0);
   return ptr;
 }
 
 template<typename T>
 bool Iterator<T>::operator==(const Iterator& other) const
 {
+  check_compatible(other);
   return ptr == other.ptr;
 }
 
@@ -177,25 +270,262 @@ bool Iterator<T>::operator!=(const Iterator& other) const
 template<typename T>
 bool Iterator<T>::operator<=(const Iterator& other) const
 {
+  check_compatible(other);
   return ptr <= other.ptr;
 }
 
 template<typename T>
 bool Iterator<T>::operator>=(const Iterator& other) const
 {
+  check_compatible(other);
   return ptr >= other.ptr;
 }
 
 template<typename T>
 bool Iterator<T>::operator<(const Iterator& other) const
 {
+  check_compatible(other);
   return ptr < other.ptr;
 }
 
 template<typename T>
 bool Iterator<T>::operator>(const Iterator& other) const
 {
+  check_compatible(other);
   return ptr > other.ptr;
 }
 
+template<typename T>
+Iterator<T> operator+(typename Iterator<T>::difference_type n, const Iterator<T>& it)
+{
+  return it + n;
+}
+
+#if defined(CTL_CHECKED_ITERATORS)
+template<typename T>
+void Iterator<T>::check_valid() const
+{
+  if (state && state->generation != generation) {
+    throw std::logic_error("ctl::Iterator: iterator invalidated by reallocation");
+  }
+}
+
+template<typename T>
+void Iterator<T>::check_dereferenceable(difference_type i) const
+{
+  check_valid();
+  if (state && (ptr + i < *state->begin || ptr + i >= *state->last)) {
+    throw std::out_of_range("ctl::Iterator: dereference out of range");
+  }
+}
+
+template<typename T>
+void Iterator<T>::check_compatible(const Iterator& other) const
+{
+  check_valid();
+  other.check_valid();
+  if (state && other.state && state != other.state) {
+    throw std::logic_error("ctl::Iterator: iterators of different containers");
+  }
+}
+#endif
+
+namespace detail {
+
+/**
+ * Raw pointer behind a ctl::Iterator, any other iterator as is. Lets
+ * sequential paths hand std algorithms the pointers their fast paths
+ * are specialised for.
+ */
+template<typename It>
+inline It unwrap(It it) noexcept
+{
+  return it;
+}
+
+template<typename T>
+inline T* unwrap(Iterator<T> it) noexcept
+{
+  return it.base();
+}
+
+} // namespace detail
+
+/**
+ * ctl::IndexIterator Definition
+ *
+ * Random-access iterator for containers whose elements are not contiguous
+ * (segmented, gapped or wrapped storage). It stores the container and a
+ * logical index and dereferences through the container's operator[], so it
+ * stays valid across any change that keeps that index in range. Containers
+ * that hand out proxy objects instead of T& pass the proxy type as R; such
+ * iterators have no operator->.
+ */
+
+template<typename C, typename T, typename R>
+class IndexIterator
+{
+public:
+  using traits = typename std::iterator_traits< ctl::IndexIterator<C, T, R> >;
+
+  using difference_type = typename traits::difference_type;
+  using value_type = typename traits::value_type;
+  using pointer = typename traits::pointer;
+  using reference = typename traits::reference;
+  using iterator_category = typename traits::iterator_category;
+
+  IndexIterator() : container(nullptr), i(0) {}
+  IndexIterator(C* container, std::size_t i) : container(container), i(i) {}
+  template<typename D, typename U, typename S, class = typename std::enable_if< std::is_convertible<D*, C*>::value >::type>
+  IndexIterator(const IndexIterator<D, U, S>& other) : container(other.owner()), i(other.index()) {}
+
+  IndexIterator& operator++();
+  IndexIterator& operator--();
+  IndexIterator operator++(int);
+  IndexIterator operator--(int);
+  IndexIterator& operator+=(difference_type);
+  IndexIterator& operator-=(difference_type);
+  IndexIterator operator+(difference_type) const;
+  IndexIterator operator-(difference_type) const;
+  difference_type operator-(const IndexIterator&) const;
+
+  reference operator[](difference_type) const;
+  reference operator*() const;
+  pointer operator->() const;
+
+  bool operator==(const IndexIterator&) const;
+  bool operator!=(const IndexIterator&) const;
+  bool operator<=(const IndexIterator&) const;
+  bool operator>=(const IndexIterator&) const;
+  bool operator<(const IndexIterator&) const;
+  bool operator>(const IndexIterator&) const;
+
+  C* owner() const noexcept { return container; }
+  std::size_t index() const noexcept { return i; }
+
+private:
+  C* container;
+  std::size_t i;
+};
+
+/**
+ * ctl::IndexIterator Implementation
+ */
+
+template<typename C, typename T, typename R>
+IndexIterator<C, T, R>& IndexIterator<C, T, R>::operator++()
+{
+  ++i;
+  return *this;
+}
+
+template<typename C, typename T, typename R>
+IndexIterator<C, T, R>& IndexIterator<C, T, R>::operator--()
+{
+  --i;
+  return *this;
+}
+
+template<typename C, typename T, typename R>
+IndexIterator<C, T, R> IndexIterator<C, T, R>::operator++(int)
+{
+  IndexIterator foo(*this);
+  ++i;
+  return foo;
+}
+
+template<typename C, typename T, typename R>
+IndexIterator<C, T, R> IndexIterator<C, T, R>::operator--(int)
+{
+  IndexIterator foo(*this);
+  --i;
+  return foo;
+}
+
+template<typename C, typename T, typename R>
+IndexIterator<C, T, R>& IndexIterator<C, T, R>::operator+=(difference_type n)
+{
+  i += n;
+  return *this;
+}
+
+template<typename C, typename T, typename R>
+IndexIterator<C, T, R>& IndexIterator<C, T, R>::operator-=(difference_type n)
+{
+  i -= n;
+  return *this;
+}
+
+template<typename C, typename T, typename R>
+IndexIterator<C, T, R> IndexIterator<C, T, R>::operator+(difference_type n) const
+{
+  return IndexIterator(container, i + n);
+}
+
+template<typename C, typename T, typename R>
+IndexIterator<C, T, R> IndexIterator<C, T, R>::operator-(difference_type n) const
+{
+  return IndexIterator(container, i - n);
+}
+
+template<typename C, typename T, typename R>
+typename IndexIterator<C, T, R>::difference_type IndexIterator<C, T, R>::operator-(const IndexIterator& other) const
+{
+  return static_cast<difference_type>(i) - static_cast<difference_type>(other.i);
+}
+
+template<typename C, typename T, typename R>
+typename IndexIterator<C, T, R>::reference IndexIterator<C, T, R>::operator[](difference_type n) const
+{
+  return (*container)[i + n];
+}
+
+template<typename C, typename T, typename R>
+typename IndexIterator<C, T, R>::reference IndexIterator<C, T, R>::operator*() const
+{
+  return (*container)[i];
+}
+
+template<typename C, typename T, typename R>
+typename IndexIterator<C, T, R>::pointer IndexIterator<C, T, R>::operator->() const
+{
+  return &(*container)[i];
+}
+
+template<typename C, typename T, typename R>
+bool IndexIterator<C, T, R>::operator==(const IndexIterator& other) const
+{
+  return i == other.i && container == other.container;
+}
+
+template<typename C, typename T, typename R>
+bool IndexIterator<C, T, R>::operator!=(const IndexIterator& other) const
+{
+  return !(*this == other);
+}
+
+template<typename C, typename T, typename R>
+bool IndexIterator<C, T, R>::operator<=(const IndexIterator& other) const
+{
+  return i <= other.i;
+}
+
+template<typename C, typename T, typename R>
+bool IndexIterator<C, T, R>::operator>=(const IndexIterator& other) const
+{
+  return i >= other.i;
+}
+
+template<typename C, typename T, typename R>
+bool IndexIterator<C, T, R>::operator<(const IndexIterator& other) const
+{
+  return i < other.i;
+}
+
+template<typename C, typename T, typename R>
+bool IndexIterator<C, T, R>::operator>(const IndexIterator& other) const
+{
+  return i > other.i;
+}
+
 } // namespace ctl
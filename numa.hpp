@@ -0,0 +1,303 @@
+#pragma once
+
+#include <new>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <cstddef>
+#include <utility>
+#include <exception>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(CTL_USE_LIBNUMA)
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+
+namespace ctl {
+
+/**
+ * ctl::numa Definition
+ *
+ * Thin layer over libnuma. When the library is absent (or reports that
+ * NUMA is unavailable) the machine is treated as a single node and every
+ * placement request becomes a no-op, so callers never need to branch.
+ */
+
+enum class NumaPolicy
+{
+  Local,       // default kernel policy: pages land on the node that touches them first
+  Bind,        // pages are allocated on a single node only
+  Interleave   // pages are spread round-robin across all nodes
+};
+
+struct first_touch_t {};
+constexpr first_touch_t first_touch{};
+
+namespace numa {
+
+bool available() noexcept;
+int node_count() noexcept;
+int current_node() noexcept;
+bool run_on_node(int node) noexcept;
+bool place(void* p, std::size_t bytes, NumaPolicy policy, int node = -1) noexcept;
+
+template<typename F, typename R>
+void parallel_touch(std::size_t count, F&& body, R&& rollback);
+template<typename F>
+void parallel_touch(std::size_t count, F&& body);
+
+} // namespace numa
+
+
+/**
+ * ctl::NumaAllocator Definition
+ *
+ * Allocates page-aligned memory straight from the kernel and applies the
+ * requested placement policy before the pages are touched. Intended for
+ * large buffers; small requests still cost at least one page.
+ */
+
+template<typename T, NumaPolicy P = NumaPolicy::Interleave, int Node = 0>
+struct NumaAllocator
+{
+public:
+  using value_type = T;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using reference = T&;
+  using const_reference = const T&;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using is_always_equal = std::true_type;
+
+  template<typename U>
+  struct rebind { using other = NumaAllocator<U, P, Node>; };
+
+  NumaAllocator() noexcept {}
+  template<typename U>
+  NumaAllocator(const NumaAllocator<U, P, Node>&) noexcept {}
+
+  pointer allocate(size_type);
+  void deallocate(pointer, size_type);
+  size_type max_size() const noexcept;
+  template<typename... Args>
+  void construct(pointer, Args&&...);
+  void destroy(pointer);
+};
+
+
+/**
+ * ctl::numa Implementation
+ */
+
+namespace numa {
+
+inline bool available() noexcept
+{
+#if defined(CTL_USE_LIBNUMA)
+  static const bool isAvailable = numa_available() >= 0;
+  return isAvailable;
+#else
+  return false;
+#endif
+}
+
+inline int node_count() noexcept
+{
+#if defined(CTL_USE_LIBNUMA)
+  if (available()) {
+    return std::max(numa_num_configured_nodes(), 1);
+  }
+#endif
+  return 1;
+}
+
+inline int current_node() noexcept
+{
+#if defined(CTL_USE_LIBNUMA) && defined(__linux__)
+  if (available()) {
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : std::max(numa_node_of_cpu(cpu), 0);
+  }
+#endif
+  return 0;
+}
+
+inline bool run_on_node(int node) noexcept
+{
+#if defined(CTL_USE_LIBNUMA)
+  if (available()) {
+    return numa_run_on_node(node) == 0;
+  }
+#endif
+  return node == 0;
+}
+
+inline bool place(void* p, std::size_t bytes, NumaPolicy policy, int node) noexcept
+{
+#if defined(CTL_USE_LIBNUMA)
+  if (!available() || p == nullptr || bytes == 0 || policy == NumaPolicy::Local) {
+    return policy == NumaPolicy::Local;
+  }
+
+  const int maxNode = numa_max_node();
+  const std::size_t bitsPerWord = 8 * sizeof(unsigned long);
+  unsigned long mask[16] = {};
+  if (maxNode < 0 || static_cast<std::size_t>(maxNode) >= 16 * bitsPerWord) return false;
+
+  int mode = MPOL_INTERLEAVE;
+  if (policy == NumaPolicy::Bind) {
+    if (node < 0 || node > maxNode) return false;
+    mode = MPOL_BIND;
+    mask[node / bitsPerWord] |= 1ul << (node % bitsPerWord);
+  } else {
+    for (int i = 0; i <= maxNode; ++i) {
+      mask[i / bitsPerWord] |= 1ul << (i % bitsPerWord);
+    }
+  }
+  return mbind(p, bytes, mode, mask, maxNode + 2, 0) == 0;
+#else
+  (void)p;
+  (void)bytes;
+  (void)node;
+  return policy == NumaPolicy::Local;
+#endif
+}
+
+/**
+ * Splits [0, count) into contiguous blocks and runs body(first, last) for each
+ * on its own thread, pinned so that block k lands on node k * nodes / workers.
+ * Pages written by a block are therefore first-touched on that node.
+ * If any block throws, every block that finished is handed to rollback and the
+ * first exception is rethrown once all threads have joined.
+ */
+template<typename F, typename R>
+void parallel_touch(std::size_t count, F&& body, R&& rollback)
+{
+  const std::size_t minBlock = 4096;
+  const std::size_t nodes = node_count();
+  std::size_t workers = std::max<std::size_t>(std::thread::hardware_concurrency(), nodes);
+  workers = std::min(workers, std::max<std::size_t>(count / minBlock, 1));
+
+  if (workers <= 1) {
+    body(std::size_t(0), count);
+    return;
+  }
+
+  std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[workers]);
+  std::unique_ptr<std::thread[]> threads(new std::thread[workers]);
+  const std::size_t block = (count + workers - 1) / workers;
+
+  for (std::size_t w = 0; w < workers; ++w) {
+    const std::size_t first = std::min(w * block, count);
+    const std::size_t last = std::min(first + block, count);
+    const int node = static_cast<int>(w * nodes / workers);
+    threads[w] = std::thread([&body, &errors, w, first, last, node]() {
+      run_on_node(node);
+      try {
+        body(first, last);
+      } catch (...) {
+        errors[w] = std::current_exception();
+      }
+    });
+  }
+  for (std::size_t w = 0; w < workers; ++w) {
+    threads[w].join();
+  }
+
+  std::exception_ptr error;
+  for (std::size_t w = 0; w < workers; ++w) {
+    if (errors[w] && !error) error = errors[w];
+  }
+  if (!error) return;
+
+  for (std::size_t w = 0; w < workers; ++w) {
+    if (errors[w]) continue;
+    rollback(std::min(w * block, count), std::min((w + 1) * block, count));
+  }
+  std::rethrow_exception(error);
+}
+
+template<typename F>
+void parallel_touch(std::size_t count, F&& body)
+{
+  parallel_touch(count, std::forward<F>(body), [](std::size_t, std::size_t) {});
+}
+
+} // namespace numa
+
+
+/**
+ * ctl::NumaAllocator Implementation
+ */
+
+template<typename T, NumaPolicy P, int Node>
+typename NumaAllocator<T, P, Node>::pointer NumaAllocator<T, P, Node>::allocate(size_type n)
+{
+  if (n > max_size()) {
+    throw std::bad_alloc();
+  }
+  const size_type bytes = std::max<size_type>(n * sizeof(T), 1);
+#if defined(__linux__)
+  void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  numa::place(p, bytes, P, Node);
+  return static_cast<pointer>(p);
+#else
+  return static_cast<pointer>(operator new(bytes));
+#endif
+}
+
+template<typename T, NumaPolicy P, int Node>
+void NumaAllocator<T, P, Node>::deallocate(pointer p, size_type n)
+{
+  if (p == nullptr) return;
+#if defined(__linux__)
+  munmap(p, std::max<size_type>(n * sizeof(T), 1));
+#else
+  operator delete(p);
+#endif
+}
+
+template<typename T, NumaPolicy P, int Node>
+typename NumaAllocator<T, P, Node>::size_type NumaAllocator<T, P, Node>::max_size() const noexcept
+{
+  return std::numeric_limits<size_type>::max() / sizeof(T);
+}
+
+template<typename T, NumaPolicy P, int Node>
+template<typename... Args>
+void NumaAllocator<T, P, Node>::construct(pointer p, Args&&... args)
+{
+  ::new (static_cast<void*>(p)) value_type(std::forward<Args>(args)...);
+}
+
+template<typename T, NumaPolicy P, int Node>
+void NumaAllocator<T, P, Node>::destroy(pointer p)
+{
+  p->~value_type();
+}
+
+template<typename T, NumaPolicy P1, int N1, typename U, NumaPolicy P2, int N2>
+bool operator==(const NumaAllocator<T, P1, N1>&, const NumaAllocator<U, P2, N2>&)
+{
+  return P1 == P2 && N1 == N2;
+}
+
+template<typename T, NumaPolicy P1, int N1, typename U, NumaPolicy P2, int N2>
+bool operator!=(const NumaAllocator<T, P1, N1>& a, const NumaAllocator<U, P2, N2>& b)
+{
+  return !(a == b);
+}
+
+} // namespace ctl
@@ -0,0 +1,530 @@
+#pragma once
+
+#include <array>
+#include <limits>
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <initializer_list>
+
+#include "allocator.hpp"
+#include "iterator.hpp"
+#include "vector.hpp"
+
+
+namespace ctl {
+
+namespace detail {
+
+/**
+ * Extracts value J of a block of Bits-bit values. Word index and shift are
+ * template constants, so each call folds to one or two shifts and a mask.
+ */
+template<unsigned Bits, unsigned J>
+inline std::uint64_t unpack_one(const std::uint64_t* in) noexcept
+{
+  constexpr unsigned w = J * Bits / 64;
+  constexpr unsigned shift = J * Bits % 64;
+  std::uint64_t value = in[w] >> shift;
+  if (shift + Bits > 64) {
+    value |= in[w + 1] << ((64 - shift) % 64);
+  }
+  return value & (~std::uint64_t(0) >> (64 - Bits));
+}
+
+template<unsigned Bits, unsigned J>
+inline void pack_one(std::uint64_t value, std::uint64_t* out) noexcept
+{
+  constexpr unsigned w = J * Bits / 64;
+  constexpr unsigned shift = J * Bits % 64;
+  out[w] |= value << shift;
+  if (shift + Bits > 64) {
+    out[w + 1] |= value >> ((64 - shift) % 64);
+  }
+}
+
+/**
+ * Unpacks one block of 64 values of Bits bits each (exactly Bits words).
+ * The pack expansion unrolls the block into straight-line code the compiler
+ * can vectorize.
+ */
+template<unsigned Bits, typename T, std::size_t... J>
+void unpack_block(const std::uint64_t* in, T* out, T base, std::index_sequence<J...>) noexcept
+{
+  int expand[] = { (out[J] = static_cast<T>(unpack_one<Bits, J>(in)) + base, 0)... };
+  (void) expand;
+}
+
+template<unsigned Bits, typename T>
+void unpack_block(const std::uint64_t* in, T* out, T base) noexcept
+{
+  unpack_block<Bits>(in, out, base, std::make_index_sequence<64>());
+}
+
+/**
+ * Packs 64 values, already offset by the frame base, into Bits zeroed words.
+ */
+template<unsigned Bits, typename T, std::size_t... J>
+void pack_block(const T* in, std::uint64_t* out, std::index_sequence<J...>) noexcept
+{
+  int expand[] = { (pack_one<Bits, J>(static_cast<std::uint64_t>(in[J]), out), 0)... };
+  (void) expand;
+}
+
+template<unsigned Bits, typename T>
+void pack_block(const T* in, std::uint64_t* out) noexcept
+{
+  pack_block<Bits>(in, out, std::make_index_sequence<64>());
+}
+
+template<typename T, std::size_t... I>
+std::array<void (*)(const std::uint64_t*, T*, T), sizeof...(I)> unpack_table(std::index_sequence<I...>) noexcept
+{
+  return {{ &unpack_block<I + 1, T>... }};
+}
+
+template<typename T, std::size_t... I>
+std::array<void (*)(const T*, std::uint64_t*), sizeof...(I)> pack_table(std::index_sequence<I...>) noexcept
+{
+  return {{ &pack_block<I + 1, T>... }};
+}
+
+} // namespace detail
+
+
+/**
+ * ctl::PackedIntVector Definition
+ *
+ * Unsigned integers stored with a fixed bit width chosen at construction,
+ * packed back to back into 64-bit words, so a column of small values takes
+ * bit_width() / digits of the memory of a plain ctl::Vector<T>. Values are
+ * stored relative to a frame base (frame-of-reference coding); compress()
+ * picks the base and the narrowest width for a given range.
+ *
+ * Element access goes through a proxy reference. Every 64 elements fill
+ * exactly bit_width() words, so decode() and range assign() work a block at
+ * a time with a width-specialised kernel instead of bit by bit.
+ */
+
+template<typename T = std::uint64_t, class A = Allocator<std::uint64_t>>
+class PackedIntVector
+{
+  static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value, "ctl::PackedIntVector: T must be an unsigned integer type");
+
+public:
+  using word_type = std::uint64_t;
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using const_reference = T;
+
+  class reference
+  {
+  public:
+    reference(PackedIntVector* owner, size_type i) noexcept : _owner(owner), _i(i) {}
+    reference(const reference&) = default;
+
+    operator T() const noexcept { return const_cast<const PackedIntVector&>(*_owner)[_i]; }
+    reference& operator=(T value) { _owner->set(_i, value); return *this; }
+    reference& operator=(const reference& other) { return *this = T(other); }
+    friend void swap(reference a, reference b) { T value = a; a = T(b); b = value; }
+
+  private:
+    PackedIntVector* _owner;
+    size_type _i;
+  };
+
+  using iterator = ctl::IndexIterator<PackedIntVector, T, reference>;
+  using const_iterator = ctl::IndexIterator<const PackedIntVector, const T, T>;
+
+  static constexpr size_type bits_per_word = 64;
+  static constexpr size_type block_size = 64;
+
+  explicit PackedIntVector(unsigned = std::numeric_limits<T>::digits, T = T());
+  PackedIntVector(unsigned, std::initializer_list<T>, T = T());
+
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  static PackedIntVector compress(IteratorType, IteratorType);
+
+  iterator begin() noexcept;
+  iterator end() noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+  unsigned bit_width() const noexcept;
+  T base() const noexcept;
+  T max_value() const noexcept;
+  void resize(size_type);
+  void resize(size_type, T);
+  void reserve(size_type);
+  void shrink_to_fit();
+
+  reference at(size_type);
+  T at(size_type) const;
+  reference operator[](size_type) noexcept;
+  T operator[](size_type) const noexcept;
+  reference front();
+  reference back();
+  void set(size_type, T);
+  word_type* data() noexcept;
+  const word_type* data() const noexcept;
+  size_type word_count() const noexcept;
+
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  void assign(IteratorType, IteratorType);
+  void decode(size_type, size_type, T*) const;
+
+  void push_back(T);
+  void pop_back();
+  void swap(PackedIntVector&) noexcept;
+  void clear() noexcept;
+
+private:
+  using word_allocator = typename std::allocator_traits<A>::template rebind_alloc<word_type>;
+
+  Vector<word_type, word_allocator> _words;
+  size_type _size = 0;
+  unsigned _bits;
+  T _base;
+
+  static size_type words_for(size_type) noexcept;
+  word_type mask() const noexcept;
+  word_type encode(T) const;
+};
+
+
+/**
+ * ctl::PackedIntVector Implementation
+ */
+
+template<typename T, class A>
+constexpr typename PackedIntVector<T, A>::size_type PackedIntVector<T, A>::bits_per_word;
+
+template<typename T, class A>
+constexpr typename PackedIntVector<T, A>::size_type PackedIntVector<T, A>::block_size;
+
+template<typename T, class A>
+PackedIntVector<T, A>::PackedIntVector(unsigned bits, T base) : _bits(bits), _base(base)
+{
+  if (bits == 0 || bits > unsigned(std::numeric_limits<T>::digits)) {
+    throw std::invalid_argument("ctl::PackedIntVector: bit width out of range");
+  }
+}
+
+template<typename T, class A>
+PackedIntVector<T, A>::PackedIntVector(unsigned bits, std::initializer_list<T> list, T base) : PackedIntVector(bits, base)
+{
+  assign(list.begin(), list.end());
+}
+
+/**
+ * Builds a vector over [first, last) using the smallest value as the frame
+ * base and the fewest bits that cover the spread between min and max.
+ */
+template<typename T, class A>
+template<typename IteratorType, typename isIterator>
+PackedIntVector<T, A> PackedIntVector<T, A>::compress(IteratorType first, IteratorType last)
+{
+  if (first == last) return PackedIntVector(1);
+
+  auto bounds = std::minmax_element(first, last);
+  const T base = *bounds.first;
+  const word_type spread = static_cast<word_type>(T(*bounds.second - base));
+  unsigned bits = 1;
+  while (bits < bits_per_word && (spread >> bits)) ++bits;
+
+  PackedIntVector packed(bits, base);
+  packed.assign(first, last);
+  return packed;
+}
+
+template<typename T, class A>
+typename PackedIntVector<T, A>::iterator PackedIntVector<T, A>::begin() noexcept
+{
+  return iterator(this, 0);
+}
+
+template<typename T, class A>
+typename PackedIntVector<T, A>::iterator PackedIntVector<T, A>::end() noexcept
+{
+  return iterator(this, _size);
+}
+
+template<typename T, class A>
+typename PackedIntVector<T, A>::const_iterator PackedIntVector<T, A>::cbegin() const noexcept
+{
+  return const_iterator(this, 0);
+}
+
+template<typename T, class A>
+typename PackedIntVector<T, A>::const_iterator PackedIntVector<T, A>::cend() const noexcept
+{
+  return const_iterator(this, _size);
+}
+
+template<typename T, class A>
+inline typename PackedIntVector<T, A>::size_type PackedIntVector<T, A>::size() const noexcept
+{
+  return _size;
+}
+
+template<typename T, class A>
+inline typename PackedIntVector<T, A>::size_type PackedIntVector<T, A>::capacity() const noexcept
+{
+  return _words.capacity() * bits_per_word / _bits;
+}
+
+template<typename T, class A>
+inline bool PackedIntVector<T, A>::empty() const noexcept
+{
+  return _size == 0;
+}
+
+template<typename T, class A>
+inline unsigned PackedIntVector<T, A>::bit_width() const noexcept
+{
+  return _bits;
+}
+
+template<typename T, class A>
+inline T PackedIntVector<T, A>::base() const noexcept
+{
+  return _base;
+}
+
+template<typename T, class A>
+T PackedIntVector<T, A>::max_value() const noexcept
+{
+  return static_cast<T>(_base + static_cast<T>(mask()));
+}
+
+template<typename T, class A>
+void PackedIntVector<T, A>::resize(size_type newSize)
+{
+  resize(newSize, _base);
+}
+
+template<typename T, class A>
+void PackedIntVector<T, A>::resize(size_type newSize, T value)
+{
+  if (newSize <= _size) {
+    _size = newSize;
+    _words.resize(words_for(newSize * _bits));
+    return;
+  }
+  reserve(newSize);
+  while (_size < newSize) {
+    push_back(value);
+  }
+}
+
+template<typename T, class A>
+void PackedIntVector<T, A>::reserve(size_type newCapacity)
+{
+  _words.reserve(words_for(newCapacity * _bits));
+}
+
+template<typename T, class A>
+void PackedIntVector<T, A>::shrink_to_fit()
+{
+  _words.shrink_to_fit();
+}
+
+template<typename T, class A>
+typename PackedIntVector<T, A>::reference PackedIntVector<T, A>::at(size_type i)
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::PackedIntVector: out of range");
+  }
+  return (*this)[i];
+}
+
+template<typename T, class A>
+T PackedIntVector<T, A>::at(size_type i) const
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::PackedIntVector: out of range");
+  }
+  return (*this)[i];
+}
+
+template<typename T, class A>
+inline typename PackedIntVector<T, A>::reference PackedIntVector<T, A>::operator[](size_type i) noexcept
+{
+  return reference(this, i);
+}
+
+template<typename T, class A>
+inline T PackedIntVector<T, A>::operator[](size_type i) const noexcept
+{
+  const size_type pos = i * _bits;
+  const size_type w = pos / bits_per_word;
+  const size_type shift = pos % bits_per_word;
+  word_type value = _words[w] >> shift;
+  if (shift + _bits > bits_per_word) {
+    value |= _words[w + 1] << (bits_per_word - shift);
+  }
+  return static_cast<T>(value & mask()) + _base;
+}
+
+template<typename T, class A>
+typename PackedIntVector<T, A>::reference PackedIntVector<T, A>::front()
+{
+  return (*this)[0];
+}
+
+template<typename T, class A>
+typename PackedIntVector<T, A>::reference PackedIntVector<T, A>::back()
+{
+  return (*this)[_size - 1];
+}
+
+template<typename T, class A>
+void PackedIntVector<T, A>::set(size_type i, T value)
+{
+  const word_type bits = encode(value);
+  const size_type pos = i * _bits;
+  const size_type w = pos / bits_per_word;
+  const size_type shift = pos % bits_per_word;
+  _words[w] = (_words[w] & ~(mask() << shift)) | (bits << shift);
+  if (shift + _bits > bits_per_word) {
+    const size_type rest = bits_per_word - shift;
+    _words[w + 1] = (_words[w + 1] & ~(mask() >> rest)) | (bits >> rest);
+  }
+}
+
+template<typename T, class A>
+inline typename PackedIntVector<T, A>::word_type* PackedIntVector<T, A>::data() noexcept
+{
+  return _words.data();
+}
+
+template<typename T, class A>
+inline const typename PackedIntVector<T, A>::word_type* PackedIntVector<T, A>::data() const noexcept
+{
+  return _words.data();
+}
+
+template<typename T, class A>
+inline typename PackedIntVector<T, A>::size_type PackedIntVector<T, A>::word_count() const noexcept
+{
+  return _words.size();
+}
+
+/**
+ * Replaces the contents with [first, last). Whole blocks of 64 values are
+ * staged and packed by the width-specialised kernel; the tail goes through
+ * push_back.
+ */
+template<typename T, class A>
+template<typename IteratorType, typename isIterator>
+void PackedIntVector<T, A>::assign(IteratorType first, IteratorType last)
+{
+  static const auto pack = detail::pack_table<T>(std::make_index_sequence<std::numeric_limits<T>::digits>());
+
+  clear();
+  T block[block_size];
+  size_type staged = 0;
+  for (; first != last; ++first) {
+    block[staged++] = static_cast<T>(encode(*first));
+    if (staged == block_size) {
+      const size_type w = _words.size();
+      _words.resize(w + _bits);
+      pack[_bits - 1](block, &_words[w]);
+      _size += block_size;
+      staged = 0;
+    }
+  }
+  for (size_type j = 0; j < staged; ++j) {
+    push_back(static_cast<T>(block[j] + _base));
+  }
+}
+
+/**
+ * Writes elements [first, first + count) to out. Whole blocks are unpacked
+ * by the width-specialised kernel, which is where sequential scans should go
+ * instead of element-wise operator[].
+ */
+template<typename T, class A>
+void PackedIntVector<T, A>::decode(size_type first, size_type count, T* out) const
+{
+  static const auto unpack = detail::unpack_table<T>(std::make_index_sequence<std::numeric_limits<T>::digits>());
+
+  if (first + count > _size) {
+    throw std::out_of_range("ctl::PackedIntVector: out of range");
+  }
+  const size_type last = first + count;
+  for (; first < last && first % block_size; ++first) {
+    *out++ = (*this)[first];
+  }
+  for (; first + block_size <= last; first += block_size, out += block_size) {
+    unpack[_bits - 1](&_words[first / block_size * _bits], out, _base);
+  }
+  for (; first < last; ++first) {
+    *out++ = (*this)[first];
+  }
+}
+
+template<typename T, class A>
+void PackedIntVector<T, A>::push_back(T value)
+{
+  const word_type bits = encode(value);
+  if (words_for((_size + 1) * _bits) > _words.size()) {
+    _words.push_back(word_type(0));
+  }
+  ++_size;
+  set(_size - 1, static_cast<T>(bits + _base));
+}
+
+template<typename T, class A>
+void PackedIntVector<T, A>::pop_back()
+{
+  --_size;
+  _words.resize(words_for(_size * _bits));
+}
+
+template<typename T, class A>
+void PackedIntVector<T, A>::swap(PackedIntVector& other) noexcept
+{
+  _words.swap(other._words);
+  std::swap(_size, other._size);
+  std::swap(_bits, other._bits);
+  std::swap(_base, other._base);
+}
+
+template<typename T, class A>
+void PackedIntVector<T, A>::clear() noexcept
+{
+  _words.clear();
+  _size = 0;
+}
+
+template<typename T, class A>
+inline typename PackedIntVector<T, A>::size_type PackedIntVector<T, A>::words_for(size_type bits) noexcept
+{
+  return (bits + bits_per_word - 1) / bits_per_word;
+}
+
+template<typename T, class A>
+inline typename PackedIntVector<T, A>::word_type PackedIntVector<T, A>::mask() const noexcept
+{
+  return ~word_type(0) >> (bits_per_word - _bits);
+}
+
+template<typename T, class A>
+typename PackedIntVector<T, A>::word_type PackedIntVector<T, A>::encode(T value) const
+{
+  if (value < _base || static_cast<word_type>(T(value - _base)) > mask()) {
+    throw std::out_of_range("ctl::PackedIntVector: value does not fit the bit width");
+  }
+  return static_cast<word_type>(T(value - _base));
+}
+
+} // namespace ctl
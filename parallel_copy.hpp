@@ -0,0 +1,210 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <utility>
+#include <exception>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "thread_pool.hpp"
+
+
+#ifndef CTL_PARALLEL_COPY_THRESHOLD
+#define CTL_PARALLEL_COPY_THRESHOLD 0
+#endif
+
+
+namespace ctl {
+
+/**
+ * Element count from which Vector copy-construction, copy-assignment and
+ * reallocation split the work across ThreadPool::instance(). Zero (the
+ * default unless CTL_PARALLEL_COPY_THRESHOLD says otherwise) keeps every
+ * copy on the calling thread.
+ */
+
+inline std::atomic<std::size_t>& parallel_copy_threshold_storage() noexcept
+{
+  static std::atomic<std::size_t> threshold(CTL_PARALLEL_COPY_THRESHOLD);
+  return threshold;
+}
+
+inline std::size_t parallel_copy_threshold() noexcept
+{
+  return parallel_copy_threshold_storage().load(std::memory_order_relaxed);
+}
+
+inline void set_parallel_copy_threshold(std::size_t count) noexcept
+{
+  parallel_copy_threshold_storage().store(count, std::memory_order_relaxed);
+}
+
+
+namespace detail {
+
+inline bool use_parallel_copy(std::size_t count) noexcept
+{
+  std::size_t threshold = parallel_copy_threshold();
+  return threshold != 0 && count >= threshold;
+}
+
+/**
+ * memcpy that bypasses the cache for the destination. Worth it only for
+ * blocks well beyond the last-level cache, which is the only place the
+ * parallel copy path calls it from.
+ */
+inline void stream_copy(void* dst, const void* src, std::size_t bytes) noexcept
+{
+#if defined(__SSE2__)
+  char* out = static_cast<char*>(dst);
+  const char* in = static_cast<const char*>(src);
+  std::size_t head = (16 - reinterpret_cast<std::uintptr_t>(out) % 16) % 16;
+  if (head > bytes) head = bytes;
+  std::memcpy(out, in, head);
+  out += head;
+  in += head;
+  bytes -= head;
+
+  for (; bytes >= 64; bytes -= 64, out += 64, in += 64) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 32));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 48));
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out), a);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + 16), b);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + 32), c);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + 48), d);
+  }
+  std::memcpy(out, in, bytes);
+  _mm_sfence();
+#else
+  std::memcpy(dst, src, bytes);
+#endif
+}
+
+/**
+ * Runs body(first, last) over fixed blocks of [0, n) on the pool. If any
+ * block throws, rollback(first, last) is called for every block that
+ * completed and the first exception is rethrown, so the caller observes
+ * either the whole range processed or none of it.
+ */
+template<typename F, typename R>
+void parallel_blocks(std::size_t n, F&& body, R&& rollback)
+{
+  ThreadPool& pool = ThreadPool::instance();
+  const std::size_t blocks = std::max<std::size_t>(std::min(pool.size() * 4, n), 1);
+  std::unique_ptr<std::atomic<bool>[]> done(new std::atomic<bool>[blocks]);
+  for (std::size_t b = 0; b < blocks; ++b) {
+    done[b] = false;
+  }
+
+  auto bound = [n, blocks](std::size_t b) { return n / blocks * b + std::min(b, n % blocks); };
+  auto run = [&](std::size_t b) {
+    body(bound(b), bound(b + 1));
+    done[b] = true;
+  };
+
+  std::exception_ptr error;
+  {
+    TaskGroup group(pool);
+    for (std::size_t b = 1; b < blocks; ++b) {
+      group.run([&run, b]() { run(b); });
+    }
+    try {
+      run(0);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    try {
+      group.wait();
+    } catch (...) {
+      if (!error) error = std::current_exception();
+    }
+  }
+  if (!error) return;
+
+  for (std::size_t b = 0; b < blocks; ++b) {
+    if (done[b]) rollback(bound(b), bound(b + 1));
+  }
+  std::rethrow_exception(error);
+}
+
+/**
+ * Constructs n elements at dst from src, either copying or (when Move is
+ * set) moving the ones whose move constructor cannot throw. Provides the
+ * strong guarantee: on exception no constructed element is left behind.
+ */
+template<bool Move, typename A, typename T>
+void uninitialized_transfer_n(A& allocator, T* src, std::size_t n, T* dst)
+{
+  using Source = typename std::conditional<
+      Move && (std::is_nothrow_move_constructible<T>::value || !std::is_copy_constructible<T>::value),
+      T&&,
+      const T&
+    >::type;
+
+  if (n == 0) return;
+
+  if (std::is_trivially_copyable<T>::value) {
+    if (use_parallel_copy(n)) {
+      parallel_blocks(
+          n,
+          [src, dst](std::size_t first, std::size_t last) {
+            stream_copy(dst + first, src + first, (last - first) * sizeof(T));
+          },
+          [](std::size_t, std::size_t) {}
+        );
+    } else {
+      std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+    }
+    return;
+  }
+
+  auto construct = [&allocator, src, dst](std::size_t first, std::size_t last) {
+    std::size_t i = first;
+    try {
+      for (; i < last; ++i) {
+        allocator.construct(dst + i, static_cast<Source>(src[i]));
+      }
+    } catch (...) {
+      while (i-- > first) {
+        allocator.destroy(dst + i);
+      }
+      throw;
+    }
+  };
+  auto destroy = [&allocator, dst](std::size_t first, std::size_t last) {
+    for (std::size_t i = first; i < last; ++i) {
+      allocator.destroy(dst + i);
+    }
+  };
+
+  if (use_parallel_copy(n)) {
+    parallel_blocks(n, construct, destroy);
+  } else {
+    construct(0, n);
+  }
+}
+
+template<typename A, typename T>
+void uninitialized_copy_n(A& allocator, const T* src, std::size_t n, T* dst)
+{
+  uninitialized_transfer_n<false>(allocator, const_cast<T*>(src), n, dst);
+}
+
+template<typename A, typename T>
+void uninitialized_move_n(A& allocator, T* src, std::size_t n, T* dst)
+{
+  uninitialized_transfer_n<true>(allocator, src, n, dst);
+}
+
+} // namespace detail
+
+} // namespace ctl
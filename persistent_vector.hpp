@@ -0,0 +1,771 @@
+#pragma once
+
+#include <new>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <initializer_list>
+
+#include "allocator.hpp"
+#include "iterator.hpp"
+#include "vector.hpp"
+
+
+namespace ctl {
+
+template<typename T, class A>
+class TransientVector;
+
+namespace detail {
+
+/**
+ * Free-list pool of fixed-size blocks carved from slabs of words obtained
+ * through A. There is one pool per block size and allocator type; like
+ * ctl::MemoryPool it keeps its memory for reuse until the program exits.
+ */
+template<class A, std::size_t Words>
+class NodePool
+{
+public:
+  static NodePool& instance()
+  {
+    static NodePool pool;
+    return pool;
+  }
+
+  void* get();
+  void put(void*) noexcept;
+
+private:
+  using word_type = std::uint64_t;
+  using word_allocator = typename std::allocator_traits<A>::template rebind_alloc<word_type>;
+
+  static constexpr std::size_t _slabBlocks = 64;
+
+  struct FreeBlock
+  {
+    FreeBlock* next;
+  };
+
+  std::mutex _lock;
+  word_allocator _allocator;
+  FreeBlock* _free = nullptr;
+};
+
+template<class A, std::size_t Words>
+void* NodePool<A, Words>::get()
+{
+  std::lock_guard<std::mutex> guard(_lock);
+  if (!_free) {
+    word_type* slab = _allocator.allocate(Words * _slabBlocks);
+    for (std::size_t i = _slabBlocks; i-- > 0;) {
+      FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * Words);
+      block->next = _free;
+      _free = block;
+    }
+  }
+  FreeBlock* block = _free;
+  _free = block->next;
+  return block;
+}
+
+template<class A, std::size_t Words>
+void NodePool<A, Words>::put(void* p) noexcept
+{
+  std::lock_guard<std::mutex> guard(_lock);
+  FreeBlock* block = static_cast<FreeBlock*>(p);
+  block->next = _free;
+  _free = block;
+}
+
+
+/**
+ * 32-way radix-balanced trie with a separate tail leaf, the shared core of
+ * ctl::PersistentVector and ctl::TransientVector. Nodes are reference
+ * counted; copying a tree is O(1) and every mutator copies a node only if
+ * another tree still shares it, so an edit on a fresh copy rewrites one
+ * root-to-leaf path and an edit on a tree that owns its nodes is in place.
+ */
+template<typename T, class A>
+class RadixTree
+{
+public:
+  using size_type = std::size_t;
+
+  static constexpr unsigned bits = 5;
+  static constexpr size_type width = size_type(1) << bits;
+
+  RadixTree() noexcept {};
+  RadixTree(const RadixTree&) noexcept;
+  RadixTree(RadixTree&&) noexcept;
+  ~RadixTree();
+
+  RadixTree& operator=(RadixTree) noexcept;
+
+  size_type size() const noexcept;
+  const T& operator[](size_type) const noexcept;
+  const T* leaf(size_type) const noexcept;
+
+  void push_back(const T&);
+  void set(size_type, const T&);
+  void pop_back();
+  void swap(RadixTree&) noexcept;
+
+private:
+  struct Node
+  {
+    std::atomic<size_type> refs{1};
+    bool isLeaf;
+
+    explicit Node(bool isLeaf) : isLeaf(isLeaf) {}
+  };
+
+  struct Inner : Node
+  {
+    Node* children[width] = {};
+
+    Inner() : Node(false) {}
+  };
+
+  struct Leaf : Node
+  {
+    size_type count = 0;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type items[width];
+
+    Leaf() : Node(true) {}
+    T* item(size_type i) noexcept { return reinterpret_cast<T*>(&items[i]); }
+    const T* item(size_type i) const noexcept { return reinterpret_cast<const T*>(&items[i]); }
+  };
+
+  using inner_pool = NodePool<A, (sizeof(Inner) + 7) / 8>;
+  using leaf_pool = NodePool<A, (sizeof(Leaf) + 7) / 8>;
+
+  static_assert(alignof(Leaf) <= alignof(std::uint64_t), "ctl::PersistentVector: T needs stronger alignment than a word");
+
+  Node* _root = nullptr;
+  Node* _tail = nullptr;
+  size_type _size = 0;
+  unsigned _shift = bits;
+
+  size_type tail_offset() const noexcept;
+  const Leaf* leaf_node(size_type) const noexcept;
+  static Inner* make_inner();
+  static Leaf* make_leaf();
+  static Node* clone(Node*);
+  static void release(Node*) noexcept;
+  static Node* own(Node*&);
+  Node* push_tail(unsigned, Node*, Node*);
+  static Node* new_path(unsigned, Node*);
+  Node* pop_tail(unsigned, Node*);
+};
+
+} // namespace detail
+
+
+/**
+ * ctl::PersistentVector Definition
+ *
+ * Immutable vector with structural sharing: push_back(), set() and
+ * pop_back() leave *this untouched and return a new version that shares all
+ * but one root-to-leaf path with it, so keeping many near-identical versions
+ * costs memory proportional to the number of edits. Lookups walk at most
+ * log32(n) nodes. Versions are cheap to copy and safe to share between
+ * threads.
+ *
+ * For bulk edits, transient() hands out a ctl::TransientVector that mutates
+ * in place and is turned back into a version with persistent().
+ */
+
+template<typename T, class A = Allocator<T>>
+class PersistentVector
+{
+public:
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using const_reference = const T&;
+  using const_iterator = ctl::IndexIterator<const PersistentVector, const T>;
+  using iterator = const_iterator;
+
+  PersistentVector() noexcept {};
+  PersistentVector(std::initializer_list<T>);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  PersistentVector(IteratorType, IteratorType);
+  explicit PersistentVector(const Vector<T, A>&);
+
+  const_iterator begin() const noexcept;
+  const_iterator end() const noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  bool empty() const noexcept;
+
+  const_reference at(size_type) const;
+  const_reference operator[](size_type) const noexcept;
+  const_reference front() const noexcept;
+  const_reference back() const noexcept;
+
+  PersistentVector push_back(const T&) const;
+  PersistentVector set(size_type, const T&) const;
+  PersistentVector pop_back() const;
+
+  TransientVector<T, A> transient() const noexcept;
+  Vector<T, A> to_vector() const;
+
+  void swap(PersistentVector&) noexcept;
+
+private:
+  friend class TransientVector<T, A>;
+
+  detail::RadixTree<T, A> _tree;
+};
+
+
+/**
+ * ctl::TransientVector Definition
+ *
+ * Mutable builder over the same trie as ctl::PersistentVector. Nodes it
+ * already owns are edited in place; nodes still shared with a version are
+ * copied once on first touch. persistent() freezes the result in O(1).
+ */
+
+template<typename T, class A = Allocator<T>>
+class TransientVector
+{
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using const_reference = const T&;
+
+  TransientVector() noexcept {};
+
+  size_type size() const noexcept;
+  bool empty() const noexcept;
+  const_reference at(size_type) const;
+  const_reference operator[](size_type) const noexcept;
+
+  void push_back(const T&);
+  void set(size_type, const T&);
+  void pop_back();
+
+  PersistentVector<T, A> persistent() noexcept;
+
+private:
+  friend class PersistentVector<T, A>;
+
+  detail::RadixTree<T, A> _tree;
+};
+
+
+/**
+ * ctl::detail::RadixTree Implementation
+ */
+
+namespace detail {
+
+template<typename T, class A>
+constexpr unsigned RadixTree<T, A>::bits;
+
+template<typename T, class A>
+constexpr typename RadixTree<T, A>::size_type RadixTree<T, A>::width;
+
+template<typename T, class A>
+RadixTree<T, A>::RadixTree(const RadixTree& other) noexcept
+  : _root(other._root), _tail(other._tail), _size(other._size), _shift(other._shift)
+{
+  if (_root) _root->refs.fetch_add(1, std::memory_order_relaxed);
+  if (_tail) _tail->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename T, class A>
+RadixTree<T, A>::RadixTree(RadixTree&& other) noexcept
+{
+  swap(other);
+}
+
+template<typename T, class A>
+RadixTree<T, A>::~RadixTree()
+{
+  release(_root);
+  release(_tail);
+}
+
+template<typename T, class A>
+RadixTree<T, A>& RadixTree<T, A>::operator=(RadixTree other) noexcept
+{
+  swap(other);
+  return *this;
+}
+
+template<typename T, class A>
+inline typename RadixTree<T, A>::size_type RadixTree<T, A>::size() const noexcept
+{
+  return _size;
+}
+
+template<typename T, class A>
+inline const T& RadixTree<T, A>::operator[](size_type i) const noexcept
+{
+  return leaf(i)[i & (width - 1)];
+}
+
+/**
+ * Returns the first element of the leaf holding element i.
+ */
+template<typename T, class A>
+inline const T* RadixTree<T, A>::leaf(size_type i) const noexcept
+{
+  return leaf_node(i)->item(0);
+}
+
+template<typename T, class A>
+void RadixTree<T, A>::push_back(const T& value)
+{
+  if (_tail && static_cast<Leaf*>(_tail)->count == width) {
+    Leaf* fresh = make_leaf();
+    try {
+      ::new (static_cast<void*>(fresh->item(0))) T(value);
+      fresh->count = 1;
+      if (!_root) {
+        Inner* root = make_inner();
+        root->children[0] = _tail;
+        _root = root;
+      } else if ((_size >> bits) > (size_type(1) << _shift)) {
+        Inner* root = make_inner();
+        root->children[0] = _root;
+        root->children[1] = new_path(_shift, _tail);
+        _root = root;
+        _shift += bits;
+      } else {
+        _root = push_tail(_shift, own(_root), _tail);
+      }
+    } catch (...) {
+      release(fresh);
+      throw;
+    }
+    _tail = fresh;
+    ++_size;
+    return;
+  }
+
+  if (!_tail) {
+    _tail = make_leaf();
+  }
+  Leaf* tail = static_cast<Leaf*>(own(_tail));
+  ::new (static_cast<void*>(tail->item(tail->count))) T(value);
+  ++tail->count;
+  ++_size;
+}
+
+template<typename T, class A>
+void RadixTree<T, A>::set(size_type i, const T& value)
+{
+  Node** slot = &_tail;
+  if (i < tail_offset()) {
+    slot = &_root;
+    for (unsigned level = _shift; level > 0; level -= bits) {
+      slot = &static_cast<Inner*>(own(*slot))->children[(i >> level) & (width - 1)];
+    }
+  }
+  *static_cast<Leaf*>(own(*slot))->item(i & (width - 1)) = value;
+}
+
+template<typename T, class A>
+void RadixTree<T, A>::pop_back()
+{
+  if (_size == 0) {
+    throw std::out_of_range("ctl::PersistentVector: pop_back on empty vector");
+  }
+  if (_size == 1) {
+    RadixTree().swap(*this);
+    return;
+  }
+  if (static_cast<Leaf*>(_tail)->count > 1) {
+    Leaf* tail = static_cast<Leaf*>(own(_tail));
+    tail->item(--tail->count)->~T();
+    --_size;
+    return;
+  }
+
+  Node* last = const_cast<Leaf*>(leaf_node(_size - 2));
+  last->refs.fetch_add(1, std::memory_order_relaxed);
+  release(_tail);
+  _tail = last;
+
+  _root = pop_tail(_shift, own(_root));
+  if (_root && _shift > bits && !static_cast<Inner*>(_root)->children[1]) {
+    Inner* root = static_cast<Inner*>(_root);
+    _root = root->children[0];
+    root->children[0] = nullptr;
+    release(root);
+    _shift -= bits;
+  }
+  --_size;
+}
+
+template<typename T, class A>
+void RadixTree<T, A>::swap(RadixTree& other) noexcept
+{
+  std::swap(_root, other._root);
+  std::swap(_tail, other._tail);
+  std::swap(_size, other._size);
+  std::swap(_shift, other._shift);
+}
+
+template<typename T, class A>
+inline typename RadixTree<T, A>::size_type RadixTree<T, A>::tail_offset() const noexcept
+{
+  return _size < width ? 0 : ((_size - 1) >> bits) << bits;
+}
+
+template<typename T, class A>
+const typename RadixTree<T, A>::Leaf* RadixTree<T, A>::leaf_node(size_type i) const noexcept
+{
+  const Node* node = _tail;
+  if (i < tail_offset()) {
+    node = _root;
+    for (unsigned level = _shift; level > 0; level -= bits) {
+      node = static_cast<const Inner*>(node)->children[(i >> level) & (width - 1)];
+    }
+  }
+  return static_cast<const Leaf*>(node);
+}
+
+template<typename T, class A>
+typename RadixTree<T, A>::Inner* RadixTree<T, A>::make_inner()
+{
+  return ::new (inner_pool::instance().get()) Inner();
+}
+
+template<typename T, class A>
+typename RadixTree<T, A>::Leaf* RadixTree<T, A>::make_leaf()
+{
+  return ::new (leaf_pool::instance().get()) Leaf();
+}
+
+template<typename T, class A>
+typename RadixTree<T, A>::Node* RadixTree<T, A>::clone(Node* node)
+{
+  if (!node->isLeaf) {
+    Inner* copy = make_inner();
+    for (size_type i = 0; i < width; ++i) {
+      Node* child = static_cast<Inner*>(node)->children[i];
+      if (child) child->refs.fetch_add(1, std::memory_order_relaxed);
+      copy->children[i] = child;
+    }
+    return copy;
+  }
+
+  Leaf* source = static_cast<Leaf*>(node);
+  Leaf* copy = make_leaf();
+  try {
+    for (; copy->count < source->count; ++copy->count) {
+      ::new (static_cast<void*>(copy->item(copy->count))) T(*source->item(copy->count));
+    }
+  } catch (...) {
+    release(copy);
+    throw;
+  }
+  return copy;
+}
+
+template<typename T, class A>
+void RadixTree<T, A>::release(Node* node) noexcept
+{
+  if (!node || node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+  if (node->isLeaf) {
+    Leaf* leaf = static_cast<Leaf*>(node);
+    for (size_type i = 0; i < leaf->count; ++i) {
+      leaf->item(i)->~T();
+    }
+    leaf->~Leaf();
+    leaf_pool::instance().put(leaf);
+  } else {
+    Inner* inner = static_cast<Inner*>(node);
+    for (size_type i = 0; i < width; ++i) {
+      release(inner->children[i]);
+    }
+    inner->~Inner();
+    inner_pool::instance().put(inner);
+  }
+}
+
+/**
+ * Makes the node in slot exclusive to this tree, copying it if another tree
+ * still references it, and returns it.
+ */
+template<typename T, class A>
+typename RadixTree<T, A>::Node* RadixTree<T, A>::own(Node*& slot)
+{
+  if (slot->refs.load(std::memory_order_acquire) != 1) {
+    Node* copy = clone(slot);
+    release(slot);
+    slot = copy;
+  }
+  return slot;
+}
+
+template<typename T, class A>
+typename RadixTree<T, A>::Node* RadixTree<T, A>::push_tail(unsigned level, Node* node, Node* tail)
+{
+  Inner* parent = static_cast<Inner*>(node);
+  const size_type sub = ((_size - 1) >> level) & (width - 1);
+  if (level == bits) {
+    parent->children[sub] = tail;
+  } else if (parent->children[sub]) {
+    parent->children[sub] = push_tail(level - bits, own(parent->children[sub]), tail);
+  } else {
+    parent->children[sub] = new_path(level - bits, tail);
+  }
+  return parent;
+}
+
+template<typename T, class A>
+typename RadixTree<T, A>::Node* RadixTree<T, A>::new_path(unsigned level, Node* tail)
+{
+  if (level == 0) return tail;
+  Inner* node = make_inner();
+  node->children[0] = new_path(level - bits, tail);
+  return node;
+}
+
+template<typename T, class A>
+typename RadixTree<T, A>::Node* RadixTree<T, A>::pop_tail(unsigned level, Node* node)
+{
+  Inner* inner = static_cast<Inner*>(node);
+  const size_type sub = ((_size - 2) >> level) & (width - 1);
+  if (level > bits) {
+    Node* child = pop_tail(level - bits, own(inner->children[sub]));
+    inner->children[sub] = child;
+    if (!child && sub == 0) {
+      release(inner);
+      return nullptr;
+    }
+    return inner;
+  }
+  if (sub == 0) {
+    release(inner);
+    return nullptr;
+  }
+  release(inner->children[sub]);
+  inner->children[sub] = nullptr;
+  return inner;
+}
+
+} // namespace detail
+
+
+/**
+ * ctl::PersistentVector Implementation
+ */
+
+template<typename T, class A>
+PersistentVector<T, A>::PersistentVector(std::initializer_list<T> list) : PersistentVector(list.begin(), list.end()) {}
+
+template<typename T, class A>
+template<typename IteratorType, typename isIterator>
+PersistentVector<T, A>::PersistentVector(IteratorType first, IteratorType last)
+{
+  for (; first != last; ++first) {
+    _tree.push_back(*first);
+  }
+}
+
+template<typename T, class A>
+PersistentVector<T, A>::PersistentVector(const Vector<T, A>& other) : PersistentVector(other.cbegin(), other.cend()) {}
+
+template<typename T, class A>
+typename PersistentVector<T, A>::const_iterator PersistentVector<T, A>::begin() const noexcept
+{
+  return const_iterator(this, 0);
+}
+
+template<typename T, class A>
+typename PersistentVector<T, A>::const_iterator PersistentVector<T, A>::end() const noexcept
+{
+  return const_iterator(this, size());
+}
+
+template<typename T, class A>
+typename PersistentVector<T, A>::const_iterator PersistentVector<T, A>::cbegin() const noexcept
+{
+  return begin();
+}
+
+template<typename T, class A>
+typename PersistentVector<T, A>::const_iterator PersistentVector<T, A>::cend() const noexcept
+{
+  return end();
+}
+
+template<typename T, class A>
+inline typename PersistentVector<T, A>::size_type PersistentVector<T, A>::size() const noexcept
+{
+  return _tree.size();
+}
+
+template<typename T, class A>
+inline bool PersistentVector<T, A>::empty() const noexcept
+{
+  return size() == 0;
+}
+
+template<typename T, class A>
+typename PersistentVector<T, A>::const_reference PersistentVector<T, A>::at(size_type i) const
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::PersistentVector: out of range");
+  }
+  return _tree[i];
+}
+
+template<typename T, class A>
+inline typename PersistentVector<T, A>::const_reference PersistentVector<T, A>::operator[](size_type i) const noexcept
+{
+  return _tree[i];
+}
+
+template<typename T, class A>
+typename PersistentVector<T, A>::const_reference PersistentVector<T, A>::front() const noexcept
+{
+  return _tree[0];
+}
+
+template<typename T, class A>
+typename PersistentVector<T, A>::const_reference PersistentVector<T, A>::back() const noexcept
+{
+  return _tree[size() - 1];
+}
+
+template<typename T, class A>
+PersistentVector<T, A> PersistentVector<T, A>::push_back(const T& value) const
+{
+  PersistentVector next(*this);
+  next._tree.push_back(value);
+  return next;
+}
+
+template<typename T, class A>
+PersistentVector<T, A> PersistentVector<T, A>::set(size_type i, const T& value) const
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::PersistentVector: out of range");
+  }
+  PersistentVector next(*this);
+  next._tree.set(i, value);
+  return next;
+}
+
+template<typename T, class A>
+PersistentVector<T, A> PersistentVector<T, A>::pop_back() const
+{
+  PersistentVector next(*this);
+  next._tree.pop_back();
+  return next;
+}
+
+template<typename T, class A>
+TransientVector<T, A> PersistentVector<T, A>::transient() const noexcept
+{
+  TransientVector<T, A> builder;
+  builder._tree = _tree;
+  return builder;
+}
+
+/**
+ * Copies the elements out a leaf at a time.
+ */
+template<typename T, class A>
+Vector<T, A> PersistentVector<T, A>::to_vector() const
+{
+  using tree_type = detail::RadixTree<T, A>;
+
+  Vector<T, A> result;
+  result.reserve(size());
+  for (size_type i = 0; i < size(); i += tree_type::width) {
+    const T* items = _tree.leaf(i);
+    const size_type count = std::min(tree_type::width, size() - i);
+    result.insert(result.end(), items, items + count);
+  }
+  return result;
+}
+
+template<typename T, class A>
+void PersistentVector<T, A>::swap(PersistentVector& other) noexcept
+{
+  _tree.swap(other._tree);
+}
+
+
+/**
+ * ctl::TransientVector Implementation
+ */
+
+template<typename T, class A>
+inline typename TransientVector<T, A>::size_type TransientVector<T, A>::size() const noexcept
+{
+  return _tree.size();
+}
+
+template<typename T, class A>
+inline bool TransientVector<T, A>::empty() const noexcept
+{
+  return size() == 0;
+}
+
+template<typename T, class A>
+typename TransientVector<T, A>::const_reference TransientVector<T, A>::at(size_type i) const
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::TransientVector: out of range");
+  }
+  return _tree[i];
+}
+
+template<typename T, class A>
+inline typename TransientVector<T, A>::const_reference TransientVector<T, A>::operator[](size_type i) const noexcept
+{
+  return _tree[i];
+}
+
+template<typename T, class A>
+void TransientVector<T, A>::push_back(const T& value)
+{
+  _tree.push_back(value);
+}
+
+template<typename T, class A>
+void TransientVector<T, A>::set(size_type i, const T& value)
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::TransientVector: out of range");
+  }
+  _tree.set(i, value);
+}
+
+template<typename T, class A>
+void TransientVector<T, A>::pop_back()
+{
+  _tree.pop_back();
+}
+
+/**
+ * Hands the contents over to a new version and leaves the builder empty.
+ */
+template<typename T, class A>
+PersistentVector<T, A> TransientVector<T, A>::persistent() noexcept
+{
+  PersistentVector<T, A> frozen;
+  frozen._tree.swap(_tree);
+  return frozen;
+}
+
+} // namespace ctl
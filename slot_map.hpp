@@ -0,0 +1,339 @@
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+
+#include "allocator.hpp"
+#include "vector.hpp"
+
+
+namespace ctl {
+
+/**
+ * ctl::SlotMap Definition
+ *
+ * Object pool addressed by generational keys. Values live densely in a
+ * ctl::Vector, so iteration is a plain array walk; a sparse slot array maps
+ * a key's index to the value's dense position, and erase fills the hole
+ * with the last value (swap-and-pop) and patches that value's slot. Every
+ * slot carries a generation that is bumped when its value is erased, so a
+ * key to an erased value never finds the value that later reuses the slot.
+ *
+ * insert, erase and lookup are O(1). Keys stay valid across any number of
+ * other inserts and erases; pointers and iterators into the dense storage
+ * do not.
+ */
+
+template<typename T, class A = Allocator<T>>
+class SlotMap
+{
+public:
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using reference = typename A::reference;
+  using const_reference = typename A::const_reference;
+  using pointer = typename A::pointer;
+  using const_pointer = typename A::const_pointer;
+  using iterator = typename Vector<T, A>::iterator;
+  using const_iterator = typename Vector<T, A>::const_iterator;
+
+  struct Key
+  {
+    std::uint32_t index;
+    std::uint32_t generation;
+
+    bool operator==(const Key& other) const noexcept { return index == other.index && generation == other.generation; }
+    bool operator!=(const Key& other) const noexcept { return !(*this == other); }
+  };
+
+  SlotMap() {};
+
+  iterator begin() noexcept;
+  iterator end() noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+  void reserve(size_type);
+
+  Key insert(const_reference);
+  Key insert(value_type&&);
+  template<class... Args>
+  Key emplace(Args&&...);
+  bool erase(Key);
+
+  bool contains(Key) const noexcept;
+  pointer find(Key) noexcept;
+  const_pointer find(Key) const noexcept;
+  reference at(Key);
+  const_reference at(Key) const;
+  reference operator[](Key) noexcept;
+  const_reference operator[](Key) const noexcept;
+  Key key_at(size_type) const noexcept;
+  pointer data() noexcept;
+
+  void swap(SlotMap&) noexcept;
+  void clear() noexcept;
+
+private:
+  struct Slot
+  {
+    std::uint32_t position;
+    std::uint32_t generation;
+  };
+
+  using slot_allocator = typename std::allocator_traits<A>::template rebind_alloc<Slot>;
+  using index_allocator = typename std::allocator_traits<A>::template rebind_alloc<std::uint32_t>;
+
+  static constexpr std::uint32_t _none = std::numeric_limits<std::uint32_t>::max();
+
+  Vector<T, A> _values;
+  Vector<std::uint32_t, index_allocator> _owners;
+  Vector<Slot, slot_allocator> _slots;
+  std::uint32_t _freeHead = _none;
+
+  Key claim();
+  void unclaim(Key) noexcept;
+};
+
+
+/**
+ * ctl::SlotMap Implementation
+ */
+
+template<typename T, class A>
+constexpr std::uint32_t SlotMap<T, A>::_none;
+
+template<typename T, class A>
+typename SlotMap<T, A>::iterator SlotMap<T, A>::begin() noexcept
+{
+  return _values.begin();
+}
+
+template<typename T, class A>
+typename SlotMap<T, A>::iterator SlotMap<T, A>::end() noexcept
+{
+  return _values.end();
+}
+
+template<typename T, class A>
+typename SlotMap<T, A>::const_iterator SlotMap<T, A>::cbegin() const noexcept
+{
+  return _values.cbegin();
+}
+
+template<typename T, class A>
+typename SlotMap<T, A>::const_iterator SlotMap<T, A>::cend() const noexcept
+{
+  return _values.cend();
+}
+
+template<typename T, class A>
+inline typename SlotMap<T, A>::size_type SlotMap<T, A>::size() const noexcept
+{
+  return _values.size();
+}
+
+template<typename T, class A>
+inline typename SlotMap<T, A>::size_type SlotMap<T, A>::capacity() const noexcept
+{
+  return _values.capacity();
+}
+
+template<typename T, class A>
+inline bool SlotMap<T, A>::empty() const noexcept
+{
+  return _values.empty();
+}
+
+template<typename T, class A>
+void SlotMap<T, A>::reserve(size_type newCapacity)
+{
+  _values.reserve(newCapacity);
+  _owners.reserve(newCapacity);
+  _slots.reserve(newCapacity);
+}
+
+template<typename T, class A>
+typename SlotMap<T, A>::Key SlotMap<T, A>::insert(const_reference value)
+{
+  return emplace(value);
+}
+
+template<typename T, class A>
+typename SlotMap<T, A>::Key SlotMap<T, A>::insert(value_type&& value)
+{
+  return emplace(std::move(value));
+}
+
+template<typename T, class A>
+template<class... Args>
+typename SlotMap<T, A>::Key SlotMap<T, A>::emplace(Args&&... args)
+{
+  _values.emplace_back(std::forward<Args>(args)...);
+  try {
+    return claim();
+  } catch (...) {
+    _values.pop_back();
+    throw;
+  }
+}
+
+/**
+ * Erases the value behind key and returns true, or returns false if the key
+ * is stale or was never issued by this map.
+ */
+template<typename T, class A>
+bool SlotMap<T, A>::erase(Key key)
+{
+  if (!contains(key)) return false;
+
+  const std::uint32_t position = _slots[key.index].position;
+  _values.erase_unordered(_values.begin() + position);
+  _owners.erase_unordered(_owners.begin() + position);
+  if (position < _owners.size()) {
+    _slots[_owners[position]].position = position;
+  }
+  unclaim(key);
+  return true;
+}
+
+/**
+ * A matching generation alone is not enough: a free slot's generation was
+ * already bumped, so a forged key or one from another map can match it. The
+ * slot must also point at a dense position that it owns; a free slot's
+ * position is a free-list link, and _owners only names live slots.
+ */
+template<typename T, class A>
+bool SlotMap<T, A>::contains(Key key) const noexcept
+{
+  if (key.index >= _slots.size()) return false;
+  const Slot& slot = _slots[key.index];
+  return slot.generation == key.generation && slot.position < _owners.size() && _owners[slot.position] == key.index;
+}
+
+template<typename T, class A>
+typename SlotMap<T, A>::pointer SlotMap<T, A>::find(Key key) noexcept
+{
+  return contains(key) ? &(*this)[key] : nullptr;
+}
+
+template<typename T, class A>
+typename SlotMap<T, A>::const_pointer SlotMap<T, A>::find(Key key) const noexcept
+{
+  return contains(key) ? &(*this)[key] : nullptr;
+}
+
+template<typename T, class A>
+typename SlotMap<T, A>::reference SlotMap<T, A>::at(Key key)
+{
+  if (!contains(key)) {
+    throw std::out_of_range("ctl::SlotMap: stale or invalid key");
+  }
+  return (*this)[key];
+}
+
+template<typename T, class A>
+typename SlotMap<T, A>::const_reference SlotMap<T, A>::at(Key key) const
+{
+  if (!contains(key)) {
+    throw std::out_of_range("ctl::SlotMap: stale or invalid key");
+  }
+  return (*this)[key];
+}
+
+template<typename T, class A>
+inline typename SlotMap<T, A>::reference SlotMap<T, A>::operator[](Key key) noexcept
+{
+  return _values[_slots[key.index].position];
+}
+
+template<typename T, class A>
+inline typename SlotMap<T, A>::const_reference SlotMap<T, A>::operator[](Key key) const noexcept
+{
+  return _values[_slots[key.index].position];
+}
+
+/**
+ * Key of the value at dense position i, e.g. while iterating.
+ */
+template<typename T, class A>
+typename SlotMap<T, A>::Key SlotMap<T, A>::key_at(size_type i) const noexcept
+{
+  const std::uint32_t index = _owners[i];
+  return Key{ index, _slots[index].generation };
+}
+
+template<typename T, class A>
+typename SlotMap<T, A>::pointer SlotMap<T, A>::data() noexcept
+{
+  return _values.data();
+}
+
+template<typename T, class A>
+void SlotMap<T, A>::swap(SlotMap& other) noexcept
+{
+  _values.swap(other._values);
+  _owners.swap(other._owners);
+  _slots.swap(other._slots);
+  std::swap(_freeHead, other._freeHead);
+}
+
+/**
+ * Erases every value; all keys issued so far become stale.
+ */
+template<typename T, class A>
+void SlotMap<T, A>::clear() noexcept
+{
+  for (size_type i = _owners.size(); i-- > 0;) {
+    unclaim(key_at(i));
+  }
+  _values.clear();
+  _owners.clear();
+}
+
+/**
+ * Gives the value just appended to _values a slot, reusing a free one if
+ * there is any.
+ */
+template<typename T, class A>
+typename SlotMap<T, A>::Key SlotMap<T, A>::claim()
+{
+  const std::uint32_t position = static_cast<std::uint32_t>(_values.size() - 1);
+  std::uint32_t index = _freeHead;
+  if (index == _none) {
+    if (_slots.size() >= _none) {
+      throw std::length_error("ctl::SlotMap: too many slots");
+    }
+    index = static_cast<std::uint32_t>(_slots.size());
+    _owners.push_back(index);
+    try {
+      _slots.push_back(Slot{ position, 0 });
+    } catch (...) {
+      _owners.pop_back();
+      throw;
+    }
+  } else {
+    _owners.push_back(index);
+    _freeHead = _slots[index].position;
+    _slots[index].position = position;
+  }
+  return Key{ index, _slots[index].generation };
+}
+
+template<typename T, class A>
+void SlotMap<T, A>::unclaim(Key key) noexcept
+{
+  Slot& slot = _slots[key.index];
+  ++slot.generation;
+  slot.position = _freeHead;
+  _freeHead = key.index;
+}
+
+} // namespace ctl
@@ -0,0 +1,595 @@
+#pragma once
+
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <initializer_list>
+
+#include "allocator.hpp"
+#include "iterator.hpp"
+#include "parallel_copy.hpp"
+
+
+namespace ctl {
+
+/**
+ * ctl::SoaReference Definition
+ *
+ * Proxy for one record of a SoaVector: a tuple of references into each
+ * field array. Assigning to it writes through to the arrays; converting it
+ * to the value type copies the record out.
+ */
+
+template<typename... Ts>
+class SoaReference
+{
+public:
+  using value_type = std::tuple<typename std::remove_const<Ts>::type...>;
+
+  SoaReference(Ts&... fields) : _fields(fields...) {}
+  SoaReference(const SoaReference&) = default;
+
+  template<std::size_t I>
+  typename std::tuple_element<I, std::tuple<Ts...>>::type& get() const noexcept;
+
+  operator value_type() const;
+
+  SoaReference& operator=(const SoaReference&);
+  SoaReference& operator=(const value_type&);
+  SoaReference& operator=(value_type&&);
+
+  bool operator==(const value_type&) const;
+  bool operator!=(const value_type&) const;
+
+private:
+  std::tuple<Ts&...> _fields;
+};
+
+
+/**
+ * ctl::SoaVector Definition
+ *
+ * Struct-of-arrays vector: a record {f0, f1, ...} is stored as one element
+ * in each of sizeof...(Ts) contiguous arrays that grow together, so a scan
+ * over one field streams through that field only. Every array is obtained
+ * from ctl::Allocator for its field type. data<I>() exposes field I as a
+ * plain array for vectorised loops; operator[] and the iterators hand out
+ * SoaReference proxies for whole-record access.
+ *
+ * Reallocation keeps the strong guarantee: fields whose move constructor
+ * may throw are copied first, and the rest are only moved once nothing else
+ * can fail.
+ */
+
+template<typename... Ts>
+class SoaVector
+{
+  static_assert(sizeof...(Ts) > 0, "ctl::SoaVector: at least one field is required");
+
+public:
+  using value_type = std::tuple<Ts...>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = SoaReference<Ts...>;
+  using const_reference = SoaReference<const Ts...>;
+  using iterator = ctl::IndexIterator<SoaVector, value_type, reference>;
+  using const_iterator = ctl::IndexIterator<const SoaVector, const value_type, const_reference>;
+
+  template<std::size_t I>
+  using field_type = typename std::tuple_element<I, value_type>::type;
+
+  static constexpr size_type field_count = sizeof...(Ts);
+
+  SoaVector() {};
+  SoaVector(const SoaVector&);
+  SoaVector(SoaVector&&);
+  SoaVector(size_type);
+  SoaVector(std::initializer_list<value_type>);
+
+  ~SoaVector();
+
+  SoaVector& operator=(const SoaVector&);
+  SoaVector& operator=(SoaVector&&);
+
+  iterator begin() noexcept;
+  iterator end() noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+  void reserve(size_type);
+  void shrink_to_fit();
+  void resize(size_type);
+
+  reference at(size_type);
+  const_reference at(size_type) const;
+  reference operator[](size_type) noexcept;
+  const_reference operator[](size_type) const noexcept;
+  reference front();
+  reference back();
+
+  template<std::size_t I>
+  field_type<I>* data() noexcept;
+  template<std::size_t I>
+  const field_type<I>* data() const noexcept;
+
+  void push_back(const Ts&...);
+  void push_back(const value_type&);
+  void pop_back();
+
+  iterator insert(iterator, const Ts&...);
+  iterator insert(iterator, const value_type&);
+  iterator erase(iterator);
+  iterator erase(iterator, iterator);
+
+  void swap(SoaVector&) noexcept;
+  void clear() noexcept;
+
+private:
+  static constexpr float _growthFactor = 1.5f;
+
+  std::tuple<Allocator<Ts>...> _allocators;
+  std::tuple<Ts*...> _arrays;
+  size_type _size = 0;
+  size_type _capacity = 0;
+
+  template<typename F, std::size_t... I>
+  static void for_each_field(F&&, std::index_sequence<I...>);
+  template<typename F>
+  static void for_each_field(F&&);
+
+  template<typename R, std::size_t... I>
+  R record(size_type, std::index_sequence<I...>) const noexcept;
+
+  template<typename Tuple>
+  void construct(size_type, Tuple&&);
+  void relocate(size_type);
+  void destroy(size_type, size_type) noexcept;
+};
+
+
+/**
+ * ctl::SoaReference Implementation
+ */
+
+template<typename... Ts>
+template<std::size_t I>
+typename std::tuple_element<I, std::tuple<Ts...>>::type& SoaReference<Ts...>::get() const noexcept
+{
+  return std::get<I>(_fields);
+}
+
+template<typename... Ts>
+SoaReference<Ts...>::operator value_type() const
+{
+  return value_type(_fields);
+}
+
+template<typename... Ts>
+SoaReference<Ts...>& SoaReference<Ts...>::operator=(const SoaReference& other)
+{
+  _fields = other._fields;
+  return *this;
+}
+
+template<typename... Ts>
+SoaReference<Ts...>& SoaReference<Ts...>::operator=(const value_type& value)
+{
+  _fields = value;
+  return *this;
+}
+
+template<typename... Ts>
+SoaReference<Ts...>& SoaReference<Ts...>::operator=(value_type&& value)
+{
+  _fields = std::move(value);
+  return *this;
+}
+
+template<typename... Ts>
+bool SoaReference<Ts...>::operator==(const value_type& value) const
+{
+  return _fields == value;
+}
+
+template<typename... Ts>
+bool SoaReference<Ts...>::operator!=(const value_type& value) const
+{
+  return !(*this == value);
+}
+
+
+/**
+ * ctl::SoaVector Implementation
+ */
+
+template<typename... Ts>
+SoaVector<Ts...>::SoaVector(const SoaVector& other)
+{
+  reserve(other.size());
+  for (size_type i = 0; i < other.size(); ++i) {
+    push_back(other[i]);
+  }
+}
+
+template<typename... Ts>
+SoaVector<Ts...>::SoaVector(SoaVector&& other)
+{
+  swap(other);
+}
+
+template<typename... Ts>
+SoaVector<Ts...>::SoaVector(size_type count)
+{
+  resize(count);
+}
+
+template<typename... Ts>
+SoaVector<Ts...>::SoaVector(std::initializer_list<value_type> list)
+{
+  reserve(list.size());
+  for (const value_type& value : list) {
+    push_back(value);
+  }
+}
+
+template<typename... Ts>
+SoaVector<Ts...>::~SoaVector()
+{
+  destroy(0, _size);
+  for_each_field([this](auto field) {
+    std::get<field>(_allocators).deallocate(std::get<field>(_arrays), _capacity);
+  });
+}
+
+template<typename... Ts>
+SoaVector<Ts...>& SoaVector<Ts...>::operator=(const SoaVector& other)
+{
+  if (this == &other) return *this;
+  SoaVector copy(other);
+  swap(copy);
+  return *this;
+}
+
+template<typename... Ts>
+SoaVector<Ts...>& SoaVector<Ts...>::operator=(SoaVector&& other)
+{
+  if (this == &other) return *this;
+  SoaVector moved(std::move(other));
+  swap(moved);
+  return *this;
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::iterator SoaVector<Ts...>::begin() noexcept
+{
+  return iterator(this, 0);
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::iterator SoaVector<Ts...>::end() noexcept
+{
+  return iterator(this, _size);
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::const_iterator SoaVector<Ts...>::cbegin() const noexcept
+{
+  return const_iterator(this, 0);
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::const_iterator SoaVector<Ts...>::cend() const noexcept
+{
+  return const_iterator(this, _size);
+}
+
+template<typename... Ts>
+inline typename SoaVector<Ts...>::size_type SoaVector<Ts...>::size() const noexcept
+{
+  return _size;
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::size_type SoaVector<Ts...>::max_size() const noexcept
+{
+  return static_cast<size_type>(-1) / std::max({ sizeof(Ts)... });
+}
+
+template<typename... Ts>
+inline typename SoaVector<Ts...>::size_type SoaVector<Ts...>::capacity() const noexcept
+{
+  return _capacity;
+}
+
+template<typename... Ts>
+inline bool SoaVector<Ts...>::empty() const noexcept
+{
+  return _size == 0;
+}
+
+template<typename... Ts>
+void SoaVector<Ts...>::reserve(size_type newCapacity)
+{
+  if (newCapacity > max_size()) {
+    throw std::length_error("ctl::SoaVector: too big capacity to reserve");
+  }
+  if (newCapacity > _capacity) {
+    relocate(newCapacity);
+  }
+}
+
+template<typename... Ts>
+void SoaVector<Ts...>::shrink_to_fit()
+{
+  if (_size != _capacity) {
+    relocate(_size);
+  }
+}
+
+template<typename... Ts>
+void SoaVector<Ts...>::resize(size_type newSize)
+{
+  if (newSize < _size) {
+    destroy(newSize, _size);
+    _size = newSize;
+    return;
+  }
+  reserve(newSize);
+  while (_size < newSize) {
+    construct(_size, value_type());
+    ++_size;
+  }
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::reference SoaVector<Ts...>::at(size_type i)
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::SoaVector: out of range");
+  }
+  return (*this)[i];
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::const_reference SoaVector<Ts...>::at(size_type i) const
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::SoaVector: out of range");
+  }
+  return (*this)[i];
+}
+
+template<typename... Ts>
+inline typename SoaVector<Ts...>::reference SoaVector<Ts...>::operator[](size_type i) noexcept
+{
+  return record<reference>(i, std::index_sequence_for<Ts...>());
+}
+
+template<typename... Ts>
+inline typename SoaVector<Ts...>::const_reference SoaVector<Ts...>::operator[](size_type i) const noexcept
+{
+  return record<const_reference>(i, std::index_sequence_for<Ts...>());
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::reference SoaVector<Ts...>::front()
+{
+  return (*this)[0];
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::reference SoaVector<Ts...>::back()
+{
+  return (*this)[_size - 1];
+}
+
+template<typename... Ts>
+template<std::size_t I>
+inline typename SoaVector<Ts...>::template field_type<I>* SoaVector<Ts...>::data() noexcept
+{
+  return std::get<I>(_arrays);
+}
+
+template<typename... Ts>
+template<std::size_t I>
+inline const typename SoaVector<Ts...>::template field_type<I>* SoaVector<Ts...>::data() const noexcept
+{
+  return std::get<I>(_arrays);
+}
+
+template<typename... Ts>
+void SoaVector<Ts...>::push_back(const Ts&... values)
+{
+  push_back(value_type(values...));
+}
+
+template<typename... Ts>
+void SoaVector<Ts...>::push_back(const value_type& value)
+{
+  if (_size == _capacity) {
+    value_type copy(value);
+    relocate(std::max<size_type>(_capacity * _growthFactor, _capacity + 1));
+    construct(_size, std::move(copy));
+  } else {
+    construct(_size, value);
+  }
+  ++_size;
+}
+
+template<typename... Ts>
+void SoaVector<Ts...>::pop_back()
+{
+  destroy(_size - 1, _size);
+  --_size;
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::iterator SoaVector<Ts...>::insert(iterator it, const Ts&... values)
+{
+  return insert(it, value_type(values...));
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::iterator SoaVector<Ts...>::insert(iterator it, const value_type& value)
+{
+  const size_type index = it.index();
+  if (index == _size) {
+    push_back(value);
+    return iterator(this, index);
+  }
+
+  value_type copy(value);
+  if (_size == _capacity) {
+    relocate(std::max<size_type>(_capacity * _growthFactor, _capacity + 1));
+  }
+  for_each_field([this, index, &copy](auto field) {
+    auto* array = std::get<field>(_arrays);
+    std::get<field>(_allocators).construct(array + _size, std::move(array[_size - 1]));
+    std::move_backward(array + index, array + _size - 1, array + _size);
+    array[index] = std::move(std::get<field>(copy));
+  });
+  ++_size;
+  return iterator(this, index);
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::iterator SoaVector<Ts...>::erase(iterator it)
+{
+  return erase(it, it + 1);
+}
+
+template<typename... Ts>
+typename SoaVector<Ts...>::iterator SoaVector<Ts...>::erase(iterator first, iterator last)
+{
+  const size_type from = first.index();
+  const size_type to = last.index();
+  if (from == to) return first;
+
+  for_each_field([this, from, to](auto field) {
+    auto* array = std::get<field>(_arrays);
+    std::move(array + to, array + _size, array + from);
+  });
+  destroy(_size - (to - from), _size);
+  _size -= to - from;
+  return iterator(this, from);
+}
+
+template<typename... Ts>
+void SoaVector<Ts...>::swap(SoaVector& other) noexcept
+{
+  std::swap(_arrays, other._arrays);
+  std::swap(_size, other._size);
+  std::swap(_capacity, other._capacity);
+}
+
+template<typename... Ts>
+void SoaVector<Ts...>::clear() noexcept
+{
+  destroy(0, _size);
+  _size = 0;
+}
+
+template<typename... Ts>
+template<typename F, std::size_t... I>
+void SoaVector<Ts...>::for_each_field(F&& f, std::index_sequence<I...>)
+{
+  int expand[] = { 0, (f(std::integral_constant<std::size_t, I>()), 0)... };
+  (void)expand;
+}
+
+template<typename... Ts>
+template<typename F>
+void SoaVector<Ts...>::for_each_field(F&& f)
+{
+  for_each_field(std::forward<F>(f), std::index_sequence_for<Ts...>());
+}
+
+template<typename... Ts>
+template<typename R, std::size_t... I>
+inline R SoaVector<Ts...>::record(size_type i, std::index_sequence<I...>) const noexcept
+{
+  return R(std::get<I>(_arrays)[i]...);
+}
+
+/**
+ * Constructs record i field by field; if one field throws, the fields
+ * already constructed for that record are destroyed again.
+ */
+template<typename... Ts>
+template<typename Tuple>
+void SoaVector<Ts...>::construct(size_type i, Tuple&& value)
+{
+  size_type constructed = 0;
+  try {
+    for_each_field([this, i, &value, &constructed](auto field) {
+      std::get<field>(_allocators).construct(std::get<field>(_arrays) + i, std::get<field>(std::forward<Tuple>(value)));
+      ++constructed;
+    });
+  } catch (...) {
+    for_each_field([this, i, constructed](auto field) {
+      if (field < constructed) std::get<field>(_allocators).destroy(std::get<field>(_arrays) + i);
+    });
+    throw;
+  }
+}
+
+template<typename... Ts>
+void SoaVector<Ts...>::relocate(size_type newCapacity)
+{
+  const size_type count = std::min(_size, newCapacity);
+  std::tuple<Ts*...> fresh;
+  bool allocated[sizeof...(Ts)] = {};
+  bool transferred[sizeof...(Ts)] = {};
+
+  auto transfer = [this, count, &fresh, &transferred](auto field, bool mayThrow) {
+    using F = field_type<decltype(field)::value>;
+    if (std::is_nothrow_move_constructible<F>::value == mayThrow) return;
+    detail::uninitialized_move_n(std::get<field>(_allocators), std::get<field>(_arrays), count, std::get<field>(fresh));
+    transferred[field] = true;
+  };
+
+  try {
+    for_each_field([this, newCapacity, &fresh, &allocated](auto field) {
+      std::get<field>(fresh) = newCapacity ? std::get<field>(_allocators).allocate(newCapacity) : nullptr;
+      allocated[field] = true;
+    });
+    for_each_field([&transfer](auto field) { transfer(field, true); });
+  } catch (...) {
+    for_each_field([this, count, newCapacity, &fresh, &allocated, &transferred](auto field) {
+      auto& allocator = std::get<field>(_allocators);
+      if (transferred[field]) {
+        for (size_type i = 0; i < count; ++i) allocator.destroy(std::get<field>(fresh) + i);
+      }
+      if (allocated[field]) allocator.deallocate(std::get<field>(fresh), newCapacity);
+    });
+    throw;
+  }
+  for_each_field([&transfer](auto field) { transfer(field, false); });
+
+  destroy(0, _size);
+  for_each_field([this](auto field) {
+    std::get<field>(_allocators).deallocate(std::get<field>(_arrays), _capacity);
+  });
+  _arrays = fresh;
+  _size = count;
+  _capacity = newCapacity;
+}
+
+template<typename... Ts>
+void SoaVector<Ts...>::destroy(size_type first, size_type last) noexcept
+{
+  for_each_field([this, first, last](auto field) {
+    auto& allocator = std::get<field>(_allocators);
+    for (size_type i = first; i < last; ++i) {
+      allocator.destroy(std::get<field>(_arrays) + i);
+    }
+  });
+}
+
+} // namespace ctl
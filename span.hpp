@@ -0,0 +1,508 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+#include "iterator.hpp"
+
+
+namespace ctl {
+
+template<typename T>
+class Span;
+
+template<typename T>
+class StridedSpan;
+
+template<typename T>
+class ChunkedSpan;
+
+namespace detail {
+
+template<typename C>
+struct is_span : std::false_type {};
+
+template<typename T>
+struct is_span< Span<T> > : std::true_type {};
+
+template<typename C, typename T, class = void>
+struct is_span_source : std::false_type {};
+
+/**
+ * C can be viewed as a Span<T> if data() yields something convertible to
+ * T* (so Span<const T> accepts const containers and Span<T> does not) and
+ * the container has a size().
+ */
+template<typename C, typename T>
+struct is_span_source<C, T, decltype(void(std::declval<C&>().data()), void(std::declval<C&>().size()))>
+  : std::is_convertible<decltype(std::declval<C&>().data()), T*> {};
+
+} // namespace detail
+
+/**
+ * ctl::Span Definition
+ *
+ * Non-owning view of a contiguous run of T: a pointer and a length. It
+ * converts implicitly from ctl::Vector, std::vector, built-in arrays and
+ * anything else with data() and size(), so a function taking a Span<const T>
+ * (alias VectorView<T>) accepts all of them, and slicing with first(), last()
+ * and subspan() never allocates or copies. strided() and chunks() give views
+ * over every n-th element and over consecutive batches of n elements.
+ *
+ * A Span is only valid as long as the storage it views: any operation that
+ * reallocates the viewed container leaves it dangling.
+ */
+
+template<typename T>
+class Span
+{
+public:
+  using element_type = T;
+  using value_type = typename std::remove_const<T>::type;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+  using iterator = ctl::Iterator<T>;
+
+  static constexpr size_type npos = static_cast<size_type>(-1);
+
+  Span() noexcept {};
+  Span(pointer, size_type) noexcept;
+  template<typename P, class = typename std::enable_if< std::is_convertible<P, pointer>::value && !std::is_integral<P>::value >::type>
+  Span(pointer, P) noexcept;
+  template<std::size_t N>
+  Span(element_type (&)[N]) noexcept;
+  template<typename C, class = typename std::enable_if< !detail::is_span<typename std::remove_const<C>::type>::value && detail::is_span_source<C, T>::value >::type>
+  Span(C&) noexcept;
+  template<typename U, class = typename std::enable_if< std::is_convertible<U*, T*>::value >::type>
+  Span(const Span<U>&) noexcept;
+
+  iterator begin() const noexcept;
+  iterator end() const noexcept;
+
+  size_type size() const noexcept;
+  size_type size_bytes() const noexcept;
+  bool empty() const noexcept;
+
+  reference at(size_type) const;
+  reference operator[](size_type) const noexcept;
+  reference front() const;
+  reference back() const;
+  pointer data() const noexcept;
+
+  Span first(size_type) const;
+  Span last(size_type) const;
+  Span subspan(size_type, size_type = npos) const;
+  StridedSpan<T> strided(size_type, size_type = 0) const;
+  ChunkedSpan<T> chunks(size_type) const;
+
+private:
+  pointer _data = nullptr;
+  size_type _size = 0;
+};
+
+template<typename T>
+using VectorView = Span<const T>;
+
+
+namespace detail {
+
+/**
+ * Random-access iterator over a non-contiguous view of contiguous storage.
+ * It carries the data pointer, an index and the view's Step, which maps an
+ * index to an element, rather than a pointer to the view: strided() and
+ * chunks() return views by value, and iterators taken from a temporary view
+ * must neither dangle nor differ from those of an equal view.
+ */
+template<typename T, typename Step>
+class ViewIterator
+{
+public:
+  using difference_type = std::ptrdiff_t;
+  using reference = decltype(std::declval<const Step&>()(std::declval<T*>(), std::size_t()));
+  using value_type = typename std::remove_cv<typename std::remove_reference<reference>::type>::type;
+  using pointer = typename std::conditional<std::is_reference<reference>::value, typename std::remove_reference<reference>::type*, void>::type;
+  using iterator_category = std::random_access_iterator_tag;
+
+  ViewIterator() noexcept : data(nullptr), i(0), step() {}
+  ViewIterator(T* data, std::size_t i, Step step) noexcept : data(data), i(i), step(step) {}
+
+  ViewIterator& operator++() noexcept { ++i; return *this; }
+  ViewIterator& operator--() noexcept { --i; return *this; }
+  ViewIterator operator++(int) noexcept { ViewIterator foo(*this); ++i; return foo; }
+  ViewIterator operator--(int) noexcept { ViewIterator foo(*this); --i; return foo; }
+  ViewIterator& operator+=(difference_type n) noexcept { i += n; return *this; }
+  ViewIterator& operator-=(difference_type n) noexcept { i -= n; return *this; }
+  ViewIterator operator+(difference_type n) const noexcept { return ViewIterator(data, i + n, step); }
+  ViewIterator operator-(difference_type n) const noexcept { return ViewIterator(data, i - n, step); }
+  difference_type operator-(const ViewIterator& other) const noexcept { return static_cast<difference_type>(i) - static_cast<difference_type>(other.i); }
+
+  reference operator[](difference_type n) const { return step(data, i + n); }
+  reference operator*() const { return step(data, i); }
+  pointer operator->() const { return &step(data, i); }
+
+  bool operator==(const ViewIterator& other) const noexcept { return i == other.i && data == other.data; }
+  bool operator!=(const ViewIterator& other) const noexcept { return !(*this == other); }
+  bool operator<=(const ViewIterator& other) const noexcept { return i <= other.i; }
+  bool operator>=(const ViewIterator& other) const noexcept { return i >= other.i; }
+  bool operator<(const ViewIterator& other) const noexcept { return i < other.i; }
+  bool operator>(const ViewIterator& other) const noexcept { return i > other.i; }
+
+private:
+  T* data;
+  std::size_t i;
+  Step step;
+};
+
+struct StrideStep
+{
+  std::size_t stride;
+
+  template<typename T>
+  T& operator()(T* data, std::size_t i) const noexcept { return data[i * stride]; }
+};
+
+template<typename T>
+struct ChunkStep
+{
+  std::size_t chunkSize;
+  std::size_t size;
+
+  Span<T> operator()(T* data, std::size_t i) const noexcept
+  {
+    const std::size_t offset = i * chunkSize;
+    const std::size_t remaining = size - offset;
+    return Span<T>(data + offset, remaining < chunkSize ? remaining : chunkSize);
+  }
+};
+
+} // namespace detail
+
+
+/**
+ * ctl::StridedSpan Definition
+ *
+ * View of every stride-th element of a contiguous run, e.g. one column of a
+ * row-major matrix or one channel of interleaved samples.
+ */
+
+template<typename T>
+class StridedSpan
+{
+public:
+  using element_type = T;
+  using value_type = typename std::remove_const<T>::type;
+  using size_type = std::size_t;
+  using pointer = T*;
+  using reference = T&;
+  using iterator = detail::ViewIterator<T, detail::StrideStep>;
+
+  StridedSpan() noexcept {};
+  StridedSpan(pointer, size_type, size_type) noexcept;
+
+  iterator begin() const noexcept;
+  iterator end() const noexcept;
+
+  size_type size() const noexcept;
+  size_type stride() const noexcept;
+  bool empty() const noexcept;
+
+  reference at(size_type) const;
+  reference operator[](size_type) const noexcept;
+
+private:
+  pointer _data = nullptr;
+  size_type _size = 0;
+  size_type _stride = 1;
+};
+
+
+/**
+ * ctl::ChunkedSpan Definition
+ *
+ * View of a contiguous run as consecutive Spans of chunk_size elements; the
+ * last one is shorter when the length is not a multiple of it.
+ */
+
+template<typename T>
+class ChunkedSpan
+{
+public:
+  using value_type = Span<T>;
+  using size_type = std::size_t;
+  using iterator = detail::ViewIterator<T, detail::ChunkStep<T>>;
+
+  ChunkedSpan() noexcept {};
+  ChunkedSpan(Span<T>, size_type) noexcept;
+
+  iterator begin() const noexcept;
+  iterator end() const noexcept;
+
+  size_type size() const noexcept;
+  size_type chunk_size() const noexcept;
+  bool empty() const noexcept;
+
+  Span<T> at(size_type) const;
+  Span<T> operator[](size_type) const noexcept;
+
+private:
+  Span<T> _span;
+  size_type _chunkSize = 1;
+};
+
+
+/**
+ * ctl::Span Implementation
+ */
+
+template<typename T>
+constexpr typename Span<T>::size_type Span<T>::npos;
+
+template<typename T>
+Span<T>::Span(pointer data, size_type size) noexcept : _data(data), _size(size) {}
+
+template<typename T>
+template<typename P, typename isPointer>
+Span<T>::Span(pointer first, P last) noexcept : _data(first), _size(static_cast<pointer>(last) - first) {}
+
+template<typename T>
+template<std::size_t N>
+Span<T>::Span(element_type (&array)[N]) noexcept : _data(array), _size(N) {}
+
+template<typename T>
+template<typename C, typename isSource>
+Span<T>::Span(C& container) noexcept : _data(container.data()), _size(container.size()) {}
+
+template<typename T>
+template<typename U, typename isConvertible>
+Span<T>::Span(const Span<U>& other) noexcept : _data(other.data()), _size(other.size()) {}
+
+template<typename T>
+typename Span<T>::iterator Span<T>::begin() const noexcept
+{
+  return iterator(_data);
+}
+
+template<typename T>
+typename Span<T>::iterator Span<T>::end() const noexcept
+{
+  return iterator(_data + _size);
+}
+
+template<typename T>
+inline typename Span<T>::size_type Span<T>::size() const noexcept
+{
+  return _size;
+}
+
+template<typename T>
+inline typename Span<T>::size_type Span<T>::size_bytes() const noexcept
+{
+  return _size * sizeof(T);
+}
+
+template<typename T>
+inline bool Span<T>::empty() const noexcept
+{
+  return _size == 0;
+}
+
+template<typename T>
+typename Span<T>::reference Span<T>::at(size_type i) const
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::Span: out of range");
+  }
+  return _data[i];
+}
+
+template<typename T>
+inline typename Span<T>::reference Span<T>::operator[](size_type i) const noexcept
+{
+  return _data[i];
+}
+
+template<typename T>
+typename Span<T>::reference Span<T>::front() const
+{
+  return _data[0];
+}
+
+template<typename T>
+typename Span<T>::reference Span<T>::back() const
+{
+  return _data[_size - 1];
+}
+
+template<typename T>
+inline typename Span<T>::pointer Span<T>::data() const noexcept
+{
+  return _data;
+}
+
+template<typename T>
+Span<T> Span<T>::first(size_type count) const
+{
+  if (count > _size) {
+    throw std::out_of_range("ctl::Span: first() past the end");
+  }
+  return Span(_data, count);
+}
+
+template<typename T>
+Span<T> Span<T>::last(size_type count) const
+{
+  if (count > _size) {
+    throw std::out_of_range("ctl::Span: last() past the end");
+  }
+  return Span(_data + _size - count, count);
+}
+
+/**
+ * View of count elements starting at offset, or of everything from offset
+ * on if count is npos.
+ */
+template<typename T>
+Span<T> Span<T>::subspan(size_type offset, size_type count) const
+{
+  if (offset > _size || (count != npos && count > _size - offset)) {
+    throw std::out_of_range("ctl::Span: subspan() past the end");
+  }
+  return Span(_data + offset, count == npos ? _size - offset : count);
+}
+
+/**
+ * View of the elements at offset, offset + stride, offset + 2 * stride, ...
+ */
+template<typename T>
+StridedSpan<T> Span<T>::strided(size_type stride, size_type offset) const
+{
+  if (stride == 0) {
+    throw std::invalid_argument("ctl::Span: stride must be positive");
+  }
+  if (offset >= _size) {
+    return StridedSpan<T>(_data, 0, stride);
+  }
+  return StridedSpan<T>(_data + offset, (_size - offset + stride - 1) / stride, stride);
+}
+
+template<typename T>
+ChunkedSpan<T> Span<T>::chunks(size_type chunkSize) const
+{
+  if (chunkSize == 0) {
+    throw std::invalid_argument("ctl::Span: chunk size must be positive");
+  }
+  return ChunkedSpan<T>(*this, chunkSize);
+}
+
+
+/**
+ * ctl::StridedSpan Implementation
+ */
+
+template<typename T>
+StridedSpan<T>::StridedSpan(pointer data, size_type size, size_type stride) noexcept : _data(data), _size(size), _stride(stride) {}
+
+template<typename T>
+typename StridedSpan<T>::iterator StridedSpan<T>::begin() const noexcept
+{
+  return iterator(_data, 0, detail::StrideStep{ _stride });
+}
+
+template<typename T>
+typename StridedSpan<T>::iterator StridedSpan<T>::end() const noexcept
+{
+  return iterator(_data, _size, detail::StrideStep{ _stride });
+}
+
+template<typename T>
+inline typename StridedSpan<T>::size_type StridedSpan<T>::size() const noexcept
+{
+  return _size;
+}
+
+template<typename T>
+inline typename StridedSpan<T>::size_type StridedSpan<T>::stride() const noexcept
+{
+  return _stride;
+}
+
+template<typename T>
+inline bool StridedSpan<T>::empty() const noexcept
+{
+  return _size == 0;
+}
+
+template<typename T>
+typename StridedSpan<T>::reference StridedSpan<T>::at(size_type i) const
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::StridedSpan: out of range");
+  }
+  return _data[i * _stride];
+}
+
+template<typename T>
+inline typename StridedSpan<T>::reference StridedSpan<T>::operator[](size_type i) const noexcept
+{
+  return _data[i * _stride];
+}
+
+
+/**
+ * ctl::ChunkedSpan Implementation
+ */
+
+template<typename T>
+ChunkedSpan<T>::ChunkedSpan(Span<T> span, size_type chunkSize) noexcept : _span(span), _chunkSize(chunkSize) {}
+
+template<typename T>
+typename ChunkedSpan<T>::iterator ChunkedSpan<T>::begin() const noexcept
+{
+  return iterator(_span.data(), 0, detail::ChunkStep<T>{ _chunkSize, _span.size() });
+}
+
+template<typename T>
+typename ChunkedSpan<T>::iterator ChunkedSpan<T>::end() const noexcept
+{
+  return iterator(_span.data(), size(), detail::ChunkStep<T>{ _chunkSize, _span.size() });
+}
+
+template<typename T>
+inline typename ChunkedSpan<T>::size_type ChunkedSpan<T>::size() const noexcept
+{
+  return (_span.size() + _chunkSize - 1) / _chunkSize;
+}
+
+template<typename T>
+inline typename ChunkedSpan<T>::size_type ChunkedSpan<T>::chunk_size() const noexcept
+{
+  return _chunkSize;
+}
+
+template<typename T>
+inline bool ChunkedSpan<T>::empty() const noexcept
+{
+  return _span.empty();
+}
+
+template<typename T>
+Span<T> ChunkedSpan<T>::at(size_type i) const
+{
+  if (i >= size()) {
+    throw std::out_of_range("ctl::ChunkedSpan: out of range");
+  }
+  return (*this)[i];
+}
+
+template<typename T>
+Span<T> ChunkedSpan<T>::operator[](size_type i) const noexcept
+{
+  return detail::ChunkStep<T>{ _chunkSize, _span.size() }(_span.data(), i);
+}
+
+} // namespace ctl
@@ -0,0 +1,406 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <initializer_list>
+
+#include "allocator.hpp"
+#include "iterator.hpp"
+#include "vector.hpp"
+
+
+namespace ctl {
+
+namespace detail {
+
+constexpr std::size_t log2_exact(std::size_t n) noexcept
+{
+  return n <= 1 ? 0 : 1 + log2_exact(n >> 1);
+}
+
+} // namespace detail
+
+
+/**
+ * ctl::StableVector Definition
+ *
+ * Segmented vector: elements live in fixed-size chunks of ChunkSize items
+ * obtained from A, and a ctl::Vector holds the chunk pointers. Growing only
+ * appends chunks, so elements are never copied or moved and pointers,
+ * references and iterators to them remain valid until the element itself
+ * is removed. Indexing costs one shift, one mask and one extra load.
+ */
+
+template<typename T, class A = Allocator<T>, std::size_t ChunkSize = 1024>
+class StableVector
+{
+  static_assert(ChunkSize > 0 && (ChunkSize & (ChunkSize - 1)) == 0, "ctl::StableVector: ChunkSize must be a power of two");
+
+public:
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using difference_type = typename A::difference_type;
+  using reference = typename A::reference;
+  using const_reference = typename A::const_reference;
+  using pointer = typename A::pointer;
+  using const_pointer = typename A::const_pointer;
+  using iterator = ctl::IndexIterator<StableVector, T>;
+  using const_iterator = ctl::IndexIterator<const StableVector, const T>;
+
+  static constexpr size_type chunk_size = ChunkSize;
+
+  StableVector() {};
+  StableVector(const StableVector&);
+  StableVector(StableVector&&);
+  StableVector(size_type);
+  StableVector(size_type, const_reference);
+  StableVector(std::initializer_list<T>);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  StableVector(IteratorType, IteratorType);
+
+  ~StableVector();
+
+  StableVector& operator=(const StableVector&);
+  StableVector& operator=(StableVector&&);
+
+  iterator begin() noexcept;
+  iterator end() noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+  void reserve(size_type);
+  void shrink_to_fit();
+  void resize(size_type);
+  void resize(size_type, const_reference);
+
+  reference at(size_type);
+  const_reference at(size_type) const;
+  reference operator[](size_type) noexcept;
+  const_reference operator[](size_type) const noexcept;
+  reference front();
+  reference back();
+  pointer chunk(size_type) noexcept;
+
+  void push_back(const_reference);
+  void push_back(value_type&&);
+  template<class... Args>
+  reference emplace_back(Args&&...);
+  void pop_back();
+
+  void swap(StableVector&) noexcept;
+  void clear() noexcept;
+
+  A get_allocator() const noexcept;
+
+private:
+  using chunk_allocator = typename std::allocator_traits<A>::template rebind_alloc<pointer>;
+
+  static constexpr size_type _shift = detail::log2_exact(ChunkSize);
+  static constexpr size_type _mask = ChunkSize - 1;
+
+  A _allocator;
+  Vector<pointer, chunk_allocator> _chunks;
+  size_type _size = 0;
+
+  pointer slot(size_type) const noexcept;
+  void grow();
+  void destroy_from(size_type);
+};
+
+
+/**
+ * ctl::StableVector Implementation
+ */
+
+template<typename T, typename A, std::size_t C>
+StableVector<T, A, C>::StableVector(const StableVector& other)
+{
+  reserve(other.size());
+  for (size_type i = 0; i < other.size(); ++i) {
+    push_back(other[i]);
+  }
+}
+
+template<typename T, typename A, std::size_t C>
+StableVector<T, A, C>::StableVector(StableVector&& other)
+{
+  swap(other);
+}
+
+template<typename T, typename A, std::size_t C>
+StableVector<T, A, C>::StableVector(size_type count)
+{
+  resize(count);
+}
+
+template<typename T, typename A, std::size_t C>
+StableVector<T, A, C>::StableVector(size_type count, const_reference value)
+{
+  resize(count, value);
+}
+
+template<typename T, typename A, std::size_t C>
+StableVector<T, A, C>::StableVector(std::initializer_list<T> list) : StableVector(list.begin(), list.end()) {}
+
+template<typename T, typename A, std::size_t C>
+template<typename IteratorType, typename isIterator>
+StableVector<T, A, C>::StableVector(IteratorType first, IteratorType last)
+{
+  for (; first != last; ++first) {
+    push_back(*first);
+  }
+}
+
+template<typename T, typename A, std::size_t C>
+StableVector<T, A, C>::~StableVector()
+{
+  clear();
+  for (size_type k = 0; k < _chunks.size(); ++k) {
+    _allocator.deallocate(_chunks[k], C);
+  }
+}
+
+template<typename T, typename A, std::size_t C>
+StableVector<T, A, C>& StableVector<T, A, C>::operator=(const StableVector& other)
+{
+  if (this == &other) return *this;
+  StableVector copy(other);
+  swap(copy);
+  return *this;
+}
+
+template<typename T, typename A, std::size_t C>
+StableVector<T, A, C>& StableVector<T, A, C>::operator=(StableVector&& other)
+{
+  if (this == &other) return *this;
+  StableVector moved(std::move(other));
+  swap(moved);
+  return *this;
+}
+
+template<typename T, typename A, std::size_t C>
+typename StableVector<T, A, C>::iterator StableVector<T, A, C>::begin() noexcept
+{
+  return iterator(this, 0);
+}
+
+template<typename T, typename A, std::size_t C>
+typename StableVector<T, A, C>::iterator StableVector<T, A, C>::end() noexcept
+{
+  return iterator(this, _size);
+}
+
+template<typename T, typename A, std::size_t C>
+typename StableVector<T, A, C>::const_iterator StableVector<T, A, C>::cbegin() const noexcept
+{
+  return const_iterator(this, 0);
+}
+
+template<typename T, typename A, std::size_t C>
+typename StableVector<T, A, C>::const_iterator StableVector<T, A, C>::cend() const noexcept
+{
+  return const_iterator(this, _size);
+}
+
+template<typename T, typename A, std::size_t C>
+inline typename StableVector<T, A, C>::size_type StableVector<T, A, C>::size() const noexcept
+{
+  return _size;
+}
+
+template<typename T, typename A, std::size_t C>
+typename StableVector<T, A, C>::size_type StableVector<T, A, C>::max_size() const noexcept
+{
+  return static_cast<size_type>(-1) / sizeof(T);
+}
+
+template<typename T, typename A, std::size_t C>
+inline typename StableVector<T, A, C>::size_type StableVector<T, A, C>::capacity() const noexcept
+{
+  return _chunks.size() * C;
+}
+
+template<typename T, typename A, std::size_t C>
+inline bool StableVector<T, A, C>::empty() const noexcept
+{
+  return _size == 0;
+}
+
+template<typename T, typename A, std::size_t C>
+void StableVector<T, A, C>::reserve(size_type newCapacity)
+{
+  if (newCapacity > max_size()) {
+    throw std::length_error("ctl::StableVector: too big capacity to reserve");
+  }
+  while (capacity() < newCapacity) {
+    grow();
+  }
+}
+
+template<typename T, typename A, std::size_t C>
+void StableVector<T, A, C>::shrink_to_fit()
+{
+  size_type used = (_size + C - 1) >> _shift;
+  while (_chunks.size() > used) {
+    _allocator.deallocate(_chunks.back(), C);
+    _chunks.pop_back();
+  }
+}
+
+template<typename T, typename A, std::size_t C>
+void StableVector<T, A, C>::resize(size_type newSize)
+{
+  if (newSize < _size) {
+    destroy_from(newSize);
+    return;
+  }
+  reserve(newSize);
+  while (_size < newSize) {
+    emplace_back();
+  }
+}
+
+template<typename T, typename A, std::size_t C>
+void StableVector<T, A, C>::resize(size_type newSize, const_reference value)
+{
+  if (newSize < _size) {
+    destroy_from(newSize);
+    return;
+  }
+  reserve(newSize);
+  while (_size < newSize) {
+    emplace_back(value);
+  }
+}
+
+template<typename T, typename A, std::size_t C>
+typename StableVector<T, A, C>::reference StableVector<T, A, C>::at(size_type i)
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::StableVector: out of range");
+  }
+  return *slot(i);
+}
+
+template<typename T, typename A, std::size_t C>
+typename StableVector<T, A, C>::const_reference StableVector<T, A, C>::at(size_type i) const
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::StableVector: out of range");
+  }
+  return *slot(i);
+}
+
+template<typename T, typename A, std::size_t C>
+inline typename StableVector<T, A, C>::reference StableVector<T, A, C>::operator[](size_type i) noexcept
+{
+  return *slot(i);
+}
+
+template<typename T, typename A, std::size_t C>
+inline typename StableVector<T, A, C>::const_reference StableVector<T, A, C>::operator[](size_type i) const noexcept
+{
+  return *slot(i);
+}
+
+template<typename T, typename A, std::size_t C>
+typename StableVector<T, A, C>::reference StableVector<T, A, C>::front()
+{
+  return *slot(0);
+}
+
+template<typename T, typename A, std::size_t C>
+typename StableVector<T, A, C>::reference StableVector<T, A, C>::back()
+{
+  return *slot(_size - 1);
+}
+
+template<typename T, typename A, std::size_t C>
+typename StableVector<T, A, C>::pointer StableVector<T, A, C>::chunk(size_type k) noexcept
+{
+  return _chunks[k];
+}
+
+template<typename T, typename A, std::size_t C>
+void StableVector<T, A, C>::push_back(const_reference value)
+{
+  emplace_back(value);
+}
+
+template<typename T, typename A, std::size_t C>
+void StableVector<T, A, C>::push_back(value_type&& value)
+{
+  emplace_back(std::move(value));
+}
+
+template<typename T, typename A, std::size_t C>
+template<class... Args>
+typename StableVector<T, A, C>::reference StableVector<T, A, C>::emplace_back(Args&&... args)
+{
+  if (_size == capacity()) {
+    grow();
+  }
+  pointer p = slot(_size);
+  _allocator.construct(p, std::forward<Args>(args)...);
+  ++_size;
+  return *p;
+}
+
+template<typename T, typename A, std::size_t C>
+void StableVector<T, A, C>::pop_back()
+{
+  _allocator.destroy(slot(--_size));
+}
+
+template<typename T, typename A, std::size_t C>
+void StableVector<T, A, C>::swap(StableVector& other) noexcept
+{
+  _chunks.swap(other._chunks);
+  std::swap(_size, other._size);
+}
+
+template<typename T, typename A, std::size_t C>
+void StableVector<T, A, C>::clear() noexcept
+{
+  destroy_from(0);
+}
+
+template<typename T, typename A, std::size_t C>
+typename StableVector<T, A, C>::allocator_type StableVector<T, A, C>::get_allocator() const noexcept
+{
+  return _allocator;
+}
+
+template<typename T, typename A, std::size_t C>
+inline typename StableVector<T, A, C>::pointer StableVector<T, A, C>::slot(size_type i) const noexcept
+{
+  return _chunks[i >> _shift] + (i & _mask);
+}
+
+template<typename T, typename A, std::size_t C>
+void StableVector<T, A, C>::grow()
+{
+  pointer fresh = _allocator.allocate(C);
+  try {
+    _chunks.push_back(fresh);
+  } catch (...) {
+    _allocator.deallocate(fresh, C);
+    throw;
+  }
+}
+
+template<typename T, typename A, std::size_t C>
+void StableVector<T, A, C>::destroy_from(size_type newSize)
+{
+  while (_size > newSize) {
+    _allocator.destroy(slot(--_size));
+  }
+}
+
+} // namespace ctl
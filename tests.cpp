@@ -1,8 +1,28 @@
+#include <algorithm>
+#include <numeric>
+#include <string>
 #include <vector>
 #include <exception>
 
 #include "catch.hpp"
 #include "vector.hpp"
+#include "algorithm.hpp"
+#include "thread_pool.hpp"
+#include "concurrent_vector.hpp"
+#include "stable_vector.hpp"
+#include "devector.hpp"
+#include "gap_vector.hpp"
+#include "soa_vector.hpp"
+#include "flat_map.hpp"
+#include "hash_map.hpp"
+#include "packed_int_vector.hpp"
+#include "cow_vector.hpp"
+#include "persistent_vector.hpp"
+#include "vector_builder.hpp"
+#include "slot_map.hpp"
+#include "circular_vector.hpp"
+#include "bounded_queue.hpp"
+#include "span.hpp"
 
 
 TEST_CASE("Vector constructor tests") {
@@ -86,6 +106,16 @@ TEST_CASE("Vector: all about data") {
     REQUIRE_FALSE(a != v.get_allocator());
   }
 
+  SECTION("Object layout") {
+    REQUIRE_FALSE(std::is_polymorphic< ctl::Vector<int> >::value);
+    REQUIRE_FALSE(std::is_polymorphic< ctl::Allocator<int> >::value);
+    REQUIRE(std::is_empty< ctl::Allocator<int> >::value);
+#if !defined(CTL_CHECKED_ITERATORS)
+    REQUIRE(sizeof(ctl::Vector<int>) == sizeof(std::vector<int>));
+    REQUIRE(sizeof(ctl::Vector<std::string>) == 3 * sizeof(std::string*));
+#endif
+  }
+
 }
 
 
@@ -300,6 +330,62 @@ TEST_CASE("Vector modifications") {
     }
   }
 
+  SECTION("Erase by predicate") {
+    ctl::Vector<std::string> v = { "a", "", "b", "", "", "c" };
+    REQUIRE(v.erase_if([](const std::string& s) { return s.empty(); }) == 3);
+    REQUIRE(v.size() == 3);
+    REQUIRE(v[0] == "a");
+    REQUIRE(v[2] == "c");
+    REQUIRE(v.erase_if([](const std::string&) { return false; }) == 0);
+  }
+
+  SECTION("Unordered erase") {
+    ctl::Vector<std::string> v = { "a", "b", "c", "d" };
+    auto it = v.erase_unordered(v.begin() + 1);
+    REQUIRE(*it == "d");
+    REQUIRE(v.size() == 3);
+    REQUIRE(v[0] == "a");
+    REQUIRE(v[2] == "c");
+    it = v.erase_unordered(v.begin() + 2);
+    REQUIRE(it == v.end());
+
+    ctl::Vector<int> w = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    REQUIRE(w.erase_unordered_if([](int x) { return x % 3 != 1; }) == 6);
+    std::sort(w.begin(), w.end());
+    int expected[] = { 1, 4, 7, 10 };
+    REQUIRE(w.size() == 4);
+    REQUIRE(std::equal(w.begin(), w.end(), expected));
+  }
+
+  SECTION("Erase by sorted indices") {
+    ctl::Vector<int> v = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    std::vector<size_t> indices = { 1, 2, 5, 7 };
+    REQUIRE(v.erase_indices(indices.begin(), indices.end()) == 4);
+    int expected[] = { 0, 3, 4, 6 };
+    REQUIRE(v.size() == 4);
+    REQUIRE(std::equal(v.begin(), v.end(), expected));
+
+    std::vector<size_t> unsorted = { 2, 1 };
+    std::vector<size_t> outside = { 4 };
+    REQUIRE_THROWS_AS(v.erase_indices(unsorted.begin(), unsorted.end()), std::invalid_argument);
+    REQUIRE_THROWS_AS(v.erase_indices(outside.begin(), outside.end()), std::invalid_argument);
+    REQUIRE(v.size() == 4);
+  }
+
+  SECTION("Insert sorted batch") {
+    ctl::Vector<std::string> v = { "b", "d", "f" };
+    std::vector<size_t> positions = { 0, 1, 2, 2, 3 };
+    std::vector<std::string> values = { "a", "c", "e1", "e2", "g" };
+    v.insert_batch(positions.begin(), positions.end(), values.begin());
+    std::string expected[] = { "a", "b", "c", "d", "e1", "e2", "f", "g" };
+    REQUIRE(v.size() == 8);
+    REQUIRE(std::equal(v.begin(), v.end(), expected));
+
+    std::vector<size_t> bad = { 3, 1 };
+    REQUIRE_THROWS_AS(v.insert_batch(bad.begin(), bad.end(), values.begin()), std::invalid_argument);
+    REQUIRE(v.size() == 8);
+  }
+
   SECTION("Swap vectors") {
     ctl::Vector<int> v = { 5, 4, 3, 2, 1 };
     ctl::Vector<int> src = { 1, 2, 3, 4, 5 };
@@ -331,19 +417,46 @@ TEST_CASE("Vector modifications") {
     ctl::Vector< ctl::Vector<int> > v;
     v.emplace_back(4, 1);
     ctl::Vector<int> a = v.front();
+    REQUIRE(a.size() == 4);
     for (ctl::Vector<int>::iterator it = a.begin(); it != a.end(); ++it) {
-      REQUIRE(*it == 0);
+      REQUIRE(*it == 1);
     }
   }
 
   SECTION("Emplace item at positiion") {
     ctl::Vector< ctl::Vector<int> > v(3, ctl::Vector<int>(3, 2));
     ctl::Vector<int> a = *(v.emplace(v.begin() + 1, 3, 1));
+    REQUIRE(a.size() == 3);
     for (ctl::Vector<int>::iterator it = a.begin(); it != a.end(); ++it) {
-      REQUIRE(*it == 0);
+      REQUIRE(*it == 1);
     }
   }
 
+  SECTION("Shift non-trivial elements") {
+    ctl::Vector<std::string> v = { "a", "d" };
+    v.insert(v.begin() + 1, std::string("c"));
+    v.emplace(v.begin() + 1, "b");
+    v.insert(v.begin() + 4, 2, std::string("e"));
+    ctl::Vector<std::string> tail = { "f", "g" };
+    v.insert(v.end(), tail.begin(), tail.end());
+    std::string expected[] = { "a", "b", "c", "d", "e", "e", "f", "g" };
+    REQUIRE(v.size() == 8);
+    REQUIRE(std::equal(v.begin(), v.end(), expected));
+
+    v.erase(v.begin() + 4);
+    v.erase(v.begin() + 1, v.begin() + 3);
+    v.pop_back();
+    std::string left[] = { "a", "d", "e", "f" };
+    REQUIRE(v.size() == 4);
+    REQUIRE(std::equal(v.begin(), v.end(), left));
+
+    std::string moved("long enough to live on the heap");
+    v.push_back(std::move(moved));
+    REQUIRE(v.back() == "long enough to live on the heap");
+    v.clear();
+    REQUIRE(v.empty());
+  }
+
 }
 
 
@@ -383,7 +496,9 @@ TEST_CASE("Vector exceptions") {
       REQUIRE( v.at(3) == v[3] );
       REQUIRE( v.at(3) == v[3] );
       REQUIRE( *v.begin() == *v.cbegin() );
+#if !defined(CTL_CHECKED_ITERATORS)
       REQUIRE( *v.end() == *v.cend() );
+#endif
       REQUIRE( *v.data() == v.front() );
       v.insert(v.begin(), 1);
       v.insert(v.begin() + 1, 2, 2);
@@ -550,6 +665,61 @@ TEST_CASE("Iterator tests") {
     REQUIRE(first != last);
   }
 
+  SECTION("Plain pointer semantics") {
+#if !defined(CTL_CHECKED_ITERATORS)
+    REQUIRE(std::is_trivially_copyable< ctl::Iterator<int> >::value);
+    REQUIRE(std::is_trivially_destructible< ctl::Iterator<int> >::value);
+    REQUIRE(sizeof(ctl::Iterator<int>) == sizeof(int*));
+#endif
+    REQUIRE((std::is_same< std::iterator_traits< ctl::Vector<int>::const_iterator >::value_type, int >::value));
+
+    ctl::Vector<int> v = { 1, 2, 3, 4, 5 };
+    ctl::Vector<int>::const_iterator it = v.begin();
+    REQUIRE(it.base() == v.data());
+    REQUIRE(*(2 + it) == 3);
+    REQUIRE((v.end() - 1).base() == &v.back());
+  }
+
+#if defined(CTL_CHECKED_ITERATORS)
+  SECTION("Checked mode") {
+    ctl::Vector<int> v = { 1, 2, 3 };
+    ctl::Vector<int> w = { 4, 5 };
+    auto it = v.begin();
+    REQUIRE(*(it + 2) == 3);
+    REQUIRE_THROWS_AS(*v.end(), std::out_of_range);
+    REQUIRE_THROWS_AS(it[-1], std::out_of_range);
+    REQUIRE_THROWS_AS(it == w.begin(), std::logic_error);
+    REQUIRE_THROWS_AS(w.end() - it, std::logic_error);
+
+    v.reserve(100);
+    REQUIRE_THROWS_AS(*it, std::logic_error);
+    it = v.begin();
+    REQUIRE(*it == 1);
+
+    v.swap(w);
+    REQUIRE(*it == 1);
+    REQUIRE(it + 3 == w.end());
+    REQUIRE_THROWS_AS(it == v.begin(), std::logic_error);
+
+    w.clear();
+    REQUIRE_THROWS_AS(*it, std::logic_error);
+    REQUIRE_THROWS_AS(w.pop_back(), std::out_of_range);
+    REQUIRE(ctl::Iterator<int>(v.data()) == ctl::Iterator<int>(v.data()));
+
+    ctl::Vector<int> u = { 1, 2, 3 };
+    u.reserve(10);
+    auto inserted = u.insert(u.begin() + 1, 7);
+    REQUIRE(*inserted == 7);
+    REQUIRE(inserted + 3 == u.end());
+    REQUIRE_THROWS_AS(inserted[3], std::out_of_range);
+    REQUIRE_THROWS_AS(inserted == w.begin(), std::logic_error);
+    auto emplaced = u.emplace(u.begin(), 0);
+    REQUIRE(*emplaced == 0);
+    u.shrink_to_fit();
+    REQUIRE_THROWS_AS(*emplaced, std::logic_error);
+  }
+#endif
+
 }
 
 
@@ -594,3 +764,1724 @@ TEST_CASE("STL compatibility") {
   }
 
 }
+
+
+TEST_CASE("NUMA-aware allocation") {
+
+  SECTION("Topology queries") {
+    REQUIRE(ctl::numa::node_count() >= 1);
+    REQUIRE(ctl::numa::current_node() >= 0);
+    REQUIRE(ctl::numa::current_node() < ctl::numa::node_count());
+    REQUIRE(ctl::numa::run_on_node(0));
+  }
+
+  SECTION("Vector with interleaved allocator") {
+    ctl::Vector<int, ctl::NumaAllocator<int>> v;
+    for (int i = 0; i < 10000; ++i) {
+      v.push_back(i);
+    }
+    REQUIRE(v.size() == 10000);
+    for (size_t i = 0; i < v.size(); ++i) {
+      REQUIRE(v[i] == i);
+    }
+  }
+
+  SECTION("Vector with node-bound allocator") {
+    ctl::Vector<int, ctl::NumaAllocator<int, ctl::NumaPolicy::Bind, 0>> v(100, 7);
+    REQUIRE(v.size() == 100);
+    REQUIRE(v.back() == 7);
+  }
+
+  SECTION("First-touch resize") {
+    ctl::Vector<int> v = { 1, 2, 3 };
+    v.resize(ctl::first_touch, 100000);
+    REQUIRE(v.size() == 100000);
+    REQUIRE(v[2] == 3);
+    REQUIRE(std::count(v.begin(), v.end(), 0) == 100000 - 3);
+    v.resize(ctl::first_touch, 2);
+    REQUIRE(v.size() == 2);
+  }
+
+  SECTION("First-touch assign") {
+    ctl::Vector<int, ctl::NumaAllocator<int>> v;
+    v.assign(ctl::first_touch, 100000, 5);
+    REQUIRE(v.size() == 100000);
+    REQUIRE(std::count(v.begin(), v.end(), 5) == 100000);
+  }
+
+  SECTION("First-touch construction failure leaves size untouched") {
+    static int budget = 0;
+
+    struct Fragile
+    {
+      int a = 0;
+      Fragile() { if (--budget < 0) throw std::runtime_error("no more"); }
+    };
+
+    ctl::Vector<Fragile> v;
+    budget = 50000;
+    REQUIRE_THROWS(v.resize(ctl::first_touch, 100000));
+    REQUIRE(v.size() == 0);
+  }
+
+}
+
+
+TEST_CASE("Parallel algorithms") {
+
+  const int n = 100000;
+  ctl::Vector<int> v;
+  for (int i = 0; i < n; ++i) {
+    v.push_back((i * 7919) % n);
+  }
+
+  SECTION("for_each") {
+    ctl::for_each(ctl::execution::par, v.begin(), v.end(), [](int& x) { x *= 2; });
+    ctl::for_each(ctl::execution::par_unseq, v.begin(), v.end(), [](int& x) { x += 1; });
+    REQUIRE(std::count_if(v.begin(), v.end(), [](int x) { return x % 2 == 1; }) == n);
+  }
+
+  SECTION("transform") {
+    ctl::Vector<int> out(v.size());
+    auto last = ctl::transform(ctl::execution::par, v.begin(), v.end(), out.begin(), [](int x) { return x + 1; });
+    REQUIRE(last == out.end());
+    REQUIRE(std::equal(v.begin(), v.end(), out.begin(), [](int x, int y) { return x + 1 == y; }));
+  }
+
+  SECTION("binary transform") {
+    ctl::Vector<int> out(v.size());
+    auto last = ctl::transform(ctl::execution::par, v.begin(), v.end(), v.begin(), out.begin(), [](int x, int y) { return x + y; });
+    REQUIRE(last == out.end());
+    REQUIRE(std::equal(v.begin(), v.end(), out.begin(), [](int x, int y) { return 2 * x == y; }));
+    ctl::transform(ctl::execution::par_unseq, v.begin(), v.end(), out.begin(), out.begin(), [](int x, int y) { return y - x; });
+    REQUIRE(std::equal(v.begin(), v.end(), out.begin()));
+  }
+
+  SECTION("reduce") {
+    long long expected = std::accumulate(v.begin(), v.end(), 0ll);
+    REQUIRE(ctl::reduce(ctl::execution::par, v.begin(), v.end(), 0ll) == expected);
+    REQUIRE(ctl::reduce(ctl::execution::seq, v.begin(), v.end(), 0ll) == expected);
+    REQUIRE(ctl::reduce(ctl::execution::par, v.begin(), v.begin()) == 0);
+  }
+
+  SECTION("inclusive_scan") {
+    ctl::Vector<long long> src(v.begin(), v.end());
+    ctl::Vector<long long> expected(src.size());
+    ctl::Vector<long long> out(src.size());
+    std::partial_sum(src.begin(), src.end(), expected.begin());
+    ctl::inclusive_scan(ctl::execution::par, src.begin(), src.end(), out.begin());
+    REQUIRE(std::equal(out.begin(), out.end(), expected.begin()));
+  }
+
+  SECTION("sort") {
+    ctl::sort(ctl::execution::par, v.begin(), v.end());
+    REQUIRE(v[0] == 0);
+    REQUIRE(v[n - 1] == n - 1);
+    REQUIRE(std::adjacent_find(v.begin(), v.end(), [](int a, int b) { return b != a + 1; }) == v.end());
+    ctl::sort(ctl::execution::par_unseq, v.begin(), v.end(), std::greater<int>());
+    REQUIRE(std::is_sorted(v.begin(), v.end(), std::greater<int>()));
+  }
+
+  SECTION("stable_sort") {
+    ctl::Vector<std::pair<int, int>> pairs;
+    for (int i = 0; i < n; ++i) {
+      pairs.push_back(std::make_pair(v[i] % 10, i));
+    }
+    ctl::stable_sort(ctl::execution::par, pairs.begin(), pairs.end(),
+        [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; });
+    REQUIRE(std::is_sorted(pairs.begin(), pairs.end()));
+  }
+
+  SECTION("find_if and count_if") {
+    auto it = ctl::find_if(ctl::execution::par, v.begin(), v.end(), [](int x) { return x == 4242; });
+    REQUIRE(it == std::find(v.begin(), v.end(), 4242));
+    it = ctl::find_if(ctl::execution::par, v.begin(), v.end(), [](int x) { return x < 0; });
+    REQUIRE(it == v.end());
+    REQUIRE(ctl::count_if(ctl::execution::par, v.begin(), v.end(), [](int x) { return x < 100; }) == 100);
+  }
+
+  SECTION("Exceptions are propagated") {
+    REQUIRE_THROWS_AS(
+        ctl::for_each(ctl::execution::par, v.begin(), v.end(), [](int x) { if (x == 99999) throw std::runtime_error("bad"); }),
+        std::runtime_error
+      );
+  }
+
+}
+
+
+TEST_CASE("Work-stealing thread pool") {
+
+  SECTION("Chase-Lev deque order") {
+    ctl::ChaseLevDeque<int> deque(2);
+    int items[100];
+    for (int i = 0; i < 100; ++i) {
+      items[i] = i;
+      deque.push(&items[i]);
+    }
+    REQUIRE(*deque.steal() == 0);
+    REQUIRE(*deque.pop() == 99);
+    REQUIRE(*deque.steal() == 1);
+    int left = 0;
+    while (deque.pop()) {
+      ++left;
+    }
+    REQUIRE(left == 97);
+    REQUIRE(deque.empty());
+    REQUIRE(deque.steal() == nullptr);
+  }
+
+  SECTION("Chase-Lev deque with concurrent thieves") {
+    const int n = 100000;
+    std::unique_ptr<int[]> items(new int[n]);
+    ctl::ChaseLevDeque<int> deque;
+    std::atomic<long long> stolen(0);
+    std::atomic<bool> done(false);
+
+    std::thread thief([&]() {
+      while (!done || !deque.empty()) {
+        if (int* x = deque.steal()) stolen += *x;
+      }
+    });
+    long long popped = 0;
+    for (int i = 0; i < n; ++i) {
+      items[i] = i;
+      deque.push(&items[i]);
+      if (i % 3 == 0) {
+        if (int* x = deque.pop()) popped += *x;
+      }
+    }
+    done = true;
+    thief.join();
+    REQUIRE(popped + stolen == (long long)n * (n - 1) / 2);
+  }
+
+  SECTION("Configured pool") {
+    ctl::ThreadPool pool(3, ctl::Affinity::Core);
+    REQUIRE(pool.size() == 3);
+    REQUIRE(pool.affinity() == ctl::Affinity::Core);
+
+    std::atomic<int> sum(0);
+    ctl::TaskGroup group(pool);
+    for (int i = 1; i <= 100; ++i) {
+      group.run([&sum, i]() { sum += i; });
+    }
+    group.wait();
+    REQUIRE(sum == 5050);
+  }
+
+  SECTION("Global pool cannot be reconfigured once started") {
+    ctl::ThreadPool::instance();
+    REQUIRE_FALSE(ctl::ThreadPool::configure(2));
+  }
+
+  SECTION("parallel_for visits each index once") {
+    const std::size_t n = 100003;
+    ctl::Vector<int> hits(n);
+    std::atomic<std::size_t> largest(0);
+    ctl::parallel_for(ctl::IndexRange{0, n}, 1000, [&](std::size_t lo, std::size_t hi) {
+      if (hi - lo > largest) largest = hi - lo;
+      for (std::size_t i = lo; i < hi; ++i) {
+        ++hits[i];
+      }
+    });
+    REQUIRE(largest <= 1000);
+    REQUIRE(std::count(hits.begin(), hits.end(), 1) == n);
+  }
+
+  SECTION("Nested parallel_for") {
+    std::atomic<std::size_t> total(0);
+    ctl::ThreadPool pool(2);
+    pool.parallel_for(ctl::IndexRange{0, 64}, 1, [&](std::size_t lo, std::size_t hi) {
+      for (std::size_t i = lo; i < hi; ++i) {
+        pool.parallel_for(ctl::IndexRange{0, 1000}, 10, [&](std::size_t a, std::size_t b) { total += b - a; });
+      }
+    });
+    REQUIRE(total == 64000);
+  }
+
+}
+
+
+namespace {
+
+int allocationsLeft = -1;
+
+/**
+ * std::allocator that throws bad_alloc once allocationsLeft reaches zero,
+ * and keeps throwing until it is reset to a negative value.
+ */
+template<typename U>
+struct LimitedAllocator : std::allocator<U>
+{
+  template<typename V>
+  struct rebind { using other = LimitedAllocator<V>; };
+
+  LimitedAllocator() = default;
+  template<typename V>
+  LimitedAllocator(const LimitedAllocator<V>&) noexcept {}
+
+  U* allocate(std::size_t n)
+  {
+    if (allocationsLeft == 0) throw std::bad_alloc();
+    if (allocationsLeft > 0) --allocationsLeft;
+    return std::allocator<U>::allocate(n);
+  }
+};
+
+} // namespace
+
+TEST_CASE("Concurrent vector") {
+
+  SECTION("Sequential appends") {
+    ctl::ConcurrentVector<int> v;
+    REQUIRE(v.empty());
+    REQUIRE(v.push_back(10) == 0);
+    REQUIRE(v.emplace_back(11) == 1);
+    REQUIRE(v.grow_by(3, 7) == 2);
+    REQUIRE(v.grow_by(2) == 5);
+    REQUIRE(v.size() == 7);
+    REQUIRE(v[0] == 10);
+    REQUIRE(v[1] == 11);
+    REQUIRE(v.at(4) == 7);
+    REQUIRE(v.at(6) == 0);
+    REQUIRE_THROWS_AS(v.at(7), std::out_of_range);
+  }
+
+  SECTION("References survive growth") {
+    ctl::ConcurrentVector<int> v;
+    v.push_back(42);
+    int* first = &v[0];
+    for (int i = 0; i < 10000; ++i) {
+      v.push_back(i);
+    }
+    REQUIRE(first == &v[0]);
+    REQUIRE(*first == 42);
+    REQUIRE(v.capacity() >= v.size());
+  }
+
+  SECTION("Concurrent producers") {
+    const int producers = 4;
+    const int perProducer = 20000;
+    ctl::ConcurrentVector<long long> v;
+    std::atomic<bool> go(false);
+    std::thread threads[producers];
+    for (int p = 0; p < producers; ++p) {
+      threads[p] = std::thread([&v, &go, p]() {
+        while (!go) {}
+        for (int i = 0; i < perProducer; ++i) {
+          v.push_back((long long)p * perProducer + i);
+        }
+      });
+    }
+    go = true;
+    for (auto& t : threads) {
+      t.join();
+    }
+    REQUIRE(v.size() == producers * perProducer);
+    long long sum = 0;
+    for (size_t i = 0; i < v.size(); ++i) {
+      sum += v[i];
+    }
+    const long long n = producers * perProducer;
+    REQUIRE(sum == n * (n - 1) / 2);
+  }
+
+  SECTION("Failed construction leaves a hole") {
+    struct Picky
+    {
+      int a;
+      Picky(int a) : a(a) { if (a < 0) throw std::invalid_argument("negative"); }
+    };
+
+    ctl::ConcurrentVector<Picky> v;
+    v.emplace_back(1);
+    REQUIRE_THROWS_AS(v.emplace_back(-1), std::invalid_argument);
+    v.emplace_back(3);
+    REQUIRE(v.size() == 3);
+    REQUIRE(v.at(2).a == 3);
+    REQUIRE_THROWS_AS(v.at(1), std::logic_error);
+  }
+
+  SECTION("Failed grow_by abandons the rest of its claim") {
+    static int constructionsLeft = -1;
+    struct Fragile
+    {
+      int a = 7;
+      Fragile() { if (constructionsLeft >= 0 && constructionsLeft-- == 0) throw std::runtime_error("construction failed"); }
+      Fragile(int a) : a(a) {}
+    };
+
+    ctl::ConcurrentVector<Fragile> v;
+    v.emplace_back(1);
+    constructionsLeft = 4;
+    REQUIRE_THROWS_AS(v.grow_by(20), std::runtime_error);
+    constructionsLeft = -1;
+    REQUIRE(v.size() == 21);
+    REQUIRE(v.emplace_back(2) == 21);
+    REQUIRE(v.size() == 22);
+    for (std::size_t i = 1; i <= 4; ++i) {
+      REQUIRE(v.at(i).a == 7);
+    }
+    for (std::size_t i = 5; i <= 20; ++i) {
+      REQUIRE_THROWS_AS(v.at(i), std::logic_error);
+    }
+    REQUIRE(v.at(21).a == 2);
+  }
+
+  SECTION("Failed segment allocation leaves a hole") {
+    ctl::ConcurrentVector<int, LimitedAllocator<int>> v;
+    for (int i = 0; i < 8; ++i) {
+      v.push_back(i);
+    }
+    allocationsLeft = 1;
+    REQUIRE_THROWS_AS(v.push_back(8), std::bad_alloc);
+    allocationsLeft = -1;
+    REQUIRE(v.size() == 9);
+    REQUIRE(v.push_back(9) == 9);
+    REQUIRE(v.size() == 10);
+    REQUIRE_THROWS_AS(v.at(8), std::logic_error);
+    REQUIRE(v.at(9) == 9);
+  }
+
+  SECTION("Destruction skips segments without flags") {
+    ctl::ConcurrentVector<int, LimitedAllocator<int>> v;
+    for (int i = 0; i < 8; ++i) {
+      v.push_back(i);
+    }
+    allocationsLeft = 0;
+    REQUIRE_THROWS_AS(v.push_back(8), std::bad_alloc);
+    allocationsLeft = -1;
+    REQUIRE(v.size() == 8);
+    REQUIRE(v.claimed() == 9);
+  }
+
+}
+
+
+TEST_CASE("Parallel bulk copy") {
+
+  static std::atomic<int> alive(0);
+  static std::atomic<int> copiesLeft(-1);
+
+  struct Counted
+  {
+    int a = 0;
+    Counted(int a = 0) : a(a) { ++alive; }
+    Counted(const Counted& other) : a(other.a)
+    {
+      if (copiesLeft >= 0 && copiesLeft-- == 0) throw std::runtime_error("copy failed");
+      ++alive;
+    }
+    Counted(Counted&& other) noexcept : a(other.a) { ++alive; }
+    Counted& operator=(const Counted& other) { a = other.a; return *this; }
+    ~Counted() { --alive; }
+  };
+
+  ctl::set_parallel_copy_threshold(1000);
+
+  SECTION("Trivially copyable elements") {
+    ctl::Vector<int> src;
+    for (int i = 0; i < 100000; ++i) {
+      src.push_back(i);
+    }
+    ctl::Vector<int> copy(src);
+    REQUIRE(copy.size() == src.size());
+    REQUIRE(std::equal(src.begin(), src.end(), copy.begin()));
+
+    ctl::Vector<int> assigned = { 1, 2, 3 };
+    assigned = src;
+    REQUIRE(std::equal(src.begin(), src.end(), assigned.begin()));
+  }
+
+  SECTION("Non-trivial elements") {
+    {
+      ctl::Vector<Counted> src(5000, Counted(7));
+      ctl::Vector<Counted> copy(src);
+      REQUIRE(copy.size() == 5000);
+      REQUIRE(copy[4999].a == 7);
+      copy.reserve(20000);
+      REQUIRE(copy[0].a == 7);
+      REQUIRE(alive == 10000);
+    }
+    REQUIRE(alive == 0);
+  }
+
+  SECTION("Strong guarantee on failed copy") {
+    {
+      ctl::Vector<Counted> src(5000, Counted(7));
+      ctl::Vector<Counted> dst(10, Counted(1));
+      copiesLeft = 4000;
+      REQUIRE_THROWS_AS(ctl::Vector<Counted>(src), std::runtime_error);
+      REQUIRE(alive == 5010);
+      copiesLeft = 4000;
+      REQUIRE_THROWS_AS(dst = src, std::runtime_error);
+      copiesLeft = -1;
+      REQUIRE(dst.size() == 10);
+      REQUIRE(dst[9].a == 1);
+      REQUIRE(alive == 5010);
+    }
+    REQUIRE(alive == 0);
+  }
+
+  ctl::set_parallel_copy_threshold(0);
+
+}
+
+
+TEST_CASE("Stable vector") {
+
+  using Small = ctl::StableVector<int, ctl::Allocator<int>, 4>;
+
+  SECTION("Chunk table comes from the container's allocator") {
+    ctl::StableVector<int, LimitedAllocator<int>, 4> v;
+    allocationsLeft = 1;
+    REQUIRE_THROWS_AS(v.push_back(1), std::bad_alloc);
+    allocationsLeft = -1;
+    REQUIRE(v.empty());
+    REQUIRE(v.capacity() == 0);
+    v.push_back(1);
+    REQUIRE(v.capacity() == 4);
+  }
+
+  SECTION("Construction and access") {
+    Small v = { 5, 4, 3, 2, 1, 0 };
+    REQUIRE(v.size() == 6);
+    REQUIRE(v.capacity() == 8);
+    REQUIRE(v.front() == 5);
+    REQUIRE(v.back() == 0);
+    REQUIRE(v.at(4) == 1);
+    REQUIRE_THROWS_AS(v.at(6), std::out_of_range);
+
+    Small copy(v);
+    copy[0] = 9;
+    REQUIRE(v[0] == 5);
+    REQUIRE(copy.size() == 6);
+
+    Small moved(std::move(copy));
+    REQUIRE(moved[0] == 9);
+    REQUIRE(copy.empty());
+  }
+
+  SECTION("Growth keeps addresses") {
+    Small v;
+    v.push_back(1);
+    int* first = &v[0];
+    Small::iterator it = v.begin();
+    for (int i = 2; i <= 100; ++i) {
+      v.push_back(i);
+    }
+    REQUIRE(&v[0] == first);
+    REQUIRE(&*it == first);
+    REQUIRE(v.size() == 100);
+    REQUIRE(v[99] == 100);
+  }
+
+  SECTION("Random access iteration") {
+    Small v = { 5, 4, 3, 2, 1, 0 };
+    std::sort(v.begin(), v.end());
+    for (int i = 0; i < 6; ++i) {
+      REQUIRE(v[i] == i);
+    }
+    REQUIRE(v.end() - v.begin() == 6);
+    REQUIRE(*(v.begin() + 5) == 5);
+    REQUIRE(std::accumulate(v.cbegin(), v.cend(), 0) == 15);
+  }
+
+  SECTION("Resize, pop and shrink") {
+    Small v(10, 7);
+    v.pop_back();
+    REQUIRE(v.size() == 9);
+    v.resize(3);
+    REQUIRE(v.size() == 3);
+    REQUIRE(v.capacity() == 12);
+    v.shrink_to_fit();
+    REQUIRE(v.capacity() == 4);
+    v.resize(5, 1);
+    REQUIRE(v[2] == 7);
+    REQUIRE(v[4] == 1);
+    v.clear();
+    REQUIRE(v.empty());
+    REQUIRE(v.capacity() == 8);
+  }
+
+}
+
+
+TEST_CASE("Devector") {
+
+  SECTION("Push and pop at both ends") {
+    ctl::Devector<int> v;
+    for (int i = 0; i < 100; ++i) {
+      v.push_back(i);
+      v.push_front(-i - 1);
+    }
+    REQUIRE(v.size() == 200);
+    for (int i = 0; i < 200; ++i) {
+      REQUIRE(v[i] == i - 100);
+    }
+    REQUIRE(v.data() == &v.front());
+    v.pop_front();
+    v.pop_back();
+    REQUIRE(v.front() == -99);
+    REQUIRE(v.back() == 98);
+    REQUIRE_THROWS_AS(v.at(198), std::out_of_range);
+  }
+
+  SECTION("Insert and erase shift the shorter side") {
+    ctl::Devector<int> v = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    v.reserve_front(16);
+    v.reserve(16);
+    int* back = &v.back();
+    v.insert(v.begin() + 1, 10);
+    REQUIRE(&v.back() == back);
+    int* front = &v.front();
+    v.insert(v.end() - 1, 20);
+    REQUIRE(&v.front() == front);
+
+    int expected[] = { 0, 10, 1, 2, 3, 4, 5, 6, 20, 7 };
+    REQUIRE(v.size() == 10);
+    REQUIRE(std::equal(v.begin(), v.end(), expected));
+
+    back = &v.back();
+    v.erase(v.begin() + 1);
+    REQUIRE(&v.back() == back);
+    v.erase(v.end() - 2);
+    REQUIRE(v.front() == 0);
+    v.erase(v.begin() + 2, v.begin() + 5);
+    int rest[] = { 0, 1, 5, 6, 7 };
+    REQUIRE(v.size() == 5);
+    REQUIRE(std::equal(v.begin(), v.end(), rest));
+  }
+
+  SECTION("Queue use keeps capacity bounded") {
+    ctl::Devector<int> v;
+    for (int i = 0; i < 10000; ++i) {
+      v.push_back(i);
+      if (v.size() > 16) v.pop_front();
+    }
+    REQUIRE(v.size() == 16);
+    REQUIRE(v.front() == 9984);
+    REQUIRE(v.capacity() <= 64);
+  }
+
+  SECTION("Copy, move and resize") {
+    ctl::Devector<int> v(4, 3);
+    ctl::Devector<int> copy(v);
+    copy.resize(6);
+    REQUIRE(copy[3] == 3);
+    REQUIRE(copy[5] == 0);
+    REQUIRE(v.size() == 4);
+
+    ctl::Devector<int> moved(std::move(copy));
+    REQUIRE(moved.size() == 6);
+    REQUIRE(copy.empty());
+    moved.clear();
+    REQUIRE(moved.empty());
+    moved.push_front(1);
+    REQUIRE(moved.front() == 1);
+  }
+
+}
+
+
+TEST_CASE("Gap vector") {
+
+  SECTION("Edits at a moving cursor") {
+    ctl::GapVector<int> v = { 1, 2, 3, 4, 5 };
+    v.insert(v.begin() + 2, 10);
+    v.insert(v.begin() + 3, 11);
+    REQUIRE(v.gap_position() == 4);
+    v.erase(v.begin() + 3);
+    v.insert(v.begin(), 0);
+    v.push_back(6);
+    int expected[] = { 0, 1, 2, 10, 3, 4, 5, 6 };
+    REQUIRE(v.size() == 8);
+    REQUIRE(std::equal(v.begin(), v.end(), expected));
+    REQUIRE(v.front() == 0);
+    REQUIRE(v.back() == 6);
+    REQUIRE_THROWS_AS(v.at(8), std::out_of_range);
+  }
+
+  SECTION("Iteration skips the gap") {
+    ctl::GapVector<int> v;
+    for (int i = 0; i < 100; ++i) {
+      v.push_back(99 - i);
+    }
+    v.move_gap(37);
+    REQUIRE(v.gap_position() == 37);
+    REQUIRE(v.end() - v.begin() == 100);
+    std::sort(v.begin(), v.end());
+    for (int i = 0; i < 100; ++i) {
+      REQUIRE(v[i] == i);
+    }
+    v.erase(v.begin() + 10, v.begin() + 90);
+    REQUIRE(v.size() == 20);
+    REQUIRE(v[10] == 90);
+    REQUIRE(std::accumulate(v.cbegin(), v.cend(), 0) == 45 + 945);
+  }
+
+  SECTION("Non-trivial elements") {
+    ctl::GapVector<std::string> v(3, "abc");
+    v.insert(v.begin() + 1, "x");
+    v.move_gap(0);
+    v.move_gap(4);
+    v.pop_back();
+    ctl::GapVector<std::string> copy(v);
+    REQUIRE(copy.size() == 3);
+    REQUIRE(copy[1] == "x");
+    REQUIRE(copy[2] == "abc");
+    ctl::GapVector<std::string> moved(std::move(copy));
+    REQUIRE(moved.size() == 3);
+    REQUIRE(copy.empty());
+  }
+
+  SECTION("Full buffer with non-trivial elements") {
+    ctl::GapVector<std::string> v;
+    v.reserve(8);
+    for (std::size_t i = 0; v.size() < v.capacity(); ++i) {
+      v.push_back("element number " + std::to_string(i));
+    }
+    const std::size_t full = v.size();
+    v.erase(v.begin());
+    REQUIRE(v.size() == full - 1);
+    REQUIRE(v[0] == "element number 1");
+
+    v.insert(v.begin() + v.size(), "tail, long enough to allocate");
+    REQUIRE(v.size() == v.capacity());
+    v.insert(v.begin() + 3, "middle, long enough to allocate");
+    REQUIRE(v[3] == "middle, long enough to allocate");
+    REQUIRE(v[v.size() - 1] == "tail, long enough to allocate");
+
+    while (v.size() < v.capacity()) {
+      v.push_back("filler, long enough to allocate");
+    }
+    v.move_gap(0);
+    v.move_gap(v.size());
+    REQUIRE(v[0] == "element number 1");
+    REQUIRE(v[3] == "middle, long enough to allocate");
+  }
+
+}
+
+
+TEST_CASE("Struct-of-arrays vector") {
+
+  using Records = ctl::SoaVector<int, double, std::string>;
+
+  SECTION("Fields live in separate arrays") {
+    Records v;
+    for (int i = 0; i < 50; ++i) {
+      v.push_back(i, i * 0.5, std::to_string(i));
+    }
+    REQUIRE(v.size() == 50);
+    REQUIRE(v.capacity() >= 50);
+    const int* ids = v.data<0>();
+    const double* prices = v.data<1>();
+    for (int i = 0; i < 50; ++i) {
+      REQUIRE(ids[i] == i);
+      REQUIRE(prices[i] == i * 0.5);
+    }
+    REQUIRE(v[7].get<2>() == "7");
+    REQUIRE(v.back() == std::make_tuple(49, 24.5, std::string("49")));
+    REQUIRE_THROWS_AS(v.at(50), std::out_of_range);
+  }
+
+  SECTION("Proxy references write through") {
+    Records v = { std::make_tuple(1, 1.0, "a"), std::make_tuple(2, 2.0, "b") };
+    v[0].get<1>() = 3.0;
+    v[1] = std::make_tuple(5, 5.0, std::string("e"));
+    Records::value_type first = v[0];
+    REQUIRE(std::get<1>(first) == 3.0);
+    REQUIRE(v.data<0>()[1] == 5);
+    REQUIRE(v.data<2>()[1] == "e");
+
+    int sum = 0;
+    for (auto it = v.begin(); it != v.end(); ++it) {
+      sum += (*it).get<0>();
+    }
+    REQUIRE(sum == 6);
+  }
+
+  SECTION("Insert and erase move every field") {
+    Records v;
+    for (int i = 0; i < 5; ++i) {
+      v.push_back(i, i, std::to_string(i));
+    }
+    v.insert(v.begin() + 2, 10, 10.0, "x");
+    v.erase(v.begin());
+    int ids[] = { 1, 10, 2, 3, 4 };
+    REQUIRE(v.size() == 5);
+    REQUIRE(std::equal(v.data<0>(), v.data<0>() + v.size(), ids));
+    REQUIRE(v.data<2>()[1] == "x");
+    v.erase(v.begin() + 1, v.begin() + 4);
+    REQUIRE(v.size() == 2);
+    REQUIRE(v[1] == std::make_tuple(4, 4.0, std::string("4")));
+
+    Records copy(v);
+    v.clear();
+    REQUIRE(v.empty());
+    REQUIRE(copy.size() == 2);
+    copy.pop_back();
+    copy.shrink_to_fit();
+    REQUIRE(copy.capacity() == 1);
+    REQUIRE(copy.front().get<2>() == "1");
+  }
+
+}
+
+
+TEST_CASE("Packed Vector<bool>") {
+
+  SECTION("Proxy access and growth") {
+    ctl::Vector<bool> v;
+    std::vector<bool> model;
+    for (int i = 0; i < 300; ++i) {
+      v.push_back(i % 3 == 0);
+      model.push_back(i % 3 == 0);
+    }
+    REQUIRE(v.size() == 300);
+    REQUIRE(v.word_count() == 5);
+    REQUIRE(std::equal(v.begin(), v.end(), model.begin()));
+    v[1] = true;
+    v[0].flip();
+    REQUIRE(v[1]);
+    REQUIRE_FALSE(v[0]);
+    REQUIRE(v.front() == false);
+    REQUIRE(v.back() == false);
+    REQUIRE_THROWS_AS(v.at(300), std::out_of_range);
+    v.pop_back();
+    v.pop_back();
+    REQUIRE(v.size() == 298);
+    REQUIRE(v.back() == true);
+    REQUIRE(v.count() == 100);
+  }
+
+  SECTION("Word-level queries") {
+    ctl::Vector<bool> v(200);
+    REQUIRE(v.count() == 0);
+    REQUIRE(v.find_first() == 200);
+    v[5] = v[64] = v[130] = v[199] = true;
+    REQUIRE(v.count() == 4);
+    REQUIRE(v.find_first() == 5);
+    REQUIRE(v.find_next(5) == 64);
+    REQUIRE(v.find_next(64) == 130);
+    REQUIRE(v.find_next(130) == 199);
+    REQUIRE(v.find_next(199) == 200);
+    v.flip();
+    REQUIRE(v.count() == 196);
+    v.resize(70, true);
+    REQUIRE(v.count() == 68);
+    v.resize(130, true);
+    REQUIRE(v.count() == 128);
+  }
+
+  SECTION("Bitwise operators") {
+    ctl::Vector<bool> a(100, false), b(100, false);
+    for (int i = 0; i < 100; i += 2) a[i] = true;
+    for (int i = 0; i < 100; i += 3) b[i] = true;
+    REQUIRE((a & b).count() == 17);
+    REQUIRE((a | b).count() == 67);
+    REQUIRE((a ^ b).count() == 50);
+    ctl::Vector<bool> c(99);
+    REQUIRE_THROWS_AS(a &= c, std::invalid_argument);
+
+    ctl::Vector<bool> temporary(a);
+    const auto* words = temporary.data();
+    ctl::Vector<bool> result = std::move(temporary) | b;
+    REQUIRE(result.data() == words);
+    REQUIRE(result.count() == 67);
+  }
+
+  SECTION("Insert and erase shift bits across words") {
+    ctl::Vector<bool> v;
+    std::vector<bool> model;
+    for (int i = 0; i < 200; ++i) {
+      v.push_back(i % 7 < 3);
+      model.push_back(i % 7 < 3);
+    }
+    v.insert(v.begin() + 10, true);
+    model.insert(model.begin() + 10, true);
+    v.insert(v.begin() + 63, false);
+    model.insert(model.begin() + 63, false);
+    v.erase(v.begin() + 5, v.begin() + 140);
+    model.erase(model.begin() + 5, model.begin() + 140);
+    v.erase(v.begin());
+    model.erase(model.begin());
+    REQUIRE(v.size() == model.size());
+    REQUIRE(std::equal(v.begin(), v.end(), model.begin()));
+    REQUIRE(v.count() == static_cast<size_t>(std::count(model.begin(), model.end(), true)));
+
+    ctl::Vector<bool> copy(v);
+    REQUIRE(std::equal(copy.cbegin(), copy.cend(), model.begin()));
+  }
+
+}
+
+
+TEST_CASE("Flat map and set") {
+
+  SECTION("Bulk construction sorts and drops duplicates") {
+    ctl::FlatSet<int> s = { 5, 3, 9, 3, 1, 5, 7 };
+    int expected[] = { 1, 3, 5, 7, 9 };
+    REQUIRE(s.size() == 5);
+    REQUIRE(std::equal(s.begin(), s.end(), expected));
+    REQUIRE(s.contains(7));
+    REQUIRE_FALSE(s.contains(4));
+    REQUIRE(*s.lower_bound(4) == 5);
+    REQUIRE(*s.upper_bound(5) == 7);
+    REQUIRE(s.lower_bound(10) == s.end());
+  }
+
+  SECTION("Map lookup, insert and erase") {
+    ctl::FlatMap<int, std::string> m = { { 2, "two" }, { 1, "one" }, { 2, "deux" } };
+    REQUIRE(m.size() == 2);
+    REQUIRE(m.at(2) == "two");
+    REQUIRE_THROWS_AS(m.at(3), std::out_of_range);
+
+    auto res = m.insert(std::make_pair(3, std::string("three")));
+    REQUIRE(res.second);
+    REQUIRE(res.first->first == 3);
+    REQUIRE_FALSE(m.insert(std::make_pair(1, std::string("uno"))).second);
+    REQUIRE(m[1] == "one");
+    m[0] = "zero";
+    REQUIRE(m.begin()->second == "zero");
+    REQUIRE(m.count(0) == 1);
+
+    REQUIRE(m.erase(2) == 1);
+    REQUIRE(m.erase(2) == 0);
+    REQUIRE(m.find(2) == m.end());
+    REQUIRE(m.size() == 3);
+  }
+
+  SECTION("Batched insert merges and keeps existing values") {
+    ctl::FlatMap<int, int> m = { { 1, 10 }, { 5, 50 }, { 9, 90 } };
+    std::vector< std::pair<int, int> > batch = { { 7, 70 }, { 5, 0 }, { 3, 30 }, { 7, 0 }, { 11, 110 } };
+    m.insert(batch.begin(), batch.end());
+    int keys[] = { 1, 3, 5, 7, 9, 11 };
+    REQUIRE(m.size() == 6);
+    for (size_t i = 0; i < m.size(); ++i) {
+      REQUIRE((m.begin() + i)->first == keys[i]);
+      REQUIRE((m.begin() + i)->second == keys[i] * 10);
+    }
+  }
+
+  SECTION("Eytzinger layout finds the same bounds") {
+    ctl::FlatSet<int> sorted;
+    ctl::FlatSet<int, std::less<int>, ctl::Allocator<int>, ctl::FlatLayout::Eytzinger> tree;
+    for (int i = 0; i < 1000; ++i) {
+      int key = static_cast<int>((i * 2654435761u) % 4000);
+      sorted.insert(key);
+      tree.insert(key);
+    }
+    REQUIRE(sorted.size() == tree.size());
+    REQUIRE(std::equal(sorted.begin(), sorted.end(), tree.begin()));
+    for (int key = -1; key <= 4001; ++key) {
+      REQUIRE(sorted.lower_bound(key) - sorted.begin() == tree.lower_bound(key) - tree.begin());
+      REQUIRE(sorted.contains(key) == tree.contains(key));
+    }
+    tree.erase(tree.begin(), tree.begin() + 500);
+    REQUIRE(tree.size() == sorted.size() - 500);
+    REQUIRE(tree.find(*(sorted.begin() + 500)) == tree.begin());
+    REQUIRE_FALSE(tree.contains(*sorted.begin()));
+  }
+
+}
+
+TEST_CASE("Hash map") {
+
+  SECTION("Insert, find and grow") {
+    ctl::HashMap<int, int> m;
+    REQUIRE(m.empty());
+    REQUIRE(m.find(1) == m.end());
+    for (int i = 0; i < 10000; ++i) {
+      REQUIRE(m.insert(std::make_pair(i * 7, i)).second);
+    }
+    REQUIRE(m.size() == 10000);
+    REQUIRE(m.load_factor() <= 0.875f);
+    REQUIRE((m.capacity() & (m.capacity() - 1)) == 0);
+    for (int i = 0; i < 10000; ++i) {
+      REQUIRE(m.find(i * 7)->second == i);
+      REQUIRE_FALSE(m.contains(i * 7 + 1));
+    }
+    REQUIRE_FALSE(m.insert(std::make_pair(7, 0)).second);
+    REQUIRE(m.at(7) == 1);
+    REQUIRE_THROWS_AS(m.at(8), std::out_of_range);
+  }
+
+  SECTION("Erase leaves findable neighbours and reuses tombstones") {
+    ctl::HashMap<int, std::string> m;
+    for (int i = 0; i < 1000; ++i) {
+      m[i] = std::to_string(i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+      REQUIRE(m.erase(i) == 1);
+    }
+    REQUIRE(m.erase(0) == 0);
+    REQUIRE(m.size() == 500);
+    for (int i = 1; i < 1000; i += 2) {
+      REQUIRE(m.at(i) == std::to_string(i));
+    }
+
+    auto capacity = m.capacity();
+    for (int round = 0; round < 20; ++round) {
+      for (int i = 0; i < 1000; i += 2) m[i] = "x";
+      for (int i = 0; i < 1000; i += 2) m.erase(i);
+    }
+    REQUIRE(m.size() == 500);
+    REQUIRE(m.capacity() == capacity);
+  }
+
+  SECTION("Iteration visits every element once") {
+    ctl::HashMap<int, int> m = { { 1, 10 }, { 2, 20 }, { 3, 30 }, { 2, 0 } };
+    REQUIRE(m.size() == 3);
+    int keys = 0, values = 0;
+    for (auto it = m.begin(); it != m.end(); ++it) {
+      keys += it->first;
+      values += it->second;
+    }
+    REQUIRE(keys == 6);
+    REQUIRE(values == 60);
+
+    for (auto it = m.begin(); it != m.end();) {
+      it = it->first == 2 ? m.erase(it) : std::next(it);
+    }
+    REQUIRE(m.size() == 2);
+    REQUIRE_FALSE(m.contains(2));
+
+    using Map = ctl::HashMap<int, int>;
+    Map::const_iterator first = m.begin();
+    REQUIRE(first->first == m.begin()->first);
+    REQUIRE(std::is_trivially_copy_assignable<Map::iterator>::value);
+    REQUIRE_FALSE(std::is_convertible<Map::const_iterator, Map::iterator>::value);
+  }
+
+  SECTION("Copy, move and clear") {
+    ctl::HashMap<std::string, int> m;
+    for (int i = 0; i < 100; ++i) m[std::to_string(i)] = i;
+    ctl::HashMap<std::string, int> copy(m);
+    m.clear();
+    REQUIRE(m.empty());
+    REQUIRE(m.find("5") == m.end());
+    REQUIRE(copy.size() == 100);
+    REQUIRE(copy.at("42") == 42);
+
+    ctl::HashMap<std::string, int> moved(std::move(copy));
+    REQUIRE(copy.empty());
+    REQUIRE(moved.at("99") == 99);
+    m = moved;
+    REQUIRE(m.size() == 100);
+  }
+
+  SECTION("Stateful hasher and comparator") {
+    struct ModHash
+    {
+      int mod;
+      std::size_t operator()(int key) const { return std::hash<int>()(key % mod); }
+    };
+    struct ModEqual
+    {
+      int mod;
+      bool operator()(int a, int b) const { return a % mod == b % mod; }
+    };
+
+    using Map = ctl::HashMap<int, int, ModHash, ModEqual>;
+    Map m(0, ModHash{ 1000 }, ModEqual{ 1000 });
+    for (int i = 0; i < 5000; ++i) {
+      m[i] += 1;
+    }
+    REQUIRE(m.size() == 1000);
+    REQUIRE(m.at(1042) == 5);
+    REQUIRE(m.hash_function().mod == 1000);
+    REQUIRE(m.key_eq().mod == 1000);
+
+    Map copy(m);
+    REQUIRE(copy.contains(4999));
+    Map other({ { 1, 1 } }, 0, ModHash{ 10 }, ModEqual{ 10 });
+    other.swap(copy);
+    REQUIRE(other.key_eq().mod == 1000);
+    REQUIRE(copy.contains(11));
+    REQUIRE_FALSE(copy.contains(1002));
+
+    REQUIRE(sizeof(ctl::HashMap<int, int>) < sizeof(Map));
+  }
+
+}
+
+TEST_CASE("Packed integer vector") {
+
+  SECTION("Values round-trip at every bit width") {
+    for (unsigned bits = 1; bits <= 64; ++bits) {
+      ctl::PackedIntVector<std::uint64_t> v(bits);
+      const std::uint64_t mask = ~std::uint64_t(0) >> (64 - bits);
+      for (std::uint64_t i = 0; i < 200; ++i) {
+        v.push_back((i * 0x9E3779B97F4A7C15ull) & mask);
+      }
+      REQUIRE(v.size() == 200);
+      REQUIRE(v.word_count() == (200 * bits + 63) / 64);
+      for (std::uint64_t i = 0; i < 200; ++i) {
+        REQUIRE(v[i] == ((i * 0x9E3779B97F4A7C15ull) & mask));
+      }
+    }
+  }
+
+  SECTION("Proxy writes and range checks") {
+    ctl::PackedIntVector<std::uint32_t> v(5, { 1, 2, 3, 31 });
+    REQUIRE(v.max_value() == 31);
+    v[1] = 17;
+    v.back() = v.front();
+    REQUIRE(v[1] == 17);
+    REQUIRE(v[3] == 1);
+    REQUIRE(v[2] == 3);
+    REQUIRE_THROWS_AS(v.push_back(32), std::out_of_range);
+    REQUIRE_THROWS_AS(v.at(4), std::out_of_range);
+    REQUIRE_THROWS_AS(ctl::PackedIntVector<std::uint32_t>(33), std::invalid_argument);
+
+    std::sort(v.begin(), v.end());
+    std::uint32_t expected[] = { 1, 1, 3, 17 };
+    REQUIRE(std::equal(v.cbegin(), v.cend(), expected));
+
+    v.pop_back();
+    v.resize(6, 9);
+    REQUIRE(v.size() == 6);
+    REQUIRE(v[5] == 9);
+    REQUIRE(v[2] == 3);
+  }
+
+  SECTION("Block assign and decode match element access") {
+    std::vector<std::uint32_t> values;
+    for (std::uint32_t i = 0; i < 1000; ++i) {
+      values.push_back(1000000 + (i * 7919) % 4096);
+    }
+    auto v = ctl::PackedIntVector<std::uint32_t>::compress(values.begin(), values.end());
+    REQUIRE(v.base() == 1000000);
+    REQUIRE(v.bit_width() == 12);
+    REQUIRE(v.size() == values.size());
+    REQUIRE(std::equal(v.cbegin(), v.cend(), values.begin()));
+
+    std::vector<std::uint32_t> out(values.size());
+    v.decode(0, v.size(), out.data());
+    REQUIRE(out == values);
+    std::vector<std::uint32_t> part(300);
+    v.decode(37, 300, part.data());
+    REQUIRE(std::equal(part.begin(), part.end(), values.begin() + 37));
+    REQUIRE_THROWS_AS(v.decode(900, 101, part.data()), std::out_of_range);
+  }
+
+}
+
+TEST_CASE("Copy-on-write vector") {
+
+  SECTION("Copies share until the first mutation") {
+    ctl::CowVector<std::string> a = { "a", "b", "c" };
+    ctl::CowVector<std::string> b(a);
+    const ctl::CowVector<std::string>& reader = b;
+    REQUIRE(a.use_count() == 2);
+    REQUIRE(static_cast<const ctl::CowVector<std::string>&>(a).data() == reader.data());
+    REQUIRE(reader[1] == "b");
+    REQUIRE(reader.at(2) == "c");
+    REQUIRE(a.use_count() == 2);
+
+    b[1] = "x";
+    REQUIRE(a.use_count() == 1);
+    REQUIRE(b.use_count() == 1);
+    REQUIRE(static_cast<const ctl::CowVector<std::string>&>(a)[1] == "b");
+    REQUIRE(reader[1] == "x");
+
+    b.push_back("d");
+    REQUIRE(b.size() == 4);
+    REQUIRE(a.size() == 3);
+  }
+
+  SECTION("Mutators detach or drop the shared buffer") {
+    ctl::CowVector<int> a = { 1, 2, 3, 4, 5 };
+    ctl::CowVector<int> b = a;
+    b.erase(b.begin() + 1, b.begin() + 3);
+    REQUIRE(b.size() == 3);
+    REQUIRE(b[1] == 4);
+    REQUIRE(a.size() == 5);
+
+    ctl::CowVector<int> c = a;
+    c.assign(2, 7);
+    REQUIRE(a.use_count() == 1);
+    REQUIRE(std::equal(c.cbegin(), c.cend(), std::vector<int>{ 7, 7 }.begin()));
+
+    c = a;
+    c.clear();
+    REQUIRE(c.empty());
+    REQUIRE(c.use_count() == 0);
+    REQUIRE(a.size() == 5);
+    REQUIRE_THROWS_AS(c.at(0), std::out_of_range);
+  }
+
+  SECTION("Adopting a vector does not copy it") {
+    ctl::Vector<int> v = { 1, 2, 3 };
+    int* raw = v.data();
+    ctl::CowVector<int> c(std::move(v));
+    REQUIRE(v.empty());
+    REQUIRE(static_cast<const ctl::CowVector<int>&>(c).data() == raw);
+  }
+
+  SECTION("Snapshots are taken and dropped across threads") {
+    ctl::CowVector<int> source(1000, 1);
+    std::vector<std::thread> readers;
+    std::atomic<long> total{0};
+    for (int t = 0; t < 4; ++t) {
+      readers.emplace_back([&source, &total]() {
+        for (int k = 0; k < 1000; ++k) {
+          const ctl::CowVector<int> snapshot(source);
+          total += snapshot[k];
+        }
+      });
+    }
+    for (auto& reader : readers) reader.join();
+    REQUIRE(total == 4000);
+    REQUIRE(source.use_count() == 1);
+  }
+
+}
+
+TEST_CASE("Persistent vector") {
+
+  SECTION("Versions are unaffected by later edits") {
+    ctl::PersistentVector<int> empty;
+    std::vector< ctl::PersistentVector<int> > versions = { empty };
+    for (int i = 0; i < 2000; ++i) {
+      versions.push_back(versions.back().push_back(i));
+    }
+    REQUIRE(empty.empty());
+    for (size_t n = 0; n < versions.size(); n += 97) {
+      REQUIRE(versions[n].size() == n);
+      for (size_t i = 0; i < n; ++i) {
+        REQUIRE(versions[n][i] == static_cast<int>(i));
+      }
+    }
+
+    auto edited = versions.back().set(1500, -1).set(3, -3);
+    REQUIRE(edited[1500] == -1);
+    REQUIRE(edited[3] == -3);
+    REQUIRE(versions.back()[1500] == 1500);
+    REQUIRE(versions.back()[3] == 3);
+    REQUIRE_THROWS_AS(edited.set(2000, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(edited.at(2000), std::out_of_range);
+  }
+
+  SECTION("pop_back walks back through every tree shape") {
+    ctl::PersistentVector<std::string> v;
+    for (int i = 0; i < 1100; ++i) {
+      v = v.push_back(std::to_string(i));
+    }
+    const auto full = v;
+    while (!v.empty()) {
+      v = v.pop_back();
+      if (!v.empty()) {
+        REQUIRE(v.back() == std::to_string(v.size() - 1));
+      }
+    }
+    REQUIRE_THROWS_AS(v.pop_back(), std::out_of_range);
+    REQUIRE(full.size() == 1100);
+    REQUIRE(full[1099] == "1099");
+    REQUIRE(full.front() == "0");
+  }
+
+  SECTION("Transient batch edits and conversions") {
+    ctl::Vector<int> source;
+    for (int i = 0; i < 5000; ++i) source.push_back(i);
+    const ctl::PersistentVector<int> base(source);
+    REQUIRE(base.size() == 5000);
+    REQUIRE(std::equal(base.begin(), base.end(), source.begin()));
+
+    auto batch = base.transient();
+    for (size_t i = 0; i < batch.size(); i += 2) {
+      batch.set(i, -static_cast<int>(i));
+    }
+    batch.pop_back();
+    batch.push_back(7);
+    auto next = batch.persistent();
+    REQUIRE(batch.empty());
+    REQUIRE(next[4998] == -4998);
+    REQUIRE(next[4999] == 7);
+    REQUIRE(base[4998] == 4998);
+    REQUIRE(base[4999] == 4999);
+
+    ctl::Vector<int> back = next.to_vector();
+    REQUIRE(back.size() == 5000);
+    REQUIRE(std::equal(next.cbegin(), next.cend(), back.begin()));
+  }
+
+}
+
+TEST_CASE("Vector builder") {
+
+  SECTION("Chunk table comes from the builder's allocator") {
+    ctl::VectorBuilder<int, LimitedAllocator<int>, 64> builder;
+    allocationsLeft = 1;
+    REQUIRE_THROWS_AS(builder.push_back(1), std::bad_alloc);
+    allocationsLeft = -1;
+    REQUIRE(builder.empty());
+    REQUIRE(builder.chunk_count() == 0);
+    builder.push_back(1);
+    REQUIRE(builder.chunk_count() == 1);
+  }
+
+  SECTION("Single chunk is adopted without copying") {
+    ctl::VectorBuilder<std::string> builder;
+    builder.push_back("a");
+    builder.emplace_back(3, 'b');
+    const std::string* first = &builder[0];
+    REQUIRE(builder.chunk_count() == 1);
+
+    ctl::Vector<std::string> v = builder.finish();
+    REQUIRE(builder.empty());
+    REQUIRE(builder.chunk_count() == 0);
+    REQUIRE(v.size() == 2);
+    REQUIRE(&v[0] == first);
+    REQUIRE(v[1] == "bbb");
+    REQUIRE(v.capacity() == decltype(builder)::chunk_size);
+    v.push_back("c");
+    REQUIRE(v.back() == "c");
+  }
+
+  SECTION("Many chunks are moved into one exact buffer") {
+    ctl::VectorBuilder<int, ctl::Allocator<int>, 64> builder;
+    std::vector<int> input(1000);
+    std::iota(input.begin(), input.end(), 0);
+    builder.append(input.begin(), input.end());
+    REQUIRE(builder.size() == 1000);
+    REQUIRE(builder.chunk_count() == 16);
+    REQUIRE(builder.back() == 999);
+
+    ctl::Vector<int> v = builder.finish();
+    REQUIRE(v.size() == 1000);
+    REQUIRE(v.capacity() == 1000);
+    REQUIRE(std::equal(v.begin(), v.end(), input.begin()));
+    REQUIRE(builder.empty());
+
+    builder.push_back(5);
+    REQUIRE(builder.finish().front() == 5);
+    REQUIRE(builder.finish().empty());
+  }
+
+}
+
+TEST_CASE("Slot map") {
+
+  SECTION("Keys find their values") {
+    ctl::SlotMap<std::string> map;
+    REQUIRE(map.empty());
+    auto a = map.insert("a");
+    auto b = map.emplace(3, 'b');
+    REQUIRE(map.size() == 2);
+    REQUIRE(a != b);
+    REQUIRE(map[a] == "a");
+    REQUIRE(map.at(b) == "bbb");
+    REQUIRE(*map.find(b) == "bbb");
+    REQUIRE(map.key_at(1) == b);
+    map[a] = "aa";
+    REQUIRE(map.at(a) == "aa");
+  }
+
+  SECTION("Erase compacts and stales the key") {
+    ctl::SlotMap<int> map;
+    std::vector<ctl::SlotMap<int>::Key> keys;
+    for (int i = 0; i < 10; ++i) {
+      keys.push_back(map.insert(i));
+    }
+    REQUIRE(map.erase(keys[2]));
+    REQUIRE_FALSE(map.erase(keys[2]));
+    REQUIRE(map.size() == 9);
+    REQUIRE_FALSE(map.contains(keys[2]));
+    REQUIRE(map.find(keys[2]) == nullptr);
+    REQUIRE_THROWS_AS(map.at(keys[2]), std::out_of_range);
+    REQUIRE(*(map.begin() + 2) == 9);
+    REQUIRE(map.at(keys[9]) == 9);
+
+    auto reused = map.insert(42);
+    REQUIRE(reused.index == keys[2].index);
+    REQUIRE(reused != keys[2]);
+    REQUIRE_FALSE(map.contains(keys[2]));
+    REQUIRE(map[reused] == 42);
+
+    int sum = 0;
+    for (auto it = map.begin(); it != map.end(); ++it) {
+      sum += *it;
+    }
+    REQUIRE(sum == 45 - 2 + 42);
+    for (std::size_t i = 0; i < map.size(); ++i) {
+      REQUIRE(&map[map.key_at(i)] == map.data() + i);
+    }
+  }
+
+  SECTION("Free slots reject keys with the bumped generation") {
+    using Key = ctl::SlotMap<int>::Key;
+    ctl::SlotMap<int> map;
+    Key first = map.insert(1);
+    Key second = map.insert(2);
+    map.erase(first);
+    map.erase(second);
+    REQUIRE(map.empty());
+    REQUIRE_FALSE(map.contains(Key{ first.index, first.generation + 1 }));
+    REQUIRE_FALSE(map.contains(Key{ second.index, second.generation + 1 }));
+    REQUIRE(map.find(Key{ first.index, first.generation + 1 }) == nullptr);
+    REQUIRE_THROWS_AS(map.at(Key{ second.index, second.generation + 1 }), std::out_of_range);
+    REQUIRE_FALSE(map.erase(Key{ first.index, first.generation + 1 }));
+
+    ctl::SlotMap<int> other;
+    other.erase(other.insert(7));
+    Key foreign = other.insert(8);
+    ctl::SlotMap<int> live;
+    Key dropped = live.insert(3);
+    live.insert(4);
+    live.erase(dropped);
+    REQUIRE(foreign == (Key{ dropped.index, dropped.generation + 1 }));
+    REQUIRE_FALSE(live.contains(foreign));
+  }
+
+  SECTION("Random churn matches a reference") {
+    ctl::SlotMap<int> map;
+    std::vector<std::pair<ctl::SlotMap<int>::Key, int>> live;
+    std::vector<ctl::SlotMap<int>::Key> dead;
+    unsigned seed = 7;
+    for (int step = 0; step < 5000; ++step) {
+      seed = seed * 1103515245u + 12345u;
+      if (live.empty() || (seed >> 16) % 3 != 0) {
+        live.emplace_back(map.insert(step), step);
+      } else {
+        const std::size_t victim = (seed >> 8) % live.size();
+        REQUIRE(map.erase(live[victim].first));
+        dead.push_back(live[victim].first);
+        live[victim] = live.back();
+        live.pop_back();
+      }
+    }
+    REQUIRE(map.size() == live.size());
+    for (const auto& entry : live) {
+      REQUIRE(map.at(entry.first) == entry.second);
+    }
+    for (const auto& key : dead) {
+      REQUIRE_FALSE(map.contains(key));
+    }
+  }
+
+  SECTION("Clear stales every key") {
+    ctl::SlotMap<int> map;
+    auto a = map.insert(1);
+    auto b = map.insert(2);
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE_FALSE(map.contains(a));
+    REQUIRE_FALSE(map.contains(b));
+    auto c = map.insert(3);
+    REQUIRE(map.size() == 1);
+    REQUIRE(map[c] == 3);
+    REQUIRE_FALSE(map.contains(a));
+    REQUIRE_FALSE(map.contains(b));
+  }
+
+}
+
+TEST_CASE("Circular vector") {
+
+  SECTION("Queue use wraps without growing") {
+    ctl::CircularVector<int> ring;
+    ring.reserve(5);
+    REQUIRE(ring.capacity() == 8);
+    for (int i = 0; i < 100; ++i) {
+      ring.push_back(i);
+      if (ring.size() > 6) ring.pop_front();
+    }
+    REQUIRE(ring.capacity() == 8);
+    REQUIRE(ring.size() == 6);
+    REQUIRE(ring.front() == 94);
+    REQUIRE(ring.back() == 99);
+    REQUIRE(ring[2] == 96);
+    REQUIRE_THROWS_AS(ring.at(6), std::out_of_range);
+    REQUIRE(std::accumulate(ring.begin(), ring.end(), 0) == 94 + 95 + 96 + 97 + 98 + 99);
+  }
+
+  SECTION("Both ends and growth keep order") {
+    ctl::CircularVector<std::string> ring;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 50; ++i) {
+      ring.push_back(std::to_string(i));
+      ring.push_front(std::to_string(-i));
+      expected.push_back(std::to_string(i));
+      expected.insert(expected.begin(), std::to_string(-i));
+    }
+    ring.pop_back();
+    ring.pop_front();
+    expected.pop_back();
+    expected.erase(expected.begin());
+    REQUIRE(ring.size() == expected.size());
+    REQUIRE(std::equal(ring.begin(), ring.end(), expected.begin()));
+
+    ctl::CircularVector<std::string> copy(ring);
+    REQUIRE(std::equal(copy.cbegin(), copy.cend(), expected.begin()));
+  }
+
+  SECTION("Overwrite mode keeps the latest window") {
+    ctl::CircularVector<int> ring;
+    ring.reserve(4);
+    ring.set_overwrite(true);
+    for (int i = 0; i < 10; ++i) {
+      ring.push_back(i);
+    }
+    REQUIRE(ring.capacity() == 4);
+    REQUIRE(ring.full());
+    REQUIRE(std::equal(ring.begin(), ring.end(), std::vector<int>{ 6, 7, 8, 9 }.begin()));
+    ring.push_front(42);
+    REQUIRE(std::equal(ring.begin(), ring.end(), std::vector<int>{ 42, 6, 7, 8 }.begin()));
+  }
+
+  SECTION("Copies keep the overwrite window") {
+    ctl::CircularVector<int> ring;
+    ring.reserve(8);
+    ring.set_overwrite(true);
+    for (int i = 0; i < 3; ++i) {
+      ring.push_back(i);
+    }
+    ctl::CircularVector<int> copy(ring);
+    ctl::CircularVector<int> assigned;
+    assigned = ring;
+    REQUIRE(copy.capacity() == 8);
+    REQUIRE(assigned.capacity() == 8);
+    for (int i = 3; i < 10; ++i) {
+      ring.push_back(i);
+      copy.push_back(i);
+      assigned.push_back(i);
+    }
+    REQUIRE(copy.size() == ring.size());
+    REQUIRE(std::equal(copy.begin(), copy.end(), ring.begin()));
+    REQUIRE(std::equal(assigned.begin(), assigned.end(), ring.begin()));
+  }
+
+  SECTION("Linearize in place") {
+    for (int count = 1; count <= 8; ++count) {
+      ctl::CircularVector<std::string> ring;
+      ring.reserve(8);
+      for (int i = 0; i < 5; ++i) {
+        ring.push_back("x");
+        ring.pop_front();
+      }
+      for (int i = 0; i < count; ++i) {
+        ring.push_back(std::to_string(i));
+      }
+      REQUIRE(ring.is_contiguous() == (count <= 3));
+      std::string* data = ring.as_contiguous();
+      REQUIRE(ring.is_contiguous());
+      REQUIRE(ring.capacity() == 8);
+      for (int i = 0; i < count; ++i) {
+        REQUIRE(data[i] == std::to_string(i));
+        REQUIRE(ring[i] == std::to_string(i));
+      }
+      ring.push_back("end");
+      REQUIRE(ring.back() == "end");
+    }
+  }
+
+}
+
+TEST_CASE("Bounded queues") {
+
+  SECTION("SPSC batches swap vector buffers") {
+    ctl::SpscQueue<ctl::Vector<int>> queue(3);
+    REQUIRE(queue.capacity() == 4);
+    REQUIRE(queue.empty());
+
+    ctl::Vector<int> batches[6];
+    const int* buffers[6];
+    for (int i = 0; i < 6; ++i) {
+      batches[i].assign(10, i);
+      buffers[i] = batches[i].data();
+    }
+    REQUIRE(queue.push_n(batches, 6) == 4);
+    REQUIRE(queue.size() == 4);
+    REQUIRE_FALSE(queue.try_push(std::move(batches[4])));
+    REQUIRE(batches[4].size() == 10);
+    REQUIRE(batches[0].empty());
+
+    ctl::Vector<int> out[3];
+    REQUIRE(queue.pop_n(out, 3) == 3);
+    for (int i = 0; i < 3; ++i) {
+      REQUIRE(out[i].data() == buffers[i]);
+      REQUIRE(out[i][9] == i);
+    }
+    REQUIRE(queue.try_push(std::move(batches[4])));
+    ctl::Vector<int> last;
+    REQUIRE(queue.try_pop(last));
+    REQUIRE(last.data() == buffers[3]);
+    REQUIRE(queue.try_pop(last));
+    REQUIRE(last.data() == buffers[4]);
+    REQUIRE_FALSE(queue.try_pop(last));
+  }
+
+  SECTION("SPSC keeps order across threads") {
+    ctl::SpscQueue<int> queue(64);
+    const int count = 100000;
+    std::thread producer([&queue, count]() {
+      int next = 0;
+      int batch[16];
+      while (next < count) {
+        const int n = std::min(16, count - next);
+        std::iota(batch, batch + n, next);
+        next += static_cast<int>(queue.push_n(batch, n));
+        std::this_thread::yield();
+      }
+    });
+    bool ordered = true;
+    for (int expected = 0; expected < count;) {
+      int value;
+      if (queue.try_pop(value)) {
+        ordered = ordered && value == expected;
+        ++expected;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    producer.join();
+    REQUIRE(ordered);
+    REQUIRE(queue.empty());
+  }
+
+  SECTION("MPMC delivers every value once") {
+    ctl::MpmcQueue<long long> queue(128);
+    REQUIRE(queue.capacity() == 128);
+    const int perProducer = 20000;
+    std::atomic<long long> sum{0};
+    std::atomic<int> received{0};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 2; ++p) {
+      threads.emplace_back([&queue, p, perProducer]() {
+        for (int i = 0; i < perProducer;) {
+          if (queue.try_push(static_cast<long long>(p) * perProducer + i)) {
+            ++i;
+          } else {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    for (int c = 0; c < 2; ++c) {
+      threads.emplace_back([&queue, &sum, &received, perProducer]() {
+        long long values[8];
+        while (received.load() < 2 * perProducer) {
+          const auto n = queue.pop_n(values, 8);
+          for (std::size_t i = 0; i < n; ++i) {
+            sum += values[i];
+          }
+          received += static_cast<int>(n);
+          if (n == 0) std::this_thread::yield();
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    const long long total = 2LL * perProducer;
+    REQUIRE(received.load() == total);
+    REQUIRE(sum.load() == total * (total - 1) / 2);
+    long long value;
+    REQUIRE_FALSE(queue.try_pop(value));
+  }
+
+}
+
+namespace {
+
+int sum_of(ctl::VectorView<int> view)
+{
+  return std::accumulate(view.begin(), view.end(), 0);
+}
+
+} // namespace
+
+TEST_CASE("Span") {
+
+  SECTION("Converts from containers without copying") {
+    ctl::Vector<int> v = { 1, 2, 3, 4, 5 };
+    const ctl::Vector<int>& cv = v;
+    std::vector<int> sv = { 1, 2, 3 };
+    int array[] = { 4, 5 };
+
+    ctl::Span<int> span = v;
+    REQUIRE(span.data() == v.data());
+    REQUIRE(span.size() == 5);
+    span[0] = 10;
+    REQUIRE(v[0] == 10);
+
+    ctl::VectorView<int> view = cv;
+    REQUIRE(view.data() == v.data());
+    REQUIRE(sum_of(v) == 24);
+    REQUIRE(sum_of(sv) == 6);
+    REQUIRE(sum_of(array) == 9);
+    REQUIRE(sum_of(span) == 24);
+    REQUIRE(sum_of(ctl::Span<int>(v.data(), v.data() + 2)) == 12);
+    REQUIRE(ctl::Span<int>(v.data(), 0).empty());
+    REQUIRE(span.size_bytes() == 5 * sizeof(int));
+  }
+
+  SECTION("Slicing") {
+    ctl::Vector<int> v = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    ctl::VectorView<int> view = v;
+    REQUIRE(view.first(3).back() == 2);
+    REQUIRE(view.last(3).front() == 7);
+    REQUIRE(view.subspan(4, 2).size() == 2);
+    REQUIRE(view.subspan(4, 2)[1] == 5);
+    REQUIRE(view.subspan(4).size() == 6);
+    REQUIRE(view.subspan(10).empty());
+    REQUIRE(view.subspan(2).first(3).data() == v.data() + 2);
+    REQUIRE_THROWS_AS(view.first(11), std::out_of_range);
+    REQUIRE_THROWS_AS(view.subspan(8, 3), std::out_of_range);
+    REQUIRE_THROWS_AS(view.at(10), std::out_of_range);
+    REQUIRE(std::is_sorted(view.begin(), view.end()));
+  }
+
+  SECTION("Strided and chunked views") {
+    ctl::Vector<int> v = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    ctl::Span<int> span = v;
+
+    auto odd = span.strided(2, 1);
+    REQUIRE(odd.size() == 5);
+    REQUIRE(std::equal(odd.begin(), odd.end(), std::vector<int>{ 1, 3, 5, 7, 9 }.begin()));
+    for (auto& x : odd) {
+      x = 0;
+    }
+    REQUIRE(std::accumulate(v.begin(), v.end(), 0) == 0 + 2 + 4 + 6 + 8);
+    REQUIRE(span.strided(3).size() == 4);
+    REQUIRE(span.strided(3, 10).empty());
+    REQUIRE_THROWS_AS(span.strided(0), std::invalid_argument);
+
+    auto batches = span.chunks(4);
+    REQUIRE(batches.size() == 3);
+    REQUIRE(batches[1].data() == v.data() + 4);
+    REQUIRE(batches[2].size() == 2);
+    std::size_t total = 0;
+    for (auto batch : batches) {
+      total += batch.size();
+    }
+    REQUIRE(total == v.size());
+    REQUIRE(ctl::Span<int>().chunks(4).empty());
+  }
+
+  SECTION("View iterators outlive the view") {
+    ctl::Vector<int> v = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    ctl::Span<int> span = v;
+
+    int sum = 0;
+    std::for_each(span.strided(2).begin(), span.strided(2).end(), [&sum](int x) { sum += x; });
+    REQUIRE(sum == 0 + 2 + 4 + 6 + 8);
+    REQUIRE(span.strided(2).end() - span.strided(2).begin() == 5);
+    REQUIRE(span.strided(2).begin() != span.strided(2, 1).begin());
+    auto column = span.strided(3, 1).begin();
+    REQUIRE(column[2] == 7);
+    REQUIRE(*std::max_element(span.strided(3, 1).begin(), span.strided(3, 1).end()) == 7);
+
+    std::size_t chunks = 0;
+    std::for_each(span.chunks(3).begin(), span.chunks(3).end(), [&chunks](ctl::Span<int> chunk) { chunks += chunk.size() > 0; });
+    REQUIRE(chunks == 4);
+    auto last = span.chunks(3).begin() + 3;
+    REQUIRE((*last).size() == 1);
+    REQUIRE((*last)[0] == 9);
+  }
+
+}
@@ -0,0 +1,571 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "numa.hpp"
+
+
+namespace ctl {
+
+/**
+ * ctl::ChaseLevDeque Definition
+ *
+ * Lock-free work-stealing deque (Chase & Lev, 2005; memory orders after
+ * Le et al., 2013). Only the owning thread may push() and pop() at the
+ * bottom; any thread may steal() from the top. The ring grows on demand
+ * and retired rings are kept until destruction, so a concurrent thief never
+ * reads freed memory.
+ */
+
+template<typename T>
+class ChaseLevDeque
+{
+public:
+  explicit ChaseLevDeque(std::size_t capacity = 64);
+  ChaseLevDeque(const ChaseLevDeque&) = delete;
+  ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+  void push(T*);
+  T* pop();
+  T* steal();
+  bool empty() const noexcept;
+
+private:
+  struct Ring
+  {
+    std::size_t mask;
+    std::unique_ptr<std::atomic<T*>[]> slots;
+
+    explicit Ring(std::size_t capacity) : mask(capacity - 1), slots(new std::atomic<T*>[capacity]) {}
+    std::size_t capacity() const noexcept { return mask + 1; }
+    T* get(std::int64_t i) const noexcept { return slots[i & mask].load(std::memory_order_relaxed); }
+    void put(std::int64_t i, T* x) noexcept { slots[i & mask].store(x, std::memory_order_relaxed); }
+  };
+
+  alignas(64) std::atomic<std::int64_t> _top{0};
+  alignas(64) std::atomic<std::int64_t> _bottom{0};
+  std::atomic<Ring*> _ring;
+  std::vector<std::unique_ptr<Ring>> _rings;
+
+  Ring* grow(Ring*, std::int64_t, std::int64_t);
+};
+
+
+namespace detail {
+
+/**
+ * Fixed array of count default-constructed T on storage aligned to
+ * alignof(T). Before C++17, new[] only guarantees alignof(max_align_t), so
+ * it would silently drop the cache-line alignment of ChaseLevDeque.
+ */
+template<typename T>
+class AlignedArray
+{
+public:
+  explicit AlignedArray(std::size_t count) : _count(count)
+  {
+    std::size_t space = count * sizeof(T) + alignof(T);
+    _storage = ::operator new(space);
+    void* aligned = _storage;
+    _items = static_cast<T*>(std::align(alignof(T), count * sizeof(T), aligned, space));
+    std::size_t i = 0;
+    try {
+      for (; i < count; ++i) {
+        ::new (static_cast<void*>(_items + i)) T();
+      }
+    } catch (...) {
+      destroy(i);
+      throw;
+    }
+  }
+  AlignedArray(const AlignedArray&) = delete;
+  AlignedArray& operator=(const AlignedArray&) = delete;
+  ~AlignedArray() { destroy(_count); }
+
+  T& operator[](std::size_t i) const noexcept { return _items[i]; }
+
+private:
+  void* _storage;
+  T* _items;
+  std::size_t _count;
+
+  void destroy(std::size_t constructed) noexcept
+  {
+    for (std::size_t i = constructed; i-- > 0;) {
+      _items[i].~T();
+    }
+    ::operator delete(_storage);
+  }
+};
+
+} // namespace detail
+
+
+/**
+ * ctl::ThreadPool Definition
+ *
+ * Fixed set of workers, each owning a ChaseLevDeque. A worker pops its own
+ * deque and, once it runs dry, drains the shared injection queue (where
+ * tasks from non-worker threads land) and then steals from its peers.
+ * Threads waiting on a TaskGroup execute pending tasks instead of sleeping,
+ * so nested parallel calls never deadlock the pool.
+ */
+
+enum class Affinity
+{
+  None,   // leave placement to the OS scheduler
+  Core,   // pin worker i to logical CPU i modulo the CPU count
+  Node    // pin worker i to NUMA node i modulo the node count
+};
+
+class TaskGroup;
+
+struct IndexRange
+{
+  std::size_t first;
+  std::size_t last;
+
+  std::size_t size() const noexcept { return last - first; }
+  bool empty() const noexcept { return first >= last; }
+};
+
+class ThreadPool
+{
+public:
+  using Task = std::function<void()>;
+
+  explicit ThreadPool(std::size_t workers = std::thread::hardware_concurrency(), Affinity affinity = Affinity::None);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool();
+
+  static bool configure(std::size_t workers, Affinity affinity = Affinity::None);
+  static ThreadPool& instance();
+
+  std::size_t size() const noexcept;
+  Affinity affinity() const noexcept;
+  void submit(Task);
+  bool run_pending();
+
+  template<typename F>
+  void parallel_for(IndexRange, std::size_t, F&&);
+
+private:
+  struct Local
+  {
+    ThreadPool* pool = nullptr;
+    std::size_t index = 0;
+  };
+
+  struct Config
+  {
+    std::size_t workers = std::thread::hardware_concurrency();
+    Affinity affinity = Affinity::None;
+    bool started = false;
+    std::mutex lock;
+  };
+
+  std::size_t _size;
+  Affinity _affinity;
+  detail::AlignedArray<ChaseLevDeque<Task>> _deques;
+  std::unique_ptr<std::thread[]> _threads;
+  std::deque<Task*> _injected;
+  std::mutex _injectLock;
+  std::atomic<std::size_t> _queued{0};
+  std::atomic<bool> _stop{false};
+  std::mutex _sleepLock;
+  std::condition_variable _wake;
+
+  static Local& local();
+  static Config& config();
+  void loop(std::size_t);
+  void pin(std::size_t);
+  bool starving() noexcept;
+  Task* take();
+
+  template<typename F>
+  void split(TaskGroup&, std::size_t, std::size_t, std::size_t, F&);
+};
+
+
+/**
+ * ctl::TaskGroup Definition
+ *
+ * Tracks a batch of tasks submitted to a pool. wait() returns once all of
+ * them have finished and rethrows the first exception any of them raised.
+ */
+
+class TaskGroup
+{
+public:
+  explicit TaskGroup(ThreadPool& pool = ThreadPool::instance());
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+  ~TaskGroup();
+
+  template<typename F>
+  void run(F&&);
+  void wait();
+
+private:
+  ThreadPool& _pool;
+  std::atomic<std::size_t> _pending{0};
+  std::mutex _errorLock;
+  std::exception_ptr _error;
+};
+
+template<typename F>
+void parallel_for(IndexRange, std::size_t, F&&);
+
+
+/**
+ * ctl::ChaseLevDeque Implementation
+ */
+
+template<typename T>
+ChaseLevDeque<T>::ChaseLevDeque(std::size_t capacity)
+{
+  std::size_t size = 1;
+  while (size < capacity) size <<= 1;
+  _rings.emplace_back(new Ring(size));
+  _ring.store(_rings.back().get(), std::memory_order_relaxed);
+}
+
+template<typename T>
+void ChaseLevDeque<T>::push(T* x)
+{
+  std::int64_t b = _bottom.load(std::memory_order_relaxed);
+  std::int64_t t = _top.load(std::memory_order_acquire);
+  Ring* ring = _ring.load(std::memory_order_relaxed);
+  if (b - t > static_cast<std::int64_t>(ring->capacity()) - 1) {
+    ring = grow(ring, t, b);
+  }
+  ring->put(b, x);
+  _bottom.store(b + 1, std::memory_order_release);
+}
+
+template<typename T>
+T* ChaseLevDeque<T>::pop()
+{
+  std::int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+  Ring* ring = _ring.load(std::memory_order_relaxed);
+  _bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  std::int64_t t = _top.load(std::memory_order_relaxed);
+
+  if (t > b) {
+    _bottom.store(b + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  T* x = ring->get(b);
+  if (t == b) {
+    if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      x = nullptr;
+    }
+    _bottom.store(b + 1, std::memory_order_relaxed);
+  }
+  return x;
+}
+
+template<typename T>
+T* ChaseLevDeque<T>::steal()
+{
+  std::int64_t t = _top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  std::int64_t b = _bottom.load(std::memory_order_acquire);
+  if (t >= b) return nullptr;
+
+  Ring* ring = _ring.load(std::memory_order_acquire);
+  T* x = ring->get(t);
+  if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return x;
+}
+
+template<typename T>
+bool ChaseLevDeque<T>::empty() const noexcept
+{
+  return _bottom.load(std::memory_order_relaxed) <= _top.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+typename ChaseLevDeque<T>::Ring* ChaseLevDeque<T>::grow(Ring* ring, std::int64_t t, std::int64_t b)
+{
+  std::unique_ptr<Ring> bigger(new Ring(ring->capacity() * 2));
+  for (std::int64_t i = t; i < b; ++i) {
+    bigger->put(i, ring->get(i));
+  }
+  _rings.push_back(std::move(bigger));
+  _ring.store(_rings.back().get(), std::memory_order_release);
+  return _rings.back().get();
+}
+
+
+/**
+ * ctl::ThreadPool Implementation
+ */
+
+inline ThreadPool::ThreadPool(std::size_t workers, Affinity affinity)
+  : _size(std::max<std::size_t>(workers, 1))
+  , _affinity(affinity)
+  , _deques(_size)
+  , _threads(new std::thread[_size])
+{
+  for (std::size_t i = 0; i < _size; ++i) {
+    _threads[i] = std::thread(&ThreadPool::loop, this, i);
+  }
+}
+
+inline ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> guard(_sleepLock);
+    _stop = true;
+  }
+  _wake.notify_all();
+  for (std::size_t i = 0; i < _size; ++i) {
+    _threads[i].join();
+  }
+}
+
+inline ThreadPool::Config& ThreadPool::config()
+{
+  static Config settings;
+  return settings;
+}
+
+inline bool ThreadPool::configure(std::size_t workers, Affinity affinity)
+{
+  Config& settings = config();
+  std::lock_guard<std::mutex> guard(settings.lock);
+  if (settings.started) return false;
+  settings.workers = workers;
+  settings.affinity = affinity;
+  return true;
+}
+
+inline ThreadPool& ThreadPool::instance()
+{
+  static std::unique_ptr<ThreadPool> pool = []() {
+    Config& settings = config();
+    std::lock_guard<std::mutex> guard(settings.lock);
+    settings.started = true;
+    return std::unique_ptr<ThreadPool>(new ThreadPool(settings.workers, settings.affinity));
+  }();
+  return *pool;
+}
+
+inline ThreadPool::Local& ThreadPool::local()
+{
+  static thread_local Local current;
+  return current;
+}
+
+inline std::size_t ThreadPool::size() const noexcept
+{
+  return _size;
+}
+
+inline Affinity ThreadPool::affinity() const noexcept
+{
+  return _affinity;
+}
+
+inline void ThreadPool::submit(Task task)
+{
+  Task* item = new Task(std::move(task));
+  Local& current = local();
+
+  _queued.fetch_add(1);
+  if (current.pool == this) {
+    _deques[current.index].push(item);
+  } else {
+    std::lock_guard<std::mutex> guard(_injectLock);
+    _injected.push_back(item);
+  }
+  {
+    std::lock_guard<std::mutex> guard(_sleepLock);
+  }
+  _wake.notify_one();
+}
+
+inline bool ThreadPool::run_pending()
+{
+  std::unique_ptr<Task> task(take());
+  if (!task) return false;
+  (*task)();
+  return true;
+}
+
+inline bool ThreadPool::starving() noexcept
+{
+  Local& current = local();
+  if (current.pool == this) {
+    return _deques[current.index].empty();
+  }
+  std::lock_guard<std::mutex> guard(_injectLock);
+  return _injected.empty();
+}
+
+inline ThreadPool::Task* ThreadPool::take()
+{
+  Local& current = local();
+  std::size_t self = current.pool == this ? current.index : 0;
+  Task* task = nullptr;
+
+  if (current.pool == this) {
+    task = _deques[self].pop();
+  }
+  if (!task) {
+    std::lock_guard<std::mutex> guard(_injectLock);
+    if (!_injected.empty()) {
+      task = _injected.front();
+      _injected.pop_front();
+    }
+  }
+  for (std::size_t i = 1; !task && i <= _size; ++i) {
+    task = _deques[(self + i) % _size].steal();
+  }
+  if (task) {
+    _queued.fetch_sub(1);
+  }
+  return task;
+}
+
+inline void ThreadPool::pin(std::size_t index)
+{
+  if (_affinity == Affinity::Node) {
+    numa::run_on_node(static_cast<int>(index % numa::node_count()));
+    return;
+  }
+#if defined(__linux__)
+  if (_affinity == Affinity::Core) {
+    std::size_t cpus = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % cpus, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+  }
+#endif
+}
+
+inline void ThreadPool::loop(std::size_t index)
+{
+  local().pool = this;
+  local().index = index;
+  pin(index);
+
+  while (true) {
+    if (run_pending()) continue;
+
+    std::unique_lock<std::mutex> guard(_sleepLock);
+    _wake.wait(guard, [this]() { return _stop || _queued.load() > 0; });
+    if (_stop && _queued.load() == 0) return;
+  }
+}
+
+/**
+ * Lazy binary splitting (Tzannes et al., 2010): a task walks its range one
+ * grain at a time and only splits off the upper half when its own deque is
+ * empty, i.e. when no other thread could currently steal anything from it.
+ */
+template<typename F>
+void ThreadPool::split(TaskGroup& group, std::size_t first, std::size_t last, std::size_t grain, F& body)
+{
+  while (last - first > grain) {
+    if (starving()) {
+      std::size_t middle = first + (last - first) / 2;
+      group.run([this, &group, middle, last, grain, &body]() {
+        split(group, middle, last, grain, body);
+      });
+      last = middle;
+      continue;
+    }
+    body(first, first + grain);
+    first += grain;
+  }
+  if (first < last) {
+    body(first, last);
+  }
+}
+
+template<typename F>
+void ThreadPool::parallel_for(IndexRange range, std::size_t grain, F&& body)
+{
+  if (range.empty()) return;
+  grain = std::max<std::size_t>(grain, 1);
+  if (range.size() <= grain) {
+    body(range.first, range.last);
+    return;
+  }
+  TaskGroup group(*this);
+  split(group, range.first, range.last, grain, body);
+  group.wait();
+}
+
+
+/**
+ * ctl::TaskGroup Implementation
+ */
+
+inline TaskGroup::TaskGroup(ThreadPool& pool) : _pool(pool) {}
+
+inline TaskGroup::~TaskGroup()
+{
+  try {
+    wait();
+  } catch (...) {}
+}
+
+template<typename F>
+void TaskGroup::run(F&& f)
+{
+  _pending.fetch_add(1);
+  _pool.submit([this, f]() mutable {
+    try {
+      f();
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(_errorLock);
+      if (!_error) _error = std::current_exception();
+    }
+    _pending.fetch_sub(1);
+  });
+}
+
+inline void TaskGroup::wait()
+{
+  while (_pending.load() > 0) {
+    if (!_pool.run_pending()) {
+      std::this_thread::yield();
+    }
+  }
+  std::exception_ptr error;
+  std::swap(error, _error);
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+template<typename F>
+void parallel_for(IndexRange range, std::size_t grain, F&& body)
+{
+  ThreadPool::instance().parallel_for(range, grain, std::forward<F>(body));
+}
+
+} // namespace ctl
@@ -9,16 +9,21 @@
 
 #include "allocator.hpp"
 #include "iterator.hpp"
+#include "numa.hpp"
+#include "parallel_copy.hpp"
 
 
 namespace ctl {
 
+template<typename T, class A, std::size_t ChunkSize>
+class VectorBuilder;
+
 /**
  * ctl::Vector Definition
  */
 
 template<typename T, class A = Allocator<T>>
-class Vector
+class Vector : private detail::AllocatorHolder<A>
 {
 public:
   using value_type = T;
@@ -33,14 +38,14 @@ public:
   using const_iterator = ctl::Iterator<const T>;
 
   Vector() {};
-  Vector(const Vector<T>&);
+  Vector(const Vector<T, A>&);
   Vector(size_type);
   Vector(size_type, const_reference);
   Vector(std::initializer_list<T>);
   template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
   Vector(IteratorType, IteratorType);
 
-  virtual ~Vector();
+  ~Vector();
 
   Vector<T, A>& operator=(const Vector<T, A>&);
   Vector<T, A>& operator=(Vector<T, A>&&);
@@ -55,6 +60,7 @@ public:
   size_type max_size() const noexcept;
   void resize(size_type);
   void resize(size_type, const_reference);
+  void resize(first_touch_t, size_type);
   size_type capacity() const noexcept;
   bool empty() const noexcept;
   void reserve(size_type);
@@ -65,9 +71,11 @@ public:
   reference front();
   reference back();
   pointer data() noexcept;
+  const_pointer data() const noexcept;
 
   void assign(size_type, const_reference);
   void assign(std::initializer_list<T>);
+  void assign(first_touch_t, size_type, const_reference);
 
   template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
   void assign(IteratorType, IteratorType);
@@ -85,6 +93,15 @@ public:
 
   iterator erase(iterator);
   iterator erase(iterator, iterator);
+  template<class Predicate>
+  size_type erase_if(Predicate);
+  iterator erase_unordered(iterator);
+  template<class Predicate>
+  size_type erase_unordered_if(Predicate);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  size_type erase_indices(IteratorType, IteratorType);
+  template<typename PositionIterator, typename ValueIterator>
+  void insert_batch(PositionIterator, PositionIterator, ValueIterator);
   void swap(Vector<T, A>&);
   void clear() noexcept;
 
@@ -97,16 +114,27 @@ public:
   A get_allocator() const noexcept;
 
 private:
-  const float _growthFactor = 1.5f;
+  template<typename U, class B, std::size_t C>
+  friend class VectorBuilder;
+
+  static constexpr float _growthFactor = 1.5f;
 
-  A _allocator;
   pointer _begin = nullptr;
   pointer _last = nullptr;
   pointer _end = nullptr;
+#if defined(CTL_CHECKED_ITERATORS)
+  std::shared_ptr<detail::IteratorState<T>> _state = std::make_shared<detail::IteratorState<T>>(&_begin, &_last);
+#endif
 
   void reallocate(size_type s);
+  template<typename F>
+  void touch(size_type, size_type, F&&);
+  template<typename F>
+  iterator append_rotate(size_type, F&&);
   void initialize(iterator, iterator);
   void destroy(iterator, iterator);
+  void adopt(pointer, size_type, size_type) noexcept;
+  void invalidate_iterators() noexcept;
 };
 
 
@@ -115,12 +143,16 @@ private:
  */
 
 template<typename T, typename A>
-Vector<T, A>::Vector(const Vector<T>& other)
+Vector<T, A>::Vector(const Vector<T, A>& other)
 {
   reallocate(other.size());
-  for (size_type i = 0; i < other.size(); ++i) {
-    _allocator.construct(_begin + i, other[i]);
+  try {
+    detail::uninitialized_copy_n(this->allocator(), other._begin, other.size(), _begin);
+  } catch (...) {
+    this->allocator().deallocate(_begin, capacity());
+    throw;
   }
+  _last = _begin + other.size();
 }
 
 template<typename T, typename A>
@@ -154,20 +186,24 @@ template<typename T, typename A>
 Vector<T, A>::~Vector()
 {
   destroy(begin(), end());
-  _allocator.deallocate(_begin, capacity());
+  this->allocator().deallocate(_begin, capacity());
+  invalidate_iterators();
 }
 
 template<typename T, typename A>
 Vector<T, A>& Vector<T, A>::operator=(const Vector<T, A>& other)
 {
   if (this == &other) return *this;
+  if (!std::is_trivially_copyable<T>::value && detail::use_parallel_copy(other.size())) {
+    Vector<T, A> copy(other);
+    swap(copy);
+    return *this;
+  }
   erase(begin(), end());
   if (other.size() > capacity()) {
     reallocate(other.size());
   }
-  for (size_type i = 0; i < other.size(); ++i) {
-    _allocator.construct(_begin + i, other[i]);
-  }
+  detail::uninitialized_copy_n(this->allocator(), other._begin, other.size(), _begin);
   _last = _begin + other.size();
   return *this;
 }
@@ -191,25 +227,41 @@ Vector<T, A>& Vector<T, A>::operator=(std::initializer_list<T> other)
 template<typename T, typename A>
 typename Vector<T, A>::iterator Vector<T, A>::begin() noexcept
 {
+#if defined(CTL_CHECKED_ITERATORS)
+  return iterator(_begin, _state);
+#else
   return iterator(_begin);
+#endif
 }
 
 template<typename T, typename A>
 typename Vector<T, A>::iterator Vector<T, A>::end() noexcept
 {
+#if defined(CTL_CHECKED_ITERATORS)
+  return iterator(_last, _state);
+#else
   return iterator(_last);
+#endif
 }
 
 template<typename T, typename A>
 typename Vector<T, A>::const_iterator Vector<T, A>::cbegin() const noexcept
 {
+#if defined(CTL_CHECKED_ITERATORS)
+  return const_iterator(_begin, _state);
+#else
   return const_iterator(_begin);
+#endif
 }
 
 template<typename T, typename A>
 typename Vector<T, A>::const_iterator Vector<T, A>::cend() const noexcept
 {
+#if defined(CTL_CHECKED_ITERATORS)
+  return const_iterator(_last, _state);
+#else
   return const_iterator(_last);
+#endif
 }
 
 template<typename T, typename A>
@@ -220,7 +272,7 @@ void Vector<T, A>::assign(size_type n, const_reference value)
     reallocate(n);
   }
   for (size_type i = 0; i < n; ++i) {
-    _allocator.construct(_begin + i, value);
+    this->allocator().construct(_begin + i, value);
   }
   _last = _begin + n;
 }
@@ -231,13 +283,24 @@ void Vector<T, A>::assign(std::initializer_list<T> il)
   assign(il.begin(), il.end());
 }
 
+template<typename T, typename A>
+void Vector<T, A>::assign(first_touch_t, size_type n, const_reference value)
+{
+  erase(begin(), end());
+  if (n > capacity()) {
+    reallocate(n);
+  }
+  touch(0, n, [this, &value](pointer p) { this->allocator().construct(p, value); });
+  _last = _begin + n;
+}
+
 template<typename T, typename A>
 void Vector<T, A>::push_back(const_reference value)
 {
   if (size() + 1 >= capacity()) {
     reallocate(size() + 1);
   }
-  _allocator.construct(_last++, T(value));
+  this->allocator().construct(_last++, T(value));
 }
 
 template<typename T, typename A>
@@ -246,43 +309,40 @@ void Vector<T, A>::push_back(value_type&& value)
   if (size() + 1 >= capacity()) {
     reallocate(size() + 1);
   }
-  std::swap(*(_last++), value);
+  this->allocator().construct(_last++, std::move(value));
 }
 
 template<typename T, typename A>
 void Vector<T, A>::pop_back()
 {
-  _allocator.destroy(_last);
-  --_last;
+#if defined(CTL_CHECKED_ITERATORS)
+  if (empty()) {
+    throw std::out_of_range("ctl::Vector: pop_back on empty vector");
+  }
+#endif
+  this->allocator().destroy(--_last);
 }
 
 template<typename T, typename A>
 typename Vector<T, A>::iterator Vector<T, A>::insert(iterator it, const_reference value)
 {
-  size_type index = it - begin();
-  if (size() + 1 > capacity()) {
-    reallocate(size() + 1);
-  }
-  it = begin() + index;
-  std::copy_backward(it, end(), it + size() - index + 1);
-  *it = value;
-  ++_last;
-  return it;
+  return emplace(it, value);
 }
 
 template<typename T, typename A>
 typename Vector<T, A>::iterator Vector<T, A>::insert(iterator it, size_type count, const_reference value)
 {
-  size_type newSize = size() + count;
   size_type index = it - begin();
-  if (newSize > capacity()) {
-    reallocate(newSize);
+  value_type copy(value);
+  if (size() + count > capacity()) {
+    reallocate(size() + count);
   }
-  it = begin() + index;
-  std::copy_backward(it, end(), end() + count);
-  std::fill(it, it + count, value);
-  _last = _begin + newSize;
-  return it;
+  return append_rotate(index, [this, count, &copy]() {
+    for (size_type i = 0; i < count; ++i) {
+      this->allocator().construct(_last, copy);
+      ++_last;
+    }
+  });
 }
 
 template<typename T, typename A>
@@ -296,38 +356,168 @@ template<typename IteratorType, typename isIterator>
 typename Vector<T, A>::iterator Vector<T, A>::insert(iterator from, IteratorType first, IteratorType last)
 {
   difference_type count = std::distance(first, last);
-  size_type newSize = size() + count;
   size_type index = from - begin();
-  if (newSize > capacity()) {
-    reallocate(newSize);
+  if (size() + count > capacity()) {
+    reallocate(size() + count);
   }
-  from = begin() + index;
-  std::copy_backward(from, end(), from + count + size() - index);
-  std::copy(first, last, from);
-  _last = _begin + newSize;
-  return from;
+  return append_rotate(index, [this, first, last]() mutable {
+    for (; first != last; ++first) {
+      this->allocator().construct(_last, *first);
+      ++_last;
+    }
+  });
 }
 
 template<typename T, typename A>
 typename Vector<T, A>::iterator Vector<T, A>::erase(iterator it)
 {
-  _allocator.destroy(&*it);
-  std::copy(it + 1, end(), it);
-  --_last;
+  std::move(it + 1, end(), it);
+  this->allocator().destroy(--_last);
   return it;
 }
 
 template<typename T, typename A>
 typename Vector<T, A>::iterator Vector<T, A>::erase(iterator first, iterator last)
 {
+  if (first == last) return first;
+  iterator newEnd = std::move(last, end(), first);
+  destroy(newEnd, end());
+  _last -= std::distance(first, last);
+  return first;
+}
+
+/**
+ * Removes every element for which pred returns true in a single compacting
+ * pass and returns how many were removed.
+ */
+template<typename T, typename A>
+template<class Predicate>
+typename Vector<T, A>::size_type Vector<T, A>::erase_if(Predicate pred)
+{
+  iterator newEnd = std::remove_if(begin(), end(), pred);
+  const size_type count = end() - newEnd;
+  destroy(newEnd, end());
+  _last -= count;
+  return count;
+}
+
+/**
+ * O(1) erase for vectors whose order does not matter: the last element is
+ * moved into the hole instead of shifting the tail. Returns an iterator to
+ * the same position, which now holds the former last element (or end()).
+ */
+template<typename T, typename A>
+typename Vector<T, A>::iterator Vector<T, A>::erase_unordered(iterator it)
+{
+  if (it + 1 != end()) {
+    *it = std::move(*(end() - 1));
+  }
+  this->allocator().destroy(--_last);
+  return it;
+}
+
+/**
+ * Removes every element for which pred returns true by swap-and-pop, so no
+ * element moves more than once per removal. The order of the survivors is
+ * not preserved. Returns how many were removed.
+ */
+template<typename T, typename A>
+template<class Predicate>
+typename Vector<T, A>::size_type Vector<T, A>::erase_unordered_if(Predicate pred)
+{
+  const size_type oldSize = size();
+  for (iterator it = begin(); it != end();) {
+    if (pred(*it)) {
+      it = erase_unordered(it);
+    } else {
+      ++it;
+    }
+  }
+  return oldSize - size();
+}
+
+/**
+ * Removes the elements at the given indices, which must be strictly
+ * increasing and in range, moving each survivor at most once. The indices
+ * are checked before anything is touched.
+ */
+template<typename T, typename A>
+template<typename IteratorType, typename isIterator>
+typename Vector<T, A>::size_type Vector<T, A>::erase_indices(IteratorType first, IteratorType last)
+{
+  if (first == last) return 0;
+  size_type previous = 0;
   for (auto it = first; it != last; ++it) {
-    _allocator.destroy(&*it);
+    const size_type index = static_cast<size_type>(*it);
+    if (index >= size() || (it != first && index <= previous)) {
+      throw std::invalid_argument("ctl::Vector: erase_indices expects sorted, unique, in-range indices");
+    }
+    previous = index;
   }
-  if (end() > last + 1) {
-    std::copy(last + 1, end(), first + 1);
+
+  size_type write = static_cast<size_type>(*first);
+  for (size_type read = write; read < size(); ++read) {
+    if (first != last && static_cast<size_type>(*first) == read) {
+      ++first;
+      continue;
+    }
+    _begin[write++] = std::move(_begin[read]);
   }
-  _last -= std::distance(first, last);
-  return first;
+  const size_type count = size() - write;
+  destroy(begin() + write, end());
+  _last = _begin + write;
+  return count;
+}
+
+/**
+ * Inserts values[i] before the element originally at positions[i], for
+ * positions sorted in non-decreasing order and at most size(). Equal
+ * positions insert in sequence. Elements are shifted in one backward pass,
+ * so each moves at most once. Both iterators must be random access and the
+ * values must not alias this vector.
+ */
+template<typename T, typename A>
+template<typename PositionIterator, typename ValueIterator>
+void Vector<T, A>::insert_batch(PositionIterator positions, PositionIterator positionsEnd, ValueIterator values)
+{
+  const size_type count = std::distance(positions, positionsEnd);
+  if (count == 0) return;
+  for (size_type j = 0; j < count; ++j) {
+    const size_type position = static_cast<size_type>(positions[j]);
+    if (position > size() || (j > 0 && position < static_cast<size_type>(positions[j - 1]))) {
+      throw std::invalid_argument("ctl::Vector: insert_batch expects sorted positions within size()");
+    }
+  }
+  if (size() + count > capacity()) {
+    reallocate(size() + count);
+  }
+
+  const size_type oldSize = size();
+  size_type write = oldSize + count;
+  size_type low = write;
+  size_type i = oldSize;
+  try {
+    for (size_type j = count; j > 0; --write) {
+      const bool takeOld = i > static_cast<size_type>(positions[j - 1]);
+      pointer dst = _begin + write - 1;
+      if (write - 1 >= oldSize) {
+        if (takeOld) {
+          this->allocator().construct(dst, std::move_if_noexcept(_begin[--i]));
+        } else {
+          this->allocator().construct(dst, values[--j]);
+        }
+        low = write - 1;
+      } else if (takeOld) {
+        *dst = std::move(_begin[--i]);
+      } else {
+        *dst = values[--j];
+      }
+    }
+  } catch (...) {
+    destroy(begin() + low, begin() + oldSize + count);
+    throw;
+  }
+  _last = _begin + oldSize + count;
 }
 
 template<typename T, typename A>
@@ -336,20 +526,29 @@ void Vector<T, A>::swap(Vector<T, A>& other)
   std::swap(_begin, other._begin);
   std::swap(_last, other._last);
   std::swap(_end, other._end);
-  std::swap(_allocator, other._allocator);
+  std::swap(this->allocator(), other.allocator());
+#if defined(CTL_CHECKED_ITERATORS)
+  std::swap(_state, other._state);
+  _state->begin = &_begin;
+  _state->last = &_last;
+  other._state->begin = &other._begin;
+  other._state->last = &other._last;
+#endif
 }
 
 template<typename T, typename A>
 void Vector<T, A>::clear() noexcept
 {
-  _allocator.deallocate(_begin, capacity());
+  destroy(begin(), end());
+  this->allocator().deallocate(_begin, capacity());
   _begin = _last = _end = nullptr;
+  invalidate_iterators();
 }
 
 template<typename T, typename A>
 typename Vector<T, A>::allocator_type Vector<T, A>::get_allocator() const noexcept
 {
-  return _allocator;
+  return this->allocator();
 }
 
 template<typename T, typename A>
@@ -374,6 +573,21 @@ void Vector<T, A>::resize(size_type newSize, const_reference val)
   assign(newSize, val);
 }
 
+template<typename T, typename A>
+void Vector<T, A>::resize(first_touch_t, size_type newSize)
+{
+  size_type index = size();
+  if (newSize <= index) {
+    resize(newSize);
+    return;
+  }
+  if (newSize > capacity()) {
+    reallocate(newSize);
+  }
+  touch(index, newSize, [this](pointer p) { this->allocator().construct(p, value_type()); });
+  _last = _begin + newSize;
+}
+
 template<typename T, typename A>
 void Vector<T, A>::reserve(size_type newCapacity)
 {
@@ -448,38 +662,67 @@ typename Vector<T, A>::pointer Vector<T, A>::data() noexcept
   return _begin;
 }
 
+template<typename T, typename A>
+typename Vector<T, A>::const_pointer Vector<T, A>::data() const noexcept
+{
+  return _begin;
+}
+
 template<typename T, typename A>
 void Vector<T, A>::reallocate(size_type newCapacity)
 {
   if (newCapacity >= capacity()) {
     newCapacity *= _growthFactor;
   }
-  pointer newBegin = _allocator.allocate(newCapacity);
+  pointer newBegin = this->allocator().allocate(newCapacity);
   if (newBegin == _begin) return;
 
+  size_type count = std::min(size(), newCapacity);
   if (_begin) {
     try {
-      std::move(
-          _begin,
-          _begin + std::min(size(), newCapacity),
-          newBegin
-        );
+      detail::uninitialized_move_n(this->allocator(), _begin, count, newBegin);
     } catch (...) {
-      _allocator.deallocate(newBegin, newCapacity);
+      this->allocator().deallocate(newBegin, newCapacity);
       throw;
     }
-    _allocator.deallocate(_begin, capacity());
+    destroy(begin(), end());
+    this->allocator().deallocate(_begin, capacity());
   }
-  _last = newBegin + size();
+  _last = newBegin + count;
   _begin = newBegin;
   _end = newBegin + newCapacity;
+  invalidate_iterators();
+}
+
+template<typename T, typename A>
+template<typename F>
+void Vector<T, A>::touch(size_type from, size_type to, F&& construct)
+{
+  pointer first = _begin + from;
+  numa::parallel_touch(
+      to - from,
+      [this, first, &construct](size_type blockFirst, size_type blockLast) {
+        size_type i = blockFirst;
+        try {
+          for (; i < blockLast; ++i) {
+            construct(first + i);
+          }
+        } catch (...) {
+          destroy(iterator(first + blockFirst), iterator(first + i));
+          throw;
+        }
+      },
+      [this, first](size_type blockFirst, size_type blockLast) {
+        destroy(iterator(first + blockFirst), iterator(first + blockLast));
+      }
+    );
 }
 
 template<typename T, typename A>
 void Vector<T, A>::initialize(iterator first, iterator last)
 {
   for (auto it = first; it != last; ++it) {
-    _allocator.construct(&*it, value_type());
+    this->allocator().construct(it.base(), value_type());
   }
 }
 
@@ -487,26 +730,79 @@ template<typename T, typename A>
 void Vector<T, A>::destroy(iterator first, iterator last)
 {
   for (auto it = first; it != last; ++it) {
-    _allocator.destroy(&*it);
+    this->allocator().destroy(it.base());
   }
 }
 
+/**
+ * Takes ownership of a buffer of capacity elements obtained from A whose
+ * first size elements are constructed.
+ */
+template<typename T, typename A>
+void Vector<T, A>::adopt(pointer buffer, size_type size, size_type capacity) noexcept
+{
+  clear();
+  _begin = buffer;
+  _last = buffer + size;
+  _end = buffer + capacity;
+}
+
+/**
+ * Called whenever the buffer is dropped; in a checked build this makes
+ * every iterator handed out so far report itself as invalidated.
+ */
+template<typename T, typename A>
+inline void Vector<T, A>::invalidate_iterators() noexcept
+{
+#if defined(CTL_CHECKED_ITERATORS)
+  ++_state->generation;
+#endif
+}
+
 template<typename T, typename A>
 template<class... Args>
 typename Vector<T, A>::iterator Vector<T, A>::emplace(iterator it, Args&&... args)
 {
   size_type index = it - begin();
+  if (index == size()) {
+    if (size() + 1 > capacity()) {
+      reallocate(size() + 1);
+    }
+    this->allocator().construct(_last, std::forward<Args>(args)...);
+    ++_last;
+    return begin() + index;
+  }
+
+  value_type value(std::forward<Args>(args)...);
   if (size() + 1 > capacity()) {
     reallocate(size() + 1);
   }
-  it = begin() + index;
-  std::move_backward(
-      it,
-      end(),
-      it + size() - index + 1
-    );
-  _allocator.construct(&*it, std::forward<Args>(args)...);
-  return it;
+  pointer position = _begin + index;
+  this->allocator().construct(_last, std::move(*(_last - 1)));
+  ++_last;
+  std::move_backward(position, _last - 2, _last - 1);
+  *position = std::move(value);
+  return begin() + index;
+}
+
+/**
+ * Constructs new elements at the end with append() and rotates them into
+ * place at index. On exception the partially appended tail is destroyed.
+ */
+template<typename T, typename A>
+template<typename F>
+typename Vector<T, A>::iterator Vector<T, A>::append_rotate(size_type index, F&& append)
+{
+  pointer oldLast = _last;
+  try {
+    append();
+  } catch (...) {
+    destroy(iterator(oldLast), end());
+    _last = oldLast;
+    throw;
+  }
+  std::rotate(_begin + index, oldLast, _last);
+  return begin() + index;
 }
 
 template<typename T, typename A>
@@ -526,10 +822,16 @@ void Vector<T, A>::assign(IteratorType first, IteratorType last)
     reallocate(count);
   }
   for (auto it = begin(); first != last; ++it, ++first) {
-    _allocator.construct(&*it, value_type(*first));
+    this->allocator().construct(it.base(), value_type(*first));
   }
   _last = _begin + count;
 }
 
+#if !defined(CTL_CHECKED_ITERATORS)
+static_assert(sizeof(Vector<int>) == 3 * sizeof(int*), "ctl::Vector: must stay three pointers");
+static_assert(sizeof(Vector<int, std::allocator<int>>) == 3 * sizeof(int*), "ctl::Vector: must stay three pointers");
+#endif
 
 } // namespace ctl
+
+#include "vector_bool.hpp"
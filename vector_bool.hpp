@@ -0,0 +1,676 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <initializer_list>
+
+#include "iterator.hpp"
+#include "vector.hpp"
+
+
+namespace ctl {
+
+namespace detail {
+
+inline std::size_t popcount(std::uint64_t word) noexcept
+{
+#if defined(__POPCNT__)
+  return __builtin_popcountll(word);
+#else
+  word = word - ((word >> 1) & 0x5555555555555555ull);
+  word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+  word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+  return static_cast<std::size_t>((word * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+inline std::size_t lowest_bit(std::uint64_t word) noexcept
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(word);
+#else
+  std::size_t bit = 0;
+  for (; !(word & 1); word >>= 1) ++bit;
+  return bit;
+#endif
+}
+
+} // namespace detail
+
+
+/**
+ * ctl::Vector<bool> Definition
+ *
+ * Bit-packed specialization: 64 elements per word, so a bitmap takes an
+ * eighth of the memory of one byte per flag. Element access goes through a
+ * proxy reference; count(), find_first() / find_next() and the bitwise
+ * operators work a whole word at a time. Bits past size() are always kept
+ * clear, so word loops never need to mask the tail.
+ */
+
+template<class A>
+class Vector<bool, A>
+{
+public:
+  using word_type = std::uint64_t;
+  using value_type = bool;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using difference_type = typename A::difference_type;
+  using const_reference = bool;
+
+  class reference
+  {
+  public:
+    reference(word_type* word, word_type mask) noexcept : _word(word), _mask(mask) {}
+    reference(const reference&) = default;
+
+    operator bool() const noexcept { return (*_word & _mask) != 0; }
+    reference& operator=(bool) noexcept;
+    reference& operator=(const reference& other) noexcept { return *this = bool(other); }
+    void flip() noexcept { *_word ^= _mask; }
+
+  private:
+    word_type* _word;
+    word_type _mask;
+  };
+
+  using iterator = ctl::IndexIterator<Vector, bool, reference>;
+  using const_iterator = ctl::IndexIterator<const Vector, const bool, bool>;
+
+  static constexpr size_type bits_per_word = 64;
+
+  Vector() {};
+  Vector(const Vector&);
+  Vector(Vector&&);
+  Vector(size_type);
+  Vector(size_type, bool);
+  Vector(std::initializer_list<bool>);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  Vector(IteratorType, IteratorType);
+
+  ~Vector();
+
+  Vector& operator=(const Vector&);
+  Vector& operator=(Vector&&);
+  Vector& operator=(std::initializer_list<bool>);
+
+  iterator begin() noexcept;
+  iterator end() noexcept;
+  const_iterator cbegin() const noexcept;
+  const_iterator cend() const noexcept;
+
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  void resize(size_type, bool = false);
+  size_type capacity() const noexcept;
+  bool empty() const noexcept;
+  void reserve(size_type);
+  void shrink_to_fit();
+
+  reference at(size_type);
+  bool at(size_type) const;
+  reference operator[](size_type) noexcept;
+  bool operator[](size_type) const noexcept;
+  reference front();
+  reference back();
+  word_type* data() noexcept;
+  const word_type* data() const noexcept;
+  size_type word_count() const noexcept;
+
+  void assign(size_type, bool);
+  void assign(std::initializer_list<bool>);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  void assign(IteratorType, IteratorType);
+
+  void push_back(bool);
+  void pop_back();
+  iterator insert(iterator, bool);
+  iterator erase(iterator);
+  iterator erase(iterator, iterator);
+  void swap(Vector&) noexcept;
+  void clear() noexcept;
+
+  size_type count() const noexcept;
+  size_type find_first() const noexcept;
+  size_type find_next(size_type) const noexcept;
+  void flip() noexcept;
+
+  Vector& operator&=(const Vector&);
+  Vector& operator|=(const Vector&);
+  Vector& operator^=(const Vector&);
+
+  A get_allocator() const noexcept;
+
+private:
+  using word_allocator = typename std::allocator_traits<A>::template rebind_alloc<word_type>;
+
+  static constexpr float _growthFactor = 1.5f;
+
+  word_allocator _allocator;
+  word_type* _words = nullptr;
+  size_type _size = 0;
+  size_type _capacity = 0;
+
+  static size_type words_for(size_type) noexcept;
+  word_type read_bits(size_type, size_type) const noexcept;
+  void write_bits(size_type, size_type, word_type) noexcept;
+  void move_bits(size_type, size_type, size_type) noexcept;
+  void clear_tail() noexcept;
+  void reallocate(size_type);
+  void check_size(const Vector&) const;
+};
+
+
+/**
+ * ctl::Vector<bool> Implementation
+ */
+
+template<class A>
+constexpr typename Vector<bool, A>::size_type Vector<bool, A>::bits_per_word;
+
+template<class A>
+typename Vector<bool, A>::reference& Vector<bool, A>::reference::operator=(bool value) noexcept
+{
+  if (value) {
+    *_word |= _mask;
+  } else {
+    *_word &= ~_mask;
+  }
+  return *this;
+}
+
+template<class A>
+Vector<bool, A>::Vector(const Vector& other)
+{
+  reallocate(other.word_count());
+  std::copy(other._words, other._words + other.word_count(), _words);
+  _size = other._size;
+}
+
+template<class A>
+Vector<bool, A>::Vector(Vector&& other)
+{
+  swap(other);
+}
+
+template<class A>
+Vector<bool, A>::Vector(size_type count)
+{
+  assign(count, false);
+}
+
+template<class A>
+Vector<bool, A>::Vector(size_type count, bool value)
+{
+  assign(count, value);
+}
+
+template<class A>
+Vector<bool, A>::Vector(std::initializer_list<bool> list)
+{
+  assign(list.begin(), list.end());
+}
+
+template<class A>
+template<typename IteratorType, typename isIterator>
+Vector<bool, A>::Vector(IteratorType first, IteratorType last)
+{
+  assign(first, last);
+}
+
+template<class A>
+Vector<bool, A>::~Vector()
+{
+  _allocator.deallocate(_words, _capacity);
+}
+
+template<class A>
+Vector<bool, A>& Vector<bool, A>::operator=(const Vector& other)
+{
+  if (this == &other) return *this;
+  if (other.word_count() > _capacity) {
+    reallocate(other.word_count());
+  }
+  std::copy(other._words, other._words + other.word_count(), _words);
+  std::fill(_words + other.word_count(), _words + word_count(), word_type(0));
+  _size = other._size;
+  return *this;
+}
+
+template<class A>
+Vector<bool, A>& Vector<bool, A>::operator=(Vector&& other)
+{
+  if (this == &other) return *this;
+  Vector moved(std::move(other));
+  swap(moved);
+  return *this;
+}
+
+template<class A>
+Vector<bool, A>& Vector<bool, A>::operator=(std::initializer_list<bool> list)
+{
+  assign(list.begin(), list.end());
+  return *this;
+}
+
+template<class A>
+typename Vector<bool, A>::iterator Vector<bool, A>::begin() noexcept
+{
+  return iterator(this, 0);
+}
+
+template<class A>
+typename Vector<bool, A>::iterator Vector<bool, A>::end() noexcept
+{
+  return iterator(this, _size);
+}
+
+template<class A>
+typename Vector<bool, A>::const_iterator Vector<bool, A>::cbegin() const noexcept
+{
+  return const_iterator(this, 0);
+}
+
+template<class A>
+typename Vector<bool, A>::const_iterator Vector<bool, A>::cend() const noexcept
+{
+  return const_iterator(this, _size);
+}
+
+template<class A>
+inline typename Vector<bool, A>::size_type Vector<bool, A>::size() const noexcept
+{
+  return _size;
+}
+
+template<class A>
+typename Vector<bool, A>::size_type Vector<bool, A>::max_size() const noexcept
+{
+  return static_cast<size_type>(-1);
+}
+
+template<class A>
+void Vector<bool, A>::resize(size_type newSize, bool value)
+{
+  if (newSize <= _size) {
+    _size = newSize;
+    clear_tail();
+    return;
+  }
+  if (words_for(newSize) > _capacity) {
+    reallocate(words_for(newSize));
+  }
+  const size_type first = _size;
+  _size = newSize;
+  if (!value) return;
+
+  size_type i = first;
+  for (; i < newSize && i % bits_per_word; ++i) {
+    (*this)[i] = true;
+  }
+  if (i < newSize) {
+    std::fill(_words + i / bits_per_word, _words + word_count(), ~word_type(0));
+    clear_tail();
+  }
+}
+
+template<class A>
+inline typename Vector<bool, A>::size_type Vector<bool, A>::capacity() const noexcept
+{
+  return _capacity * bits_per_word;
+}
+
+template<class A>
+inline bool Vector<bool, A>::empty() const noexcept
+{
+  return _size == 0;
+}
+
+template<class A>
+void Vector<bool, A>::reserve(size_type newCapacity)
+{
+  if (newCapacity > capacity()) {
+    reallocate(words_for(newCapacity));
+  }
+}
+
+template<class A>
+void Vector<bool, A>::shrink_to_fit()
+{
+  if (word_count() != _capacity) {
+    reallocate(word_count());
+  }
+}
+
+template<class A>
+typename Vector<bool, A>::reference Vector<bool, A>::at(size_type i)
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::Vector: out of range");
+  }
+  return (*this)[i];
+}
+
+template<class A>
+bool Vector<bool, A>::at(size_type i) const
+{
+  if (i >= _size) {
+    throw std::out_of_range("ctl::Vector: out of range");
+  }
+  return (*this)[i];
+}
+
+template<class A>
+inline typename Vector<bool, A>::reference Vector<bool, A>::operator[](size_type i) noexcept
+{
+  return reference(_words + i / bits_per_word, word_type(1) << (i % bits_per_word));
+}
+
+template<class A>
+inline bool Vector<bool, A>::operator[](size_type i) const noexcept
+{
+  return (_words[i / bits_per_word] >> (i % bits_per_word)) & 1;
+}
+
+template<class A>
+typename Vector<bool, A>::reference Vector<bool, A>::front()
+{
+  return (*this)[0];
+}
+
+template<class A>
+typename Vector<bool, A>::reference Vector<bool, A>::back()
+{
+  return (*this)[_size - 1];
+}
+
+template<class A>
+inline typename Vector<bool, A>::word_type* Vector<bool, A>::data() noexcept
+{
+  return _words;
+}
+
+template<class A>
+inline const typename Vector<bool, A>::word_type* Vector<bool, A>::data() const noexcept
+{
+  return _words;
+}
+
+template<class A>
+inline typename Vector<bool, A>::size_type Vector<bool, A>::word_count() const noexcept
+{
+  return words_for(_size);
+}
+
+template<class A>
+void Vector<bool, A>::assign(size_type n, bool value)
+{
+  clear();
+  resize(n, value);
+}
+
+template<class A>
+void Vector<bool, A>::assign(std::initializer_list<bool> il)
+{
+  assign(il.begin(), il.end());
+}
+
+template<class A>
+template<typename IteratorType, typename isIterator>
+void Vector<bool, A>::assign(IteratorType first, IteratorType last)
+{
+  clear();
+  for (; first != last; ++first) {
+    push_back(*first);
+  }
+}
+
+template<class A>
+void Vector<bool, A>::push_back(bool value)
+{
+  if (_size == capacity()) {
+    reallocate(std::max<size_type>(_capacity * _growthFactor, _capacity + 1));
+  }
+  (*this)[_size++] = value;
+}
+
+template<class A>
+void Vector<bool, A>::pop_back()
+{
+  (*this)[--_size] = false;
+}
+
+template<class A>
+typename Vector<bool, A>::iterator Vector<bool, A>::insert(iterator it, bool value)
+{
+  const size_type index = it.index();
+  if (_size == capacity()) {
+    reallocate(std::max<size_type>(_capacity * _growthFactor, _capacity + 1));
+  }
+  ++_size;
+  move_bits(index, index + 1, _size - index - 1);
+  (*this)[index] = value;
+  return iterator(this, index);
+}
+
+template<class A>
+typename Vector<bool, A>::iterator Vector<bool, A>::erase(iterator it)
+{
+  return erase(it, it + 1);
+}
+
+template<class A>
+typename Vector<bool, A>::iterator Vector<bool, A>::erase(iterator first, iterator last)
+{
+  const size_type from = first.index();
+  const size_type to = last.index();
+  move_bits(to, from, _size - to);
+  _size -= to - from;
+  clear_tail();
+  return iterator(this, from);
+}
+
+template<class A>
+void Vector<bool, A>::swap(Vector& other) noexcept
+{
+  std::swap(_words, other._words);
+  std::swap(_size, other._size);
+  std::swap(_capacity, other._capacity);
+}
+
+template<class A>
+void Vector<bool, A>::clear() noexcept
+{
+  std::fill(_words, _words + word_count(), word_type(0));
+  _size = 0;
+}
+
+template<class A>
+typename Vector<bool, A>::size_type Vector<bool, A>::count() const noexcept
+{
+  size_type total = 0;
+  for (size_type w = 0; w < word_count(); ++w) {
+    total += detail::popcount(_words[w]);
+  }
+  return total;
+}
+
+template<class A>
+typename Vector<bool, A>::size_type Vector<bool, A>::find_first() const noexcept
+{
+  for (size_type w = 0; w < word_count(); ++w) {
+    if (_words[w]) return w * bits_per_word + detail::lowest_bit(_words[w]);
+  }
+  return _size;
+}
+
+template<class A>
+typename Vector<bool, A>::size_type Vector<bool, A>::find_next(size_type i) const noexcept
+{
+  if (++i >= _size) return _size;
+  size_type w = i / bits_per_word;
+  word_type word = _words[w] & (~word_type(0) << (i % bits_per_word));
+  while (!word) {
+    if (++w == word_count()) return _size;
+    word = _words[w];
+  }
+  return w * bits_per_word + detail::lowest_bit(word);
+}
+
+template<class A>
+void Vector<bool, A>::flip() noexcept
+{
+  for (size_type w = 0; w < word_count(); ++w) {
+    _words[w] = ~_words[w];
+  }
+  clear_tail();
+}
+
+template<class A>
+Vector<bool, A>& Vector<bool, A>::operator&=(const Vector& other)
+{
+  check_size(other);
+  for (size_type w = 0; w < word_count(); ++w) {
+    _words[w] &= other._words[w];
+  }
+  return *this;
+}
+
+template<class A>
+Vector<bool, A>& Vector<bool, A>::operator|=(const Vector& other)
+{
+  check_size(other);
+  for (size_type w = 0; w < word_count(); ++w) {
+    _words[w] |= other._words[w];
+  }
+  return *this;
+}
+
+template<class A>
+Vector<bool, A>& Vector<bool, A>::operator^=(const Vector& other)
+{
+  check_size(other);
+  for (size_type w = 0; w < word_count(); ++w) {
+    _words[w] ^= other._words[w];
+  }
+  return *this;
+}
+
+template<class A>
+typename Vector<bool, A>::allocator_type Vector<bool, A>::get_allocator() const noexcept
+{
+  return A(_allocator);
+}
+
+template<class A>
+inline typename Vector<bool, A>::size_type Vector<bool, A>::words_for(size_type bits) noexcept
+{
+  return (bits + bits_per_word - 1) / bits_per_word;
+}
+
+/**
+ * Returns the n (<= 64) bits starting at bit pos, lowest bit first.
+ */
+template<class A>
+typename Vector<bool, A>::word_type Vector<bool, A>::read_bits(size_type pos, size_type n) const noexcept
+{
+  const size_type w = pos / bits_per_word;
+  const size_type shift = pos % bits_per_word;
+  word_type bits = _words[w] >> shift;
+  if (shift && shift + n > bits_per_word) {
+    bits |= _words[w + 1] << (bits_per_word - shift);
+  }
+  return n == bits_per_word ? bits : bits & ((word_type(1) << n) - 1);
+}
+
+template<class A>
+void Vector<bool, A>::write_bits(size_type pos, size_type n, word_type bits) noexcept
+{
+  const size_type w = pos / bits_per_word;
+  const size_type shift = pos % bits_per_word;
+  const word_type mask = n == bits_per_word ? ~word_type(0) : (word_type(1) << n) - 1;
+  _words[w] = (_words[w] & ~(mask << shift)) | ((bits & mask) << shift);
+  if (shift && shift + n > bits_per_word) {
+    const size_type rest = bits_per_word - shift;
+    _words[w + 1] = (_words[w + 1] & ~(mask >> rest)) | ((bits & mask) >> rest);
+  }
+}
+
+/**
+ * Copies n bits from src to dst a word at a time; the ranges may overlap.
+ */
+template<class A>
+void Vector<bool, A>::move_bits(size_type src, size_type dst, size_type n) noexcept
+{
+  if (dst < src) {
+    for (size_type done = 0; done < n; done += bits_per_word) {
+      const size_type chunk = std::min(bits_per_word, n - done);
+      write_bits(dst + done, chunk, read_bits(src + done, chunk));
+    }
+  } else if (dst > src) {
+    for (size_type left = n; left > 0;) {
+      const size_type chunk = std::min(bits_per_word, left);
+      left -= chunk;
+      write_bits(dst + left, chunk, read_bits(src + left, chunk));
+    }
+  }
+}
+
+template<class A>
+void Vector<bool, A>::clear_tail() noexcept
+{
+  const size_type used = _size % bits_per_word;
+  const size_type words = word_count();
+  if (used) {
+    _words[words - 1] &= (word_type(1) << used) - 1;
+  }
+  std::fill(_words + words, _words + _capacity, word_type(0));
+}
+
+template<class A>
+void Vector<bool, A>::reallocate(size_type newCapacity)
+{
+  word_type* newWords = newCapacity ? _allocator.allocate(newCapacity) : nullptr;
+  const size_type kept = std::min(word_count(), newCapacity);
+  std::copy(_words, _words + kept, newWords);
+  std::fill(newWords + kept, newWords + newCapacity, word_type(0));
+  _allocator.deallocate(_words, _capacity);
+  _words = newWords;
+  _capacity = newCapacity;
+  _size = std::min(_size, newCapacity * bits_per_word);
+}
+
+template<class A>
+void Vector<bool, A>::check_size(const Vector& other) const
+{
+  if (other._size != _size) {
+    throw std::invalid_argument("ctl::Vector: bitwise operation on vectors of different size");
+  }
+}
+
+template<class A>
+Vector<bool, A> operator&(Vector<bool, A> lhs, const Vector<bool, A>& rhs)
+{
+  lhs &= rhs;
+  return lhs;
+}
+
+template<class A>
+Vector<bool, A> operator|(Vector<bool, A> lhs, const Vector<bool, A>& rhs)
+{
+  lhs |= rhs;
+  return lhs;
+}
+
+template<class A>
+Vector<bool, A> operator^(Vector<bool, A> lhs, const Vector<bool, A>& rhs)
+{
+  lhs ^= rhs;
+  return lhs;
+}
+
+} // namespace ctl
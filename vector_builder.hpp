@@ -0,0 +1,247 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+
+#include "allocator.hpp"
+#include "vector.hpp"
+#include "parallel_copy.hpp"
+
+
+namespace ctl {
+
+/**
+ * ctl::VectorBuilder Definition
+ *
+ * Append-only staging area for inputs of unknown length. Elements go into a
+ * chain of ChunkSize-element chunks from A, so growing never copies and
+ * never holds an old and a new buffer at once. finish() hands the result
+ * over as a ctl::Vector: a single chunk is adopted as is, otherwise one
+ * exactly-sized buffer is allocated and every element is moved once. Peak
+ * memory is the data plus one partly filled chunk, then data x 2 for the
+ * duration of the final move, instead of the 2.5x of geometric growth.
+ */
+
+template<typename T, class A = Allocator<T>, std::size_t ChunkSize = 4096>
+class VectorBuilder
+{
+public:
+  using value_type = T;
+  using allocator_type = A;
+  using size_type = typename A::size_type;
+  using reference = typename A::reference;
+  using const_reference = typename A::const_reference;
+  using pointer = typename A::pointer;
+
+  static constexpr size_type chunk_size = ChunkSize;
+
+  VectorBuilder() {};
+  VectorBuilder(const VectorBuilder&) = delete;
+  VectorBuilder(VectorBuilder&&);
+  ~VectorBuilder();
+
+  VectorBuilder& operator=(const VectorBuilder&) = delete;
+  VectorBuilder& operator=(VectorBuilder&&);
+
+  size_type size() const noexcept;
+  bool empty() const noexcept;
+  size_type chunk_count() const noexcept;
+
+  reference operator[](size_type) noexcept;
+  const_reference operator[](size_type) const noexcept;
+  reference back();
+
+  void push_back(const_reference);
+  void push_back(value_type&&);
+  template<class... Args>
+  reference emplace_back(Args&&...);
+  template<typename IteratorType, class = typename std::enable_if< !std::is_integral<IteratorType>::value >::type>
+  void append(IteratorType, IteratorType);
+
+  Vector<T, A> finish();
+  void swap(VectorBuilder&) noexcept;
+  void clear() noexcept;
+
+private:
+  using chunk_allocator = typename std::allocator_traits<A>::template rebind_alloc<pointer>;
+
+  A _allocator;
+  Vector<pointer, chunk_allocator> _chunks;
+  size_type _size = 0;
+
+  pointer slot(size_type) const noexcept;
+};
+
+
+/**
+ * ctl::VectorBuilder Implementation
+ */
+
+template<typename T, typename A, std::size_t C>
+constexpr typename VectorBuilder<T, A, C>::size_type VectorBuilder<T, A, C>::chunk_size;
+
+template<typename T, typename A, std::size_t C>
+VectorBuilder<T, A, C>::VectorBuilder(VectorBuilder&& other)
+{
+  swap(other);
+}
+
+template<typename T, typename A, std::size_t C>
+VectorBuilder<T, A, C>::~VectorBuilder()
+{
+  clear();
+}
+
+template<typename T, typename A, std::size_t C>
+VectorBuilder<T, A, C>& VectorBuilder<T, A, C>::operator=(VectorBuilder&& other)
+{
+  if (this == &other) return *this;
+  VectorBuilder moved(std::move(other));
+  swap(moved);
+  return *this;
+}
+
+template<typename T, typename A, std::size_t C>
+inline typename VectorBuilder<T, A, C>::size_type VectorBuilder<T, A, C>::size() const noexcept
+{
+  return _size;
+}
+
+template<typename T, typename A, std::size_t C>
+inline bool VectorBuilder<T, A, C>::empty() const noexcept
+{
+  return _size == 0;
+}
+
+template<typename T, typename A, std::size_t C>
+inline typename VectorBuilder<T, A, C>::size_type VectorBuilder<T, A, C>::chunk_count() const noexcept
+{
+  return _chunks.size();
+}
+
+template<typename T, typename A, std::size_t C>
+inline typename VectorBuilder<T, A, C>::reference VectorBuilder<T, A, C>::operator[](size_type i) noexcept
+{
+  return *slot(i);
+}
+
+template<typename T, typename A, std::size_t C>
+inline typename VectorBuilder<T, A, C>::const_reference VectorBuilder<T, A, C>::operator[](size_type i) const noexcept
+{
+  return *slot(i);
+}
+
+template<typename T, typename A, std::size_t C>
+typename VectorBuilder<T, A, C>::reference VectorBuilder<T, A, C>::back()
+{
+  return *slot(_size - 1);
+}
+
+template<typename T, typename A, std::size_t C>
+void VectorBuilder<T, A, C>::push_back(const_reference value)
+{
+  emplace_back(value);
+}
+
+template<typename T, typename A, std::size_t C>
+void VectorBuilder<T, A, C>::push_back(value_type&& value)
+{
+  emplace_back(std::move(value));
+}
+
+template<typename T, typename A, std::size_t C>
+template<class... Args>
+typename VectorBuilder<T, A, C>::reference VectorBuilder<T, A, C>::emplace_back(Args&&... args)
+{
+  if (_size == _chunks.size() * C) {
+    pointer chunk = _allocator.allocate(C);
+    try {
+      _chunks.push_back(chunk);
+    } catch (...) {
+      _allocator.deallocate(chunk, C);
+      throw;
+    }
+  }
+  pointer p = slot(_size);
+  _allocator.construct(p, std::forward<Args>(args)...);
+  ++_size;
+  return *p;
+}
+
+template<typename T, typename A, std::size_t C>
+template<typename IteratorType, typename isIterator>
+void VectorBuilder<T, A, C>::append(IteratorType first, IteratorType last)
+{
+  for (; first != last; ++first) {
+    emplace_back(*first);
+  }
+}
+
+/**
+ * Returns everything appended so far as a ctl::Vector and leaves the
+ * builder empty. If moving an element throws, the builder is unchanged.
+ */
+template<typename T, typename A, std::size_t C>
+Vector<T, A> VectorBuilder<T, A, C>::finish()
+{
+  Vector<T, A> result;
+  if (_chunks.size() == 1) {
+    result.adopt(_chunks[0], _size, C);
+    _chunks.clear();
+    _size = 0;
+    return result;
+  }
+  if (_size == 0) {
+    clear();
+    return result;
+  }
+
+  pointer buffer = _allocator.allocate(_size);
+  size_type done = 0;
+  try {
+    for (size_type k = 0; done < _size; ++k) {
+      const size_type count = std::min(C, _size - done);
+      detail::uninitialized_move_n(_allocator, _chunks[k], count, buffer + done);
+      done += count;
+    }
+  } catch (...) {
+    for (size_type i = 0; i < done; ++i) {
+      _allocator.destroy(buffer + i);
+    }
+    _allocator.deallocate(buffer, _size);
+    throw;
+  }
+  result.adopt(buffer, _size, _size);
+  clear();
+  return result;
+}
+
+template<typename T, typename A, std::size_t C>
+void VectorBuilder<T, A, C>::swap(VectorBuilder& other) noexcept
+{
+  _chunks.swap(other._chunks);
+  std::swap(_size, other._size);
+}
+
+template<typename T, typename A, std::size_t C>
+void VectorBuilder<T, A, C>::clear() noexcept
+{
+  for (size_type i = 0; i < _size; ++i) {
+    _allocator.destroy(slot(i));
+  }
+  for (size_type k = 0; k < _chunks.size(); ++k) {
+    _allocator.deallocate(_chunks[k], C);
+  }
+  _chunks.clear();
+  _size = 0;
+}
+
+template<typename T, typename A, std::size_t C>
+inline typename VectorBuilder<T, A, C>::pointer VectorBuilder<T, A, C>::slot(size_type i) const noexcept
+{
+  return _chunks[i / C] + i % C;
+}
+
+} // namespace ctl